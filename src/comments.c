@@ -241,7 +241,7 @@ comments_to_xml (xmlNodePtr parentNode, const gchar *id)
 	xmlNodePtr	commentsNode;
 	commentFeedPtr	commentFeed;
 	itemSetPtr	itemSet;
-	GList		*iter;
+	guint		i;
 	
 	commentFeed = comment_feed_from_id (id);
 	if (!commentFeed)
@@ -252,13 +252,11 @@ comments_to_xml (xmlNodePtr parentNode, const gchar *id)
 	itemSet = db_itemset_load (id);
 	g_return_if_fail (itemSet != NULL);
 
-	iter = itemSet->ids;
-	while (iter) 
+	for (i = 0; i < itemSet->ids->len; i++)
 	{
-		itemPtr comment = item_load (GPOINTER_TO_UINT (iter->data));
+		itemPtr comment = item_load (g_array_index (itemSet->ids, guint, i));
 		item_to_xml (comment, commentsNode);
 		item_unload (comment);
-		iter = g_list_next (iter);
 	}
 
 	xmlNewTextChild (commentsNode, NULL, "updateState", 
@@ -18,6 +18,7 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <gio/gio.h>
 #include <sqlite3.h>
 #include <stdlib.h>
 #include <string.h>
@@ -29,6 +30,7 @@
 #include "item.h"
 #include "itemset.h"
 #include "metadata.h"
+#include "metrics.h"
 #include "vfolder.h"
 
 /* You can find a schema description used by this version of Liferea at:
@@ -42,6 +44,129 @@ static GHashTable *statements = NULL;
 
 static void db_view_remove (const gchar *id);
 
+/* Asynchronous writer
+
+   Item, item state, subscription and node updates are not executed
+   on the main loop. They are queued as commands holding a copy of
+   all values to be written and are executed in order by a writer
+   thread with its own DB connection. The writer groups all commands
+   queued at a time into a single transaction. Only a VACUUM, which
+   cannot be run in a transaction, is executed on its own.
+
+   As WAL mode allows a reader concurrently to the writer, the main
+   connection serves all queries. Each queued command records keys
+   for the item and the nodes it writes. To read what was written
+   before, a query on the main connection waits only for the queued
+   commands with the key of the item or node it reads. Only queries
+   spanning all nodes wait for the whole queue. To avoid any waits,
+   callers can use db_sync() to be called back once their writes are
+   committed. */
+
+typedef enum {
+	DB_WRITE_ITEM,
+	DB_WRITE_ITEM_STATE,
+	DB_WRITE_SUBSCRIPTION,
+	DB_WRITE_NODE,
+	DB_WRITE_VACUUM,
+	DB_WRITE_SYNC
+} dbWriteType;
+
+typedef struct dbWriteCommand {
+	dbWriteType	type;
+	itemPtr		item;			/**< item copy (item and item state updates) */
+	GSList		*searchFoldersAdd;	/**< ids of the re-checked search folders the item belongs to */
+	GSList		*searchFoldersRemove;	/**< ids of the re-checked search folders the item does not belong to */
+	gchar		*text[4];		/**< string values (subscription and node updates) */
+	gint		value[4];		/**< integer values (subscription and node updates) */
+	GSList		*metadata;		/**< metadata copy (subscription updates) */
+	GSList		*keys;			/**< keys of the written item and nodes */
+	dbSyncCallback	callback;		/**< optional callback after commit */
+	gpointer	user_data;
+} *dbWriteCommandPtr;
+
+#define DB_WRITER_MAX_BATCH	500	/* commands per transaction */
+
+static sqlite3		*writerDb = NULL;	/**< connection owned by the writer thread */
+static GThread		*writerThread = NULL;
+static GAsyncQueue	*writerQueue = NULL;
+static GMutex		writerLock;
+static GCond		writerCommitted;
+static guint		writerPending = 0;	/**< number of queued but not yet committed commands */
+static GHashTable	*writerKeys = NULL;	/**< keys of queued commands (key -> command count) */
+static struct dbWriteCommand writerQuit;	/**< marker to stop the writer thread */
+static gulong		nextItemId = 0;		/**< next free item id, 0 if not yet determined */
+
+static void db_writer_push (dbWriteCommandPtr cmd);
+static void db_writer_start (void);
+static void db_writer_stop (void);
+
+/* Waits until all queued writes are committed */
+static void
+db_writer_flush (void)
+{
+	if (!writerThread || g_thread_self () == writerThread)
+		return;
+
+	g_mutex_lock (&writerLock);
+	if (writerPending > 0) {
+		debug1 (DEBUG_DB, "waiting for %u queued DB writes", writerPending);
+		debug_span_begin ("DB writer flush");
+		debug_span_arg_int ("pending", writerPending);
+		while (writerPending > 0)
+			g_cond_wait (&writerCommitted, &writerLock);
+		debug_span_end ();
+	}
+	g_mutex_unlock (&writerLock);
+}
+
+/* Waits until all queued writes with the given key are committed */
+static void
+db_writer_wait (const gchar *key)
+{
+	if (!writerThread || g_thread_self () == writerThread)
+		return;
+
+	g_mutex_lock (&writerLock);
+	if (g_hash_table_contains (writerKeys, key)) {
+		debug1 (DEBUG_DB, "waiting for queued DB writes of %s", key);
+		debug_span_begin ("DB writer wait");
+		debug_span_arg_str ("key", key);
+		while (g_hash_table_contains (writerKeys, key))
+			g_cond_wait (&writerCommitted, &writerLock);
+		debug_span_end ();
+	}
+	g_mutex_unlock (&writerLock);
+}
+
+/* Returns TRUE while writes are queued */
+static gboolean
+db_writer_busy (void)
+{
+	gboolean busy;
+
+	g_mutex_lock (&writerLock);
+	busy = (writerPending > 0);
+	g_mutex_unlock (&writerLock);
+
+	return busy;
+}
+
+static void
+db_writer_wait_node (const gchar *id)
+{
+	gchar *key = g_strdup_printf ("node:%s", id);
+	db_writer_wait (key);
+	g_free (key);
+}
+
+static void
+db_writer_wait_item (gulong id)
+{
+	gchar *key = g_strdup_printf ("item:%lu", id);
+	db_writer_wait (key);
+	g_free (key);
+}
+
 static void
 db_prepare_stmt (sqlite3_stmt **stmt, const gchar *sql) 
 {
@@ -85,6 +210,32 @@ db_get_statement (const gchar *name)
 	return statement;
 }
 
+/* Prepares a statement on the given connection. Other connections
+   than the main connection are only used by the writer and worker
+   threads. */
+static sqlite3_stmt *
+db_get_statement_for (sqlite3 *conn, const gchar *name)
+{
+	sqlite3_stmt	*statement;
+	gchar		*sql;
+	gint		res;
+
+	if (conn == db)
+		return db_get_statement (name);
+
+	sql = (gchar *) g_hash_table_lookup (statements, name);
+	if (!sql)
+		g_error ("Fatal: unknown prepared statement \"%s\" requested!", name);
+
+	res = sqlite3_prepare_v2 (conn, sql, -1, &statement, NULL);
+	if (SQLITE_OK != res)
+		g_error ("Failure while preparing statement, (error=%d, %s) SQL: \"%s\"", res, sqlite3_errmsg (conn), sql);
+
+	return statement;
+}
+
+#define db_writer_get_statement(name) db_get_statement_for (writerDb, name)
+
 static void
 db_exec (const gchar *sql)
 {
@@ -182,51 +333,432 @@ db_end_transaction (void)
 	sqlite3_free (err);
 }
 
-#define VACUUM_ON_FRAGMENTATION_RATIO	10
+/* Item description compression
+
+   Descriptions larger than DB_DESCRIPTION_COMPRESS_THRESHOLD bytes are
+   stored deflate compressed as BLOB with a 4 byte little-endian header
+   holding the uncompressed length. Smaller descriptions and those that
+   do not compress well are stored as TEXT. The column type tells both
+   apart, so uncompressed rows of older versions stay readable and are
+   compressed by the background maintenance. */
+
+#define DB_DESCRIPTION_COMPRESS_THRESHOLD	512
+#define DB_DESCRIPTION_HEADER_SIZE		4
+
+static guchar *
+db_zlib_convert (GConverter *converter, const guchar *in, gsize inLen, gsize sizeHint, gsize *outLen)
+{
+	GConverterResult	res;
+	GError			*error = NULL;
+	gsize			size = MAX (sizeHint, 256), total = 0, bytesRead, bytesWritten;
+	guchar			*out = g_malloc (size);
+
+	do {
+		res = g_converter_convert (converter, in, inLen, out + total, size - total,
+		                           G_CONVERTER_INPUT_AT_END, &bytesRead, &bytesWritten, &error);
+		if (G_CONVERTER_ERROR == res) {
+			if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NO_SPACE)) {
+				g_clear_error (&error);
+				size *= 2;
+				out = g_realloc (out, size);
+				continue;
+			}
+
+			debug1 (DEBUG_DB, "description (de)compression failed: %s", error->message);
+			g_error_free (error);
+			g_free (out);
+			return NULL;
+		}
+
+		in += bytesRead;
+		inLen -= bytesRead;
+		total += bytesWritten;
+
+		if (total == size) {
+			size *= 2;
+			out = g_realloc (out, size);
+		}
+	} while (G_CONVERTER_FINISHED != res);
+
+	*outLen = total;
+	return out;
+}
+
+/* Returns a newly allocated compressed description or NULL if the
+   description is to be stored uncompressed */
+static guchar *
+db_description_compress (const gchar *description, gsize *len)
+{
+	GConverter	*compressor;
+	guchar		*data, *result;
+	gsize		textLen, dataLen;
+	guint32		header;
+
+	if (!description)
+		return NULL;
+
+	textLen = strlen (description);
+	if (textLen < DB_DESCRIPTION_COMPRESS_THRESHOLD || textLen > G_MAXUINT32)
+		return NULL;
+
+	compressor = G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, -1));
+	data = db_zlib_convert (compressor, (const guchar *)description, textLen, textLen / 2, &dataLen);
+	g_object_unref (compressor);
+
+	if (!data || dataLen + DB_DESCRIPTION_HEADER_SIZE >= textLen) {
+		g_free (data);
+		return NULL;
+	}
+
+	header = GUINT32_TO_LE ((guint32)textLen);
+	result = g_malloc (dataLen + DB_DESCRIPTION_HEADER_SIZE);
+	memcpy (result, &header, DB_DESCRIPTION_HEADER_SIZE);
+	memcpy (result + DB_DESCRIPTION_HEADER_SIZE, data, dataLen);
+	g_free (data);
+
+	*len = dataLen + DB_DESCRIPTION_HEADER_SIZE;
+	return result;
+}
+
+static gchar *
+db_description_decompress (const guchar *blob, gsize len)
+{
+	GConverter	*decompressor;
+	guchar		*text;
+	gsize		textLen;
+	guint32		header;
+
+	if (!blob || len < DB_DESCRIPTION_HEADER_SIZE)
+		return NULL;
+
+	memcpy (&header, blob, DB_DESCRIPTION_HEADER_SIZE);
+
+	/* Allocate one byte more than needed to avoid a realloc on finish */
+	decompressor = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW));
+	text = db_zlib_convert (decompressor, blob + DB_DESCRIPTION_HEADER_SIZE, len - DB_DESCRIPTION_HEADER_SIZE,
+	                        GUINT32_FROM_LE (header) + 1, &textLen);
+	g_object_unref (decompressor);
+
+	if (!text)
+		return NULL;
+
+	text = g_realloc (text, textLen + 1);
+	text[textLen] = 0;
+
+	return (gchar *)text;
+}
 
 static void
-db_vacuum (void)
+db_bind_description (sqlite3_stmt *stmt, gint column, const gchar *description)
+{
+	guchar	*data;
+	gsize	len;
+
+	data = db_description_compress (description, &len);
+	if (data)
+		sqlite3_bind_blob (stmt, column, data, len, g_free);
+	else
+		sqlite3_bind_text (stmt, column, description, -1, SQLITE_TRANSIENT);
+}
+
+void
+db_get_description_stats (guint *rawCount, guint *compressedCount, gint64 *storedSize, gint64 *originalSize)
 {
 	sqlite3_stmt	*stmt;
-	gint		res, page_count, freelist_count;
 
-	/* Determine fragmentation ratio using 
+	*rawCount = *compressedCount = 0;
+	*storedSize = *originalSize = 0;
 
-		PRAGMA page_count
-		PRAGMA freelist_count
+	stmt = db_get_statement ("descriptionRawStatsStmt");
+	if (SQLITE_ROW == sqlite3_step (stmt)) {
+		*rawCount = sqlite3_column_int (stmt, 0);
+		*storedSize = *originalSize = sqlite3_column_int64 (stmt, 1);
+	}
+	sqlite3_finalize (stmt);
 
-	   as suggested by adriatic in this blog post
-	   http://jeff.ecchi.ca/blog/2011/12/24/investigating-lifereas-startup-performance/#comment-19989	
-	   and perform VACUUM only when needed.
-	 */
+	stmt = db_get_statement ("descriptionCompressedStatsStmt");
+	while (SQLITE_ROW == sqlite3_step (stmt)) {
+		guint32 header;
+
+		if (sqlite3_column_bytes (stmt, 0) < DB_DESCRIPTION_HEADER_SIZE)
+			continue;
+
+		memcpy (&header, sqlite3_column_blob (stmt, 0), DB_DESCRIPTION_HEADER_SIZE);
+		(*compressedCount)++;
+		*storedSize += sqlite3_column_int64 (stmt, 1);
+		*originalSize += GUINT32_FROM_LE (header);
+	}
+	sqlite3_finalize (stmt);
+}
+
+/* Maintenance task compressing descriptions stored by older versions */
+static void
+db_description_compress_range (sqlite3_int64 first, sqlite3_int64 last)
+{
+	sqlite3_stmt	*stmt;
+	GSList		*ids = NULL, *iter;
+
+	stmt = db_get_statement ("descriptionUncompressedStmt");
+	sqlite3_bind_int64 (stmt, 1, first);
+	sqlite3_bind_int64 (stmt, 2, last);
+	sqlite3_bind_int (stmt, 3, DB_DESCRIPTION_COMPRESS_THRESHOLD);
+	while (SQLITE_ROW == sqlite3_step (stmt))
+		ids = g_slist_prepend (ids, GINT_TO_POINTER (sqlite3_column_int (stmt, 0)));
+	sqlite3_finalize (stmt);
+
+	if (!ids)
+		return;
+
+	db_begin_transaction ();
+	for (iter = ids; iter; iter = g_slist_next (iter)) {
+		gchar	*description = NULL;
+		guchar	*data;
+		gsize	len;
+
+		stmt = db_get_statement ("descriptionLoadStmt");
+		sqlite3_bind_int (stmt, 1, GPOINTER_TO_INT (iter->data));
+		if (SQLITE_ROW == sqlite3_step (stmt))
+			description = g_strdup ((const gchar *)sqlite3_column_text (stmt, 0));
+		sqlite3_finalize (stmt);
+
+		data = db_description_compress (description, &len);
+		g_free (description);
+		if (!data)
+			continue;
+
+		stmt = db_get_statement ("descriptionUpdateStmt");
+		sqlite3_bind_blob (stmt, 1, data, len, g_free);
+		sqlite3_bind_int (stmt, 2, GPOINTER_TO_INT (iter->data));
+		if (SQLITE_DONE != sqlite3_step (stmt))
+			g_warning ("description compression failed (error code=%d, %s)", sqlite3_errcode (db), sqlite3_errmsg (db));
+		sqlite3_finalize (stmt);
+	}
+	db_end_transaction ();
+
+	g_slist_free (ids);
+}
+
+#define VACUUM_ON_FRAGMENTATION_RATIO	10
+
+static gint
+db_get_pragma_int (const gchar *pragma)
+{
+	sqlite3_stmt	*stmt;
+	gchar		*sql;
+	gint		res, value;
 
-	db_prepare_stmt (&stmt, "PRAGMA page_count");
+	sql = sqlite3_mprintf ("PRAGMA %s", pragma);
+	db_prepare_stmt (&stmt, sql);
 	sqlite3_reset (stmt);
 	res = sqlite3_step (stmt);
 	if (SQLITE_ROW != res) 
-		g_error ("Could not determine page count (error code %d)!", res);
-	page_count = sqlite3_column_int (stmt, 0);
+		g_error ("Could not determine %s (error code %d)!", pragma, res);
+	value = sqlite3_column_int (stmt, 0);
 	sqlite3_finalize (stmt);
+	sqlite3_free (sql);
+
+	return value;
+}
+
+static sqlite3_int64
+db_get_max_rowid (const gchar *table)
+{
+	sqlite3_stmt	*stmt;
+	gchar		*sql;
+	sqlite3_int64	max = 0;
 
-	db_prepare_stmt (&stmt, "PRAGMA freelist_count");
+	sql = sqlite3_mprintf ("SELECT MAX(rowid) FROM %s", table);
+	db_prepare_stmt (&stmt, sql);
 	sqlite3_reset (stmt);
-	res = sqlite3_step (stmt);
-	if (SQLITE_ROW != res) 
-		g_error ("Could not determine free list count (error code %d)!", res);
-	freelist_count = sqlite3_column_int (stmt, 0);
+	if (SQLITE_ROW == sqlite3_step (stmt))
+		max = sqlite3_column_int64 (stmt, 0);
 	sqlite3_finalize (stmt);
+	sqlite3_free (sql);
 
-	float fragmentation = (100 * (float)freelist_count/page_count);
-	if (fragmentation > VACUUM_ON_FRAGMENTATION_RATIO) {
-		debug2 (DEBUG_DB, "Performing VACUUM as freelist count/page count ratio %2.2f > %d", 
-		                  fragmentation, VACUUM_ON_FRAGMENTATION_RATIO);
-		debug_start_measurement (DEBUG_DB);
-		db_exec ("VACUUM;");
-		debug_end_measurement (DEBUG_DB, "VACUUM");
+	return max;
+}
+
+/* Background DB maintenance
+
+   The removal of orphaned rows and returning free pages to the file
+   system are done in small steps while Liferea is idle instead of on
+   every startup. The cleanup tasks walk their table in rowid ranges
+   so that each step has the same cost regardless of the DB size. */
+
+#define DB_MAINTENANCE_DELAY		60	/* seconds after startup */
+#define DB_MAINTENANCE_INTERVAL		250	/* ms between two time slices */
+#define DB_MAINTENANCE_SLICE		20	/* ms per time slice */
+#define DB_MAINTENANCE_CHUNK		1000	/* rowids per cleanup step */
+#define DB_MAINTENANCE_COMPRESS_CHUNK	50	/* rowids per compression step */
+#define DB_MAINTENANCE_VACUUM_PAGES	64	/* pages per incremental vacuum step */
+
+typedef struct dbMaintenanceTask {
+	const gchar	*name;		/**< description for debug output */
+	const gchar	*table;		/**< table to walk in rowid ranges */
+	const gchar	*statement;	/**< cleanup statement, parameters: first and last rowid */
+	void		(*func) (sqlite3_int64 first, sqlite3_int64 last);	/**< alternative to a statement */
+	gint		chunk;		/**< rowids per step */
+} dbMaintenanceTask;
+
+/* Note: do not check on subscriptions here, as non-subscription node
+   types (e.g. news bin) do contain items too. */
+static const dbMaintenanceTask maintenanceTasks[] = {
+	{ "items without a feed list node",		"items",			"maintenanceItemsStmt", NULL, DB_MAINTENANCE_CHUNK },
+	{ "comments without parent item",		"items",			"maintenanceCommentsStmt", NULL, DB_MAINTENANCE_CHUNK },
+	{ "search folder items without a node",		"search_folder_items",		"maintenanceSearchFolderItemsStmt", NULL, DB_MAINTENANCE_CHUNK },
+	{ "subscription metadata without node",		"subscription_metadata",	"maintenanceSubscriptionMetadataStmt", NULL, DB_MAINTENANCE_CHUNK },
+	{ "item descriptions without an item",		"item_content",			"maintenanceItemContentStmt", NULL, DB_MAINTENANCE_CHUNK },
+	{ "uncompressed item descriptions",		"item_content",			NULL, db_description_compress_range, DB_MAINTENANCE_COMPRESS_CHUNK }
+};
+
+static guint		maintenanceTimer = 0;
+static guint		maintenanceTask = 0;		/**< current task, vacuum after the last task */
+static sqlite3_int64	maintenanceRowid = 0;		/**< last processed rowid of the current task */
+static sqlite3_int64	maintenanceMaxRowid = -1;	/**< max rowid of the current task, -1 if not yet determined */
+
+/* Returns FALSE when no more vacuum steps are needed */
+static gboolean
+db_maintenance_vacuum_step (void)
+{
+	gint	page_count, freelist_count;
+	gchar	*sql;
+
+	/* Determine fragmentation ratio using 
+
+		PRAGMA page_count
+		PRAGMA freelist_count
+
+	   as suggested by adriatic in this blog post
+	   http://jeff.ecchi.ca/blog/2011/12/24/investigating-lifereas-startup-performance/#comment-19989	
+	 */
+	page_count = db_get_pragma_int ("page_count");
+	freelist_count = db_get_pragma_int ("freelist_count");
+	if (0 == freelist_count)
+		return FALSE;
+
+	if (2 != db_get_pragma_int ("auto_vacuum")) {
+		/* Older DBs need one full VACUUM to switch to incremental
+		   vacuuming. Do it only when needed. */
+		float fragmentation = (100 * (float)freelist_count/page_count);
+		if (fragmentation > VACUUM_ON_FRAGMENTATION_RATIO) {
+			dbWriteCommandPtr cmd;
+
+			debug2 (DEBUG_DB, "Queuing VACUUM as freelist count/page count ratio %2.2f > %d", 
+			                  fragmentation, VACUUM_ON_FRAGMENTATION_RATIO);
+
+			/* Leave the full VACUUM to the writer thread */
+			cmd = g_new0 (struct dbWriteCommand, 1);
+			cmd->type = DB_WRITE_VACUUM;
+			db_writer_push (cmd);
+		} else {
+			debug2 (DEBUG_DB, "No VACUUM as freelist count/page count ratio %2.2f <= %d", 
+			                  fragmentation, VACUUM_ON_FRAGMENTATION_RATIO);
+		}
+		return FALSE;
+	}
+
+	sql = sqlite3_mprintf ("PRAGMA incremental_vacuum(%d);", DB_MAINTENANCE_VACUUM_PAGES);
+	db_exec (sql);
+	sqlite3_free (sql);
+
+	return TRUE;
+}
+
+/* Returns FALSE when the maintenance is finished */
+static gboolean
+db_maintenance_step (void)
+{
+	const dbMaintenanceTask	*task;
+	sqlite3_stmt		*stmt;
+	gint			res;
+
+	if (maintenanceTask >= G_N_ELEMENTS (maintenanceTasks))
+		return db_maintenance_vacuum_step ();
+
+	task = &maintenanceTasks[maintenanceTask];
+	if (maintenanceMaxRowid < 0) {
+		maintenanceRowid = 0;
+		maintenanceMaxRowid = db_get_max_rowid (task->table);
+		debug1 (DEBUG_DB, "maintenance: checking for %s...", task->name);
+	}
+
+	if (maintenanceRowid >= maintenanceMaxRowid) {
+		maintenanceTask++;
+		maintenanceMaxRowid = -1;
+		return TRUE;
+	}
+
+	if (task->func) {
+		(*task->func) (maintenanceRowid + 1, maintenanceRowid + task->chunk);
 	} else {
-		debug2 (DEBUG_DB, "No VACUUM as freelist count/page count ratio %2.2f <= %d", 
-		                  fragmentation, VACUUM_ON_FRAGMENTATION_RATIO);
+		stmt = db_get_statement (task->statement);
+		sqlite3_bind_int64 (stmt, 1, maintenanceRowid + 1);
+		sqlite3_bind_int64 (stmt, 2, maintenanceRowid + task->chunk);
+		res = sqlite3_step (stmt);
+		if (SQLITE_DONE != res)
+			g_warning ("DB maintenance (%s) failed (error code=%d, %s)", task->name, res, sqlite3_errmsg (db));
+		else if (sqlite3_changes (db) > 0)
+			debug2 (DEBUG_DB, "maintenance: removed %d %s", sqlite3_changes (db), task->name);
+		sqlite3_finalize (stmt);
+	}
+
+	maintenanceRowid += task->chunk;
+
+	return TRUE;
+}
+
+static gboolean
+db_maintenance_run (gpointer user_data)
+{
+	gint64	end = g_get_monotonic_time () + DB_MAINTENANCE_SLICE * 1000;
+
+	/* Leave the DB to the writer while updates are queued */
+	if (db_writer_busy ())
+		return TRUE;
+
+	while (g_get_monotonic_time () < end) {
+		if (!db_maintenance_step ()) {
+			if (debug_level & DEBUG_DB) {
+				guint	rawCount, compressedCount;
+				gint64	storedSize, originalSize;
+
+				db_get_description_stats (&rawCount, &compressedCount, &storedSize, &originalSize);
+				debug4 (DEBUG_DB, "maintenance: %u compressed and %u uncompressed descriptions, %" G_GINT64_FORMAT " of %" G_GINT64_FORMAT " bytes stored",
+				        compressedCount, rawCount, storedSize, originalSize);
+			}
+			debug0 (DEBUG_DB, "maintenance: finished");
+			maintenanceTimer = 0;
+			return FALSE;
+		}
 	}
+
+	return TRUE;
+}
+
+static gboolean
+db_maintenance_start (gpointer user_data)
+{
+	debug0 (DEBUG_DB, "maintenance: starting");
+	maintenanceTask = 0;
+	maintenanceMaxRowid = -1;
+	maintenanceTimer = g_timeout_add_full (G_PRIORITY_LOW, DB_MAINTENANCE_INTERVAL, db_maintenance_run, NULL, NULL);
+
+	return FALSE;
+}
+
+/* Statement counts and latencies for GetStats, installed on all connections */
+static void
+db_profile (void *user_data, const char *sql, sqlite3_uint64 ns)
+{
+	metrics_count (METRIC_DB_STATEMENTS, 1);
+	metrics_record (METRIC_DB_STATEMENT, ns / 1000);
+}
+
+/* All connections (main, writer and readers) open this file */
+static gchar *
+db_get_filename (void)
+{
+	return common_create_data_filename ("liferea.db");
 }
 
 static void
@@ -235,7 +767,7 @@ db_open (void)
 	gchar	*filename;
 	gint	res;
 
-	filename = common_create_data_filename ("liferea.db");
+	filename = db_get_filename ();
 	debug1 (DEBUG_DB, "Opening DB file %s...", filename);
 	res = sqlite3_open_v2 (filename, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
 	if (SQLITE_OK != res)
@@ -243,13 +775,22 @@ db_open (void)
 	g_free (filename);
 
 	sqlite3_extended_result_codes (db, TRUE);
+	sqlite3_busy_timeout (db, 10000);	/* removals might overlap a writer commit */
+	sqlite3_profile (db, db_profile, NULL);
 
+	db_exec("PRAGMA auto_vacuum=INCREMENTAL");	/* only effective for new DBs */
 	db_exec("PRAGMA journal_mode=WAL");
 	db_exec("PRAGMA page_size=32768");
 	db_exec("PRAGMA synchronous=NORMAL");
 }
 
-#define SCHEMA_TARGET_VERSION 10
+#define SCHEMA_TARGET_VERSION 13
+
+static void
+db_log_query_plan (const gchar *name, const gchar *sql, const gchar *plan, gpointer user_data)
+{
+	debug2 (DEBUG_DB, "query plan of %s: %s", name, plan);
+}
 
 /* opening or creation of database */
 void
@@ -260,6 +801,7 @@ db_init (void)
 	debug_enter ("db_init");
 
 	db_open ();
+	debug_startup_phase ("DB open");
 
 	/* create info table/check versioning info */				   
 	debug1 (DEBUG_DB, "current DB schema version: %d", db_get_schema_version ());
@@ -434,14 +976,98 @@ db_init (void)
 
 			searchFolderRebuild = TRUE;
 		}
+
+		if (db_get_schema_version () == 10) {
+			/* 1.12.2 -> 1.12.3 moving item descriptions into a separate
+			   relation so that state queries on items do not have to
+			   page in the large description texts */
+			debug0 (DEBUG_DB, "migrating from schema version 10 to 11 (moving item descriptions)");
+			db_exec ("DROP TRIGGER item_removal;");	/* must not fire when dropping the items below */
+			db_exec ("BEGIN; "
+				 "CREATE TABLE item_content ("
+				 "   item_id		INTEGER,"
+				 "   description	TEXT,"
+				 "   PRIMARY KEY (item_id)"
+				 "); "
+				 "INSERT INTO item_content SELECT item_id, description FROM items WHERE description IS NOT NULL; "
+			         "CREATE TEMPORARY TABLE items_backup("
+			         "   item_id, "
+			         "   parent_item_id, "
+			         "   node_id, "
+			         "   parent_node_id, "
+			         "   title, "
+			         "   read, "
+			         "   updated, "
+			         "   popup, "
+			         "   marked, "
+			         "   source, "
+			         "   source_id, "
+			         "   valid_guid, "
+			         "   date, "
+			         "   comment_feed_id, "
+			         "   comment); "
+			         "INSERT INTO items_backup SELECT item_id, parent_item_id, node_id, parent_node_id, title, read, updated, popup, marked, source, source_id, valid_guid, date, comment_feed_id, comment FROM items; "
+			         "DROP TABLE items; "
+		                 "CREATE TABLE items ("
+		        	 "   item_id		INTEGER,"
+				 "   parent_item_id     INTEGER,"
+		        	 "   node_id		TEXT,"
+				 "   parent_node_id     TEXT,"
+		        	 "   title		TEXT,"
+		        	 "   read		INTEGER,"
+		        	 "   updated		INTEGER,"
+		        	 "   popup		INTEGER,"
+		        	 "   marked		INTEGER,"
+		        	 "   source		TEXT,"
+		        	 "   source_id		TEXT,"
+		        	 "   valid_guid		INTEGER,"
+		        	 "   date		INTEGER,"
+		        	 "   comment_feed_id	TEXT,"
+				 "   comment            INTEGER,"
+				 "   PRIMARY KEY (item_id)"
+		        	 "); "
+			         "INSERT INTO items SELECT * FROM items_backup; "
+			         "DROP TABLE items_backup; "
+			         "REPLACE INTO info (name, value) VALUES ('schemaVersion',11); "
+			         "END;" );
+		}
+
+		if (db_get_schema_version () == 11) {
+			/* 1.12.2 -> 1.12.3 replacing single column indices with
+			   indices matching the query shapes, the new indices are
+			   created with the other indices below */
+			debug0 (DEBUG_DB, "migrating from schema version 11 to 12 (dropping obsolete indices)");
+			db_exec ("BEGIN; "
+			         "DROP INDEX IF EXISTS items_idx3; "
+			         "DROP INDEX IF EXISTS items_idx4; "
+			         "DROP INDEX IF EXISTS metadata_idx; "
+			         "DROP INDEX IF EXISTS subscription_metadata_idx; "
+			         "REPLACE INTO info (name, value) VALUES ('schemaVersion',12); "
+			         "END;" );
+		}
+
+		if (db_get_schema_version () == 12) {
+			/* 1.12.2 -> 1.12.3 search folder counters maintained by triggers */
+			debug0 (DEBUG_DB, "migrating from schema version 12 to 13 (search folder counters)");
+			db_exec ("BEGIN; "
+			         "CREATE TABLE search_folder_counts ("
+			         "   node_id		STRING,"
+			         "   item_count		INTEGER DEFAULT 0,"
+			         "   unread_count	INTEGER DEFAULT 0,"
+			         "   PRIMARY KEY (node_id)"
+			         "); "
+			         "INSERT INTO search_folder_counts (node_id, item_count, unread_count) "
+			         "   SELECT search_folder_items.node_id, COUNT(*), COUNT(CASE WHEN items.read = 0 THEN 1 END) "
+			         "   FROM search_folder_items LEFT JOIN items ON items.item_id = search_folder_items.item_id "
+			         "   GROUP BY search_folder_items.node_id; "
+			         "REPLACE INTO info (name, value) VALUES ('schemaVersion',13); "
+			         "END;" );
+		}
 	}
 
 	if (SCHEMA_TARGET_VERSION != db_get_schema_version ())
 		g_error ("Fatal: DB schema version not up-to-date! Running with --debug-db could give some hints about the problem!");
-	
-	/* Vacuuming... */
-
-	db_vacuum ();
+	debug_startup_phase ("DB schema migration");
 	
 	/* Schema creation */
 		
@@ -462,19 +1088,31 @@ db_init (void)
         	 "   source		TEXT,"
         	 "   source_id		TEXT,"
         	 "   valid_guid		INTEGER,"
-        	 "   description	TEXT,"
         	 "   date		INTEGER,"
         	 "   comment_feed_id	TEXT,"
 		 "   comment            INTEGER,"
 		 "   PRIMARY KEY (item_id)"
         	 ");");
 
+	/* Item descriptions are kept apart from the item state so that
+	   loading item sets and counting unread items stays cheap. */
+	db_exec ("CREATE TABLE item_content ("
+	         "   item_id		INTEGER,"
+	         "   description	TEXT,"
+	         "   PRIMARY KEY (item_id)"
+	         ");");
+
+	/* Note: item_id is the rowid and needs no index. Indices on node_id
+	   are composite so that the per node queries are answered from the
+	   index alone. Keep the query plans in mind when changing statements
+	   (see db_foreach_query_plan() and tests/db.c). */
 	db_exec ("CREATE INDEX items_idx ON items (source_id);");
 	db_exec ("CREATE INDEX items_idx2 ON items (comment_feed_id);");
-	db_exec ("CREATE INDEX items_idx3 ON items (node_id);");
-	db_exec ("CREATE INDEX items_idx4 ON items (item_id);");
 	db_exec ("CREATE INDEX items_idx5 ON items (parent_item_id);");
 	db_exec ("CREATE INDEX items_idx6 ON items (parent_node_id);");
+	db_exec ("CREATE INDEX items_idx7 ON items (node_id, source_id);");
+	db_exec ("CREATE INDEX items_idx8 ON items (node_id, date DESC);");
+	db_exec ("CREATE INDEX items_idx9 ON items (node_id, read) WHERE read = 0;");	/* covers unread counts */
 		
 	db_exec ("CREATE TABLE metadata ("
         	 "   item_id		INTEGER,"
@@ -484,7 +1122,6 @@ db_init (void)
         	 "   PRIMARY KEY (item_id, nr)"
         	 ");");
 
-	db_exec ("CREATE INDEX metadata_idx ON metadata (item_id);");
 		
 	db_exec ("CREATE TABLE subscription ("
         	 "   node_id            STRING,"
@@ -506,7 +1143,6 @@ db_init (void)
 		 "   PRIMARY KEY (node_id, nr)"
 		 ");");
 
-	db_exec ("CREATE INDEX subscription_metadata_idx ON subscription_metadata (node_id);");
 
 	db_exec ("CREATE TABLE node ("
         	 "   node_id		STRING,"
@@ -527,55 +1163,39 @@ db_init (void)
 		 "   PRIMARY KEY (node_id, item_id)"
 		 ");");
 
+	/* for search folder membership lookups and the item removal trigger */
+	db_exec ("CREATE INDEX search_folder_items_idx ON search_folder_items (item_id);");
+
+	/* search folder counters, kept up-to-date by triggers (see below) */
+	db_exec ("CREATE TABLE search_folder_counts ("
+	         "   node_id		STRING,"
+	         "   item_count		INTEGER DEFAULT 0,"
+	         "   unread_count	INTEGER DEFAULT 0,"
+	         "   PRIMARY KEY (node_id)"
+	         ");");
+
 	db_end_transaction ();
 	debug_end_measurement (DEBUG_DB, "table setup");
+	debug_startup_phase ("DB table setup");
 		
 	/* 2. Removing old triggers */
 	db_exec ("DROP TRIGGER item_insert;");
 	db_exec ("DROP TRIGGER item_update;");
 	db_exec ("DROP TRIGGER item_removal;");
 	db_exec ("DROP TRIGGER subscription_removal;");
+	db_exec ("DROP TRIGGER item_read_update;");
+	db_exec ("DROP TRIGGER search_folder_insert;");
+	db_exec ("DROP TRIGGER search_folder_removal;");
 		
-	/* 3. Cleanup of DB */
-
-	/* Note: do not check on subscriptions here, as non-subscription node
-	   types (e.g. news bin) do contain items too. */
-	debug0 (DEBUG_DB, "Checking for items without a feed list node...\n");
-	db_exec ("DELETE FROM items WHERE comment = 0 AND node_id NOT IN "
-        	 "(SELECT node_id FROM node);");
-        	 
-        debug0 (DEBUG_DB, "Checking for comments without parent item...\n");
-	db_exec ("BEGIN; "
-	         "   CREATE TEMP TABLE tmp_id ( id );"
-	         "   INSERT INTO tmp_id SELECT item_id FROM items WHERE comment = 1 AND parent_item_id NOT IN (SELECT item_id FROM items WHERE comment = 0);"
-	         /* limit to 1000 items as it is very slow */
-	         "   DELETE FROM items WHERE item_id IN (SELECT id FROM tmp_id LIMIT 1000);"
-	         "   DROP TABLE tmp_id;"
-		 "END;");
-        
-	debug0 (DEBUG_DB, "Checking for search folder items without a feed list node...\n");
-	db_exec ("DELETE FROM search_folder_items WHERE parent_node_id NOT IN "
-        	 "(SELECT node_id FROM node);");
-
-	debug0 (DEBUG_DB, "Checking for search folder items without a search folder...\n");
-	db_exec ("DELETE FROM search_folder_items WHERE node_id NOT IN "
-        	 "(SELECT node_id FROM node);");
-
-	debug0 (DEBUG_DB, "Checking for search folder with comments...\n");
-	db_exec ("DELETE FROM search_folder_items WHERE comment = 1;");
-
-	debug0 (DEBUG_DB, "Checking for subscription metadata without node...\n");
-	db_exec ("DELETE FROM subscription_metadata WHERE node_id NOT IN "
-          	 "(SELECT node_id FROM node);");
-
-	debug0 (DEBUG_DB, "DB cleanup finished. Continuing startup.");
-		
-	/* 4. Creating triggers (after cleanup so it is not slowed down by triggers) */
+	/* 3. Cleanup of DB is done by the background maintenance */
+
+	/* 4. Creating triggers */
 
 	/* This trigger does explicitely not remove comments! */
 	db_exec ("CREATE TRIGGER item_removal DELETE ON items "
         	 "BEGIN "
 		 "   DELETE FROM metadata WHERE item_id = old.item_id; "
+		 "   DELETE FROM item_content WHERE item_id = old.item_id; "
 		 "   DELETE FROM search_folder_items WHERE item_id = old.item_id; "
         	 "END;");
 		
@@ -586,14 +1206,37 @@ db_init (void)
 		 "   DELETE FROM search_folder_items WHERE parent_node_id = old.node_id; "
         	 "END;");
 
+	/* The search folder counters follow membership and read state
+	   changes. This relies on items never being REPLACEd, as REPLACE
+	   fires no update trigger. */
+	db_exec ("CREATE TRIGGER item_read_update AFTER UPDATE OF read ON items "
+	         "WHEN old.read <> new.read "
+	         "BEGIN "
+	         "   UPDATE search_folder_counts SET unread_count = unread_count + (CASE WHEN new.read = 0 THEN 1 ELSE -1 END) "
+	         "   WHERE node_id IN (SELECT node_id FROM search_folder_items WHERE item_id = new.item_id); "
+	         "END;");
+
+	db_exec ("CREATE TRIGGER search_folder_insert AFTER INSERT ON search_folder_items "
+	         "BEGIN "
+	         "   INSERT OR IGNORE INTO search_folder_counts (node_id) VALUES (new.node_id); "
+	         "   UPDATE search_folder_counts SET item_count = item_count + 1, "
+	         "      unread_count = unread_count + (SELECT COUNT(*) FROM items WHERE item_id = new.item_id AND read = 0) "
+	         "   WHERE node_id = new.node_id; "
+	         "END;");
+
+	db_exec ("CREATE TRIGGER search_folder_removal AFTER DELETE ON search_folder_items "
+	         "BEGIN "
+	         "   UPDATE search_folder_counts SET item_count = item_count - 1, "
+	         "      unread_count = unread_count - (SELECT COUNT(*) FROM items WHERE item_id = old.item_id AND read = 0) "
+	         "   WHERE node_id = old.node_id; "
+	         "END;");
+
 	/* Note: view counting triggers are set up in the view preparation code (see db_view_create()) */		
 	/* prepare statements */
 	
 	db_new_statement ("itemsetLoadStmt",
 	                  "SELECT item_id FROM items WHERE node_id = ?");
 
-	db_new_statement ("itemsetLoadOffsetStmt",
-			  "SELECT item_id FROM items WHERE comment = 0 LIMIT ? OFFSET ?");
 		       
 	db_new_statement ("itemsetReadCountStmt",
 	                  "SELECT COUNT(item_id) FROM items "
@@ -622,7 +1265,6 @@ db_init (void)
 	                  "source,"
 	                  "source_id,"
 	                  "valid_guid,"
-	                  "description,"
 	                  "date,"
 		          "comment_feed_id,"
 		          "comment,"
@@ -632,8 +1274,8 @@ db_init (void)
 			  "parent_node_id "
 	                  " FROM items WHERE item_id = ?");      
 	
-	db_new_statement ("itemUpdateStmt",
-	                  "REPLACE INTO items ("
+	db_new_statement ("itemFindBySourceIdStmt",
+	                  "SELECT "
 	                  "title,"
 	                  "read,"
 	                  "updated,"
@@ -642,26 +1284,88 @@ db_init (void)
 	                  "source,"
 	                  "source_id,"
 	                  "valid_guid,"
-	                  "description,"
 	                  "date,"
 		          "comment_feed_id,"
 		          "comment,"
-	                  "item_id,"
-	                  "parent_item_id,"
-	                  "node_id,"
-	                  "parent_node_id"
-	                  ") values (?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?)");
-			
-	db_new_statement ("itemStateUpdateStmt",
-			  "UPDATE items SET read=?, marked=?, updated=? "
-			  "WHERE item_id=?");
+		          "item_id,"
+			  "parent_item_id, "
+		          "node_id, "
+			  "parent_node_id "
+	                  " FROM items WHERE node_id = ? AND source_id = ? LIMIT 1");
 
-	db_new_statement ("duplicatesFindStmt",
-	                  "SELECT item_id FROM items WHERE source_id = ?");
+	db_new_statement ("itemRangeLoadStmt",
+	                  "SELECT "
+	                  "title,"
+	                  "read,"
+	                  "updated,"
+	                  "popup,"
+	                  "marked,"
+	                  "source,"
+	                  "source_id,"
+	                  "valid_guid,"
+	                  "date,"
+		          "comment_feed_id,"
+		          "comment,"
+		          "item_id,"
+			  "parent_item_id, "
+		          "node_id, "
+			  "parent_node_id "
+	                  " FROM items WHERE item_id BETWEEN ? AND ? AND comment = 0");
+
+	/* Items are updated in place and only inserted if they do not
+	   exist yet, never REPLACEd (see the item_read_update trigger) */
+	db_new_statement ("itemUpdateStmt",
+	                  "UPDATE items SET "
+	                  "title = ?1,"
+	                  "read = ?2,"
+	                  "updated = ?3,"
+	                  "popup = ?4,"
+	                  "marked = ?5,"
+	                  "source = ?6,"
+	                  "source_id = ?7,"
+	                  "valid_guid = ?8,"
+	                  "date = ?9,"
+	                  "comment_feed_id = ?10,"
+	                  "comment = ?11,"
+	                  "parent_item_id = ?13,"
+	                  "node_id = ?14,"
+	                  "parent_node_id = ?15 "
+	                  "WHERE item_id = ?12");
+
+	db_new_statement ("itemInsertStmt",
+	                  "INSERT INTO items ("
+	                  "title,"
+	                  "read,"
+	                  "updated,"
+	                  "popup,"
+	                  "marked,"
+	                  "source,"
+	                  "source_id,"
+	                  "valid_guid,"
+	                  "date,"
+		          "comment_feed_id,"
+		          "comment,"
+	                  "item_id,"
+	                  "parent_item_id,"
+	                  "node_id,"
+	                  "parent_node_id"
+	                  ") values (?,?,?,?,?,?,?,?,?,?,?,?,?,?,?)");
+
+	db_new_statement ("itemContentLoadStmt",
+	                  "SELECT description FROM item_content WHERE item_id = ?");
+
+	db_new_statement ("itemContentUpdateStmt",
+	                  "REPLACE INTO item_content (item_id, description) VALUES (?,?)");
+			
+	db_new_statement ("itemStateUpdateStmt",
+			  "UPDATE items SET read=?, marked=?, updated=? "
+			  "WHERE item_id=?");
+
+	db_new_statement ("duplicatesFindStmt",
+	                  "SELECT item_id FROM items WHERE source_id = ?");
 			 
 	db_new_statement ("duplicateNodesFindStmt",
-	                  "SELECT node_id FROM items WHERE item_id IN "
-			  "(SELECT item_id FROM items WHERE source_id = ?)");
+	                  "SELECT node_id FROM items WHERE source_id = ?");
 		       
 	db_new_statement ("duplicatesMarkReadStmt",
  	                  "UPDATE items SET read = 1, updated = 0 WHERE source_id = ?");
@@ -709,16 +1413,19 @@ db_init (void)
 	                  "REPLACE INTO node (node_id,parent_id,title,type,expanded,view_mode,sort_column,sort_reversed) VALUES (?,?,?,?,?,?,?,?)");
 	                  
 	db_new_statement ("itemUpdateSearchFoldersStmt",
-	                  "REPLACE INTO search_folder_items (node_id, parent_node_id, item_id) VALUES (?,?,?)");
+	                  "INSERT OR IGNORE INTO search_folder_items (node_id, parent_node_id, item_id) VALUES (?,?,?)");
 
 	db_new_statement ("itemRemoveFromSearchFolderStmt",
 	                  "DELETE FROM search_folder_items WHERE node_id =? AND item_id = ?;");
 	                  
+	db_new_statement ("searchFolderItemNodesStmt",
+	                  "SELECT node_id FROM search_folder_items WHERE item_id = ?;");
+
 	db_new_statement ("searchFolderLoadStmt",
 	                  "SELECT item_id FROM search_folder_items WHERE node_id = ?;");
 
-	db_new_statement ("searchFolderCountStmt",
-	                  "SELECT count(item_id) FROM search_folder_items WHERE node_id = ?;");
+	db_new_statement ("searchFolderCountsStmt",
+	                  "SELECT item_count, unread_count FROM search_folder_counts WHERE node_id = ?;");
 
 	db_new_statement ("nodeIdListStmt",
 	                  "SELECT node_id FROM node;");
@@ -726,7 +1433,55 @@ db_init (void)
 	db_new_statement ("nodeRemoveStmt",
 	                  "DELETE FROM node WHERE node_id = ?;");
 			  
+	db_new_statement ("descriptionUncompressedStmt",
+	                  "SELECT item_id FROM item_content WHERE item_id BETWEEN ? AND ? "
+	                  "AND typeof(description) = 'text' AND length(description) >= ?;");
+
+	db_new_statement ("descriptionLoadStmt",
+	                  "SELECT description FROM item_content WHERE item_id = ?;");
+
+	db_new_statement ("descriptionUpdateStmt",
+	                  "UPDATE item_content SET description = ? WHERE item_id = ?;");
+
+	db_new_statement ("descriptionRawStatsStmt",
+	                  "SELECT COUNT(*), TOTAL(length(CAST(description AS BLOB))) FROM item_content "
+	                  "WHERE typeof(description) = 'text';");
+
+	db_new_statement ("descriptionCompressedStatsStmt",
+	                  "SELECT substr(description, 1, 4), length(description) FROM item_content "
+	                  "WHERE typeof(description) = 'blob';");
+
+	db_new_statement ("maintenanceItemsStmt",
+	                  "DELETE FROM items WHERE item_id BETWEEN ? AND ? "
+	                  "AND comment = 0 AND node_id NOT IN (SELECT node_id FROM node);");
+
+	db_new_statement ("maintenanceCommentsStmt",
+	                  "DELETE FROM items WHERE item_id BETWEEN ? AND ? "
+	                  "AND comment = 1 AND NOT EXISTS "
+	                  "(SELECT 1 FROM items AS parent WHERE parent.item_id = items.parent_item_id AND parent.comment = 0);");
+
+	db_new_statement ("maintenanceItemContentStmt",
+	                  "DELETE FROM item_content WHERE item_id BETWEEN ? AND ? "
+	                  "AND NOT EXISTS (SELECT 1 FROM items WHERE items.item_id = item_content.item_id);");
+
+	db_new_statement ("maintenanceSearchFolderItemsStmt",
+	                  "DELETE FROM search_folder_items WHERE rowid BETWEEN ? AND ? "
+	                  "AND (parent_node_id NOT IN (SELECT node_id FROM node) "
+	                  "OR node_id NOT IN (SELECT node_id FROM node));");
+
+	db_new_statement ("maintenanceSubscriptionMetadataStmt",
+	                  "DELETE FROM subscription_metadata WHERE rowid BETWEEN ? AND ? "
+	                  "AND node_id NOT IN (SELECT node_id FROM node);");
+			  
 	g_assert (sqlite3_get_autocommit (db));
+	debug_startup_phase ("DB statement setup");
+
+	if (debug_level & DEBUG_DB)
+		db_foreach_query_plan (db_log_query_plan, NULL);
+
+	db_writer_start ();
+
+	maintenanceTimer = g_timeout_add_seconds (DB_MAINTENANCE_DELAY, db_maintenance_start, NULL);
 	
 	debug_exit ("db_init");
 }
@@ -736,6 +1491,14 @@ db_deinit (void)
 {
 
 	debug_enter ("db_deinit");
+
+	db_writer_stop ();
+	nextItemId = 0;
+
+	if (maintenanceTimer) {
+		g_source_remove (maintenanceTimer);
+		maintenanceTimer = 0;
+	}
 	
 	if (FALSE == sqlite3_get_autocommit (db))
 		g_warning ("Fatal: DB not in auto-commit mode. This is a bug. Data may be lost!");
@@ -753,6 +1516,27 @@ db_deinit (void)
 	debug_exit ("db_deinit");
 }
 
+void
+db_foreach_query_plan (dbQueryPlanFunc func, gpointer user_data)
+{
+	GHashTableIter	iter;
+	gpointer	name, sql;
+
+	g_hash_table_iter_init (&iter, statements);
+	while (g_hash_table_iter_next (&iter, &name, &sql)) {
+		sqlite3_stmt	*stmt;
+		gchar		*explain;
+
+		explain = g_strdup_printf ("EXPLAIN QUERY PLAN %s", (gchar *)sql);
+		db_prepare_stmt (&stmt, explain);
+		sqlite3_reset (stmt);
+		while (SQLITE_ROW == sqlite3_step (stmt))
+			(*func) ((const gchar *)name, (const gchar *)sql, (const gchar *)sqlite3_column_text (stmt, 3), user_data);
+		sqlite3_finalize (stmt);
+		g_free (explain);
+	}
+}
+
 static GSList *
 db_metadata_list_append (GSList *metadata, const char *key, const char *value)
 {
@@ -765,13 +1549,13 @@ db_metadata_list_append (GSList *metadata, const char *key, const char *value)
 }
 
 static GSList *
-db_item_metadata_load(itemPtr item) 
+db_item_metadata_load (sqlite3 *conn, itemPtr item) 
 {
 	GSList		*metadata = NULL;
 	sqlite3_stmt 	*stmt;
 	gint		res;
 
-	stmt = db_get_statement ("metadataLoadStmt");
+	stmt = db_get_statement_for (conn, "metadataLoadStmt");
 	res = sqlite3_bind_int (stmt, 1, item->id);
 	if (SQLITE_OK != res)
 		g_error ("db_item_load_metadata: sqlite bind failed (error code %d)!", res);
@@ -800,14 +1584,14 @@ db_item_metadata_update_cb (const gchar *key,
 	itemPtr		item = (itemPtr)user_data;
 	gint		res;
 
-	stmt = db_get_statement ("metadataUpdateStmt");
+	stmt = db_writer_get_statement ("metadataUpdateStmt");
 	sqlite3_bind_int  (stmt, 1, item->id);
 	sqlite3_bind_int  (stmt, 2, index);
 	sqlite3_bind_text (stmt, 3, key, -1, SQLITE_TRANSIENT);
 	sqlite3_bind_text (stmt, 4, value, -1, SQLITE_TRANSIENT);
 	res = sqlite3_step (stmt);
 	if (SQLITE_DONE != res) 
-		g_warning ("Update in \"metadata\" table failed (error code=%d, %s)", res, sqlite3_errmsg (db));
+		g_warning ("Update in \"metadata\" table failed (error code=%d, %s)", res, sqlite3_errmsg (writerDb));
 
 	sqlite3_finalize (stmt);
 
@@ -822,7 +1606,7 @@ db_item_metadata_update(itemPtr item)
 /* Item structure loading methods */
 
 static itemPtr
-db_load_item_from_columns (sqlite3_stmt *stmt) 
+db_load_item_from_columns (sqlite3 *conn, sqlite3_stmt *stmt) 
 {
 	const gchar	*tmp;
 
@@ -833,13 +1617,13 @@ db_load_item_from_columns (sqlite3_stmt *stmt)
 	item->popupStatus	= sqlite3_column_int (stmt, 3)?TRUE:FALSE;
 	item->flagStatus	= sqlite3_column_int (stmt, 4)?TRUE:FALSE;
 	item->validGuid		= sqlite3_column_int (stmt, 7)?TRUE:FALSE;
-	item->time		= sqlite3_column_int64 (stmt, 9);
-	item->commentFeedId	= g_strdup ((const gchar *) sqlite3_column_text (stmt, 10));
-	item->isComment		= sqlite3_column_int (stmt, 11);
-	item->id		= sqlite3_column_int (stmt, 12);
-	item->parentItemId	= sqlite3_column_int (stmt, 13);
-	item->nodeId		= g_strdup ((const gchar *) sqlite3_column_text (stmt, 14));
-	item->parentNodeId	= g_strdup ((const gchar *) sqlite3_column_text (stmt, 15));
+	item->time		= sqlite3_column_int64 (stmt, 8);
+	item->commentFeedId	= g_strdup ((const gchar *) sqlite3_column_text (stmt, 9));
+	item->isComment		= sqlite3_column_int (stmt, 10);
+	item->id		= sqlite3_column_int (stmt, 11);
+	item->parentItemId	= sqlite3_column_int (stmt, 12);
+	item->nodeId		= g_strdup ((const gchar *) sqlite3_column_text (stmt, 13));
+	item->parentNodeId	= g_strdup ((const gchar *) sqlite3_column_text (stmt, 14));
 
 	item->title		= g_strdup ((const gchar *) sqlite3_column_text(stmt, 0));
 	item->sourceId		= g_strdup ((const gchar *) sqlite3_column_text(stmt, 6));
@@ -847,37 +1631,74 @@ db_load_item_from_columns (sqlite3_stmt *stmt)
 	tmp = (const gchar *) sqlite3_column_text(stmt, 5);
 	if (tmp)
 		item->source = g_strdup (tmp);
-		
-	tmp = (const gchar *) sqlite3_column_text(stmt, 8);
-	if (tmp)
-		item->description = g_strdup (tmp);
-	else
-		item->description = g_strdup ("");
 
-	item->metadata = db_item_metadata_load (item);
+	/* The description is not loaded here, see db_item_load_description() */
+
+	item->metadata = db_item_metadata_load (conn, item);
 
 	return item;
 }
 
+static gchar *
+db_item_content_load (sqlite3 *conn, gulong id)
+{
+	sqlite3_stmt	*stmt;
+	gchar		*description = NULL;
+
+	debug_start_measurement (DEBUG_DB);
+
+	stmt = db_get_statement_for (conn, "itemContentLoadStmt");
+	sqlite3_bind_int (stmt, 1, id);
+
+	if (sqlite3_step (stmt) == SQLITE_ROW) {
+		if (SQLITE_BLOB == sqlite3_column_type (stmt, 0))
+			description = db_description_decompress (sqlite3_column_blob (stmt, 0), sqlite3_column_bytes (stmt, 0));
+		else
+			description = g_strdup ((const gchar *) sqlite3_column_text (stmt, 0));
+	}
+
+	sqlite3_finalize (stmt);
+
+	debug_end_measurement (DEBUG_DB, "item description load");
+
+	if (!description)
+		description = g_strdup ("");
+
+	return description;
+}
+
+gchar *
+db_item_load_description (gulong id)
+{
+	db_writer_wait_item (id);
+	return db_item_content_load (db, id);
+}
+
 itemSetPtr
 db_itemset_load (const gchar *id) 
 {
 	sqlite3_stmt	*stmt;
 	itemSetPtr 	itemSet;
+	GArray		*ids;
 
 	debug1 (DEBUG_DB, "loading itemset for node \"%s\"", id);
-	itemSet = g_new0 (struct itemSet, 1);
-	itemSet->nodeId = (gchar *)id;
+	itemSet = itemset_new (id);
 
+	db_writer_wait_node (id);
 	stmt = db_get_statement ("itemsetLoadStmt");
 	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
 
+	ids = g_array_new (FALSE, FALSE, sizeof (guint));
 	while (sqlite3_step (stmt) == SQLITE_ROW) {
-		itemSet->ids = g_list_append (itemSet->ids, GUINT_TO_POINTER (sqlite3_column_int (stmt, 0)));
+		guint itemId = sqlite3_column_int (stmt, 0);
+		g_array_append_val (ids, itemId);
 	}
 
 	sqlite3_finalize (stmt);
 
+	itemset_add_ids (itemSet, (guint *)ids->data, ids->len);
+	g_array_free (ids, TRUE);
+
 	debug0 (DEBUG_DB, "loading of itemset finished");
 	
 	return itemSet;
@@ -892,11 +1713,12 @@ db_item_load (gulong id)
 	debug1 (DEBUG_DB, "loading item %lu", id);
 	debug_start_measurement (DEBUG_DB);
 	
+	db_writer_wait_item (id);
 	stmt = db_get_statement ("itemLoadStmt");
 	sqlite3_bind_int (stmt, 1, id);
 
 	if (sqlite3_step (stmt) == SQLITE_ROW) {
-		item = db_load_item_from_columns (stmt);
+		item = db_load_item_from_columns (db, stmt);
 		(void) sqlite3_step (stmt);
 	} else {
 		debug1 (DEBUG_DB, "Could not load item with id %lu!", id);
@@ -909,6 +1731,106 @@ db_item_load (gulong id)
 	return item;
 }
 
+itemPtr
+db_item_find_by_source_id (nodePtr node, const gchar *sourceId)
+{
+	sqlite3_stmt	*stmt;
+	itemPtr 	item = NULL;
+
+	debug2 (DEBUG_DB, "looking up item %s in node %s", sourceId, node->id);
+	debug_start_measurement (DEBUG_DB);
+
+	db_writer_wait_node (node->id);
+	stmt = db_get_statement ("itemFindBySourceIdStmt");
+	sqlite3_bind_text (stmt, 1, node->id, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text (stmt, 2, sourceId, -1, SQLITE_TRANSIENT);
+
+	if (sqlite3_step (stmt) == SQLITE_ROW)
+		item = db_load_item_from_columns (db, stmt);
+	else
+		debug2 (DEBUG_DB, "Could not find item %s in node %s!", sourceId, node->id);
+
+	sqlite3_finalize (stmt);
+
+	debug_end_measurement (DEBUG_DB, "item lookup by source id");
+
+	return item;
+}
+
+gulong
+db_item_get_max_id (void)
+{
+	db_writer_flush ();
+	return (gulong)db_get_max_rowid ("items");
+}
+
+/* Read-only connections of worker threads
+
+   Worker threads get their own read-only connection which, thanks
+   to WAL, do not block the main connection or the writer. The
+   connection is closed when the thread exits. */
+
+static void
+db_reader_close (gpointer data)
+{
+	sqlite3 *conn = (sqlite3 *)data;
+
+	if (SQLITE_OK != sqlite3_close (conn))
+		g_warning ("DB reader close failed: %s", sqlite3_errmsg (conn));
+}
+
+static GPrivate readerDb = G_PRIVATE_INIT (db_reader_close);
+
+static sqlite3 *
+db_reader_get (void)
+{
+	sqlite3	*conn = (sqlite3 *)g_private_get (&readerDb);
+	gchar	*filename;
+	gint	res;
+
+	if (conn)
+		return conn;
+
+	filename = db_get_filename ();
+	res = sqlite3_open_v2 (filename, &conn, SQLITE_OPEN_READONLY, NULL);
+	if (SQLITE_OK != res)
+		g_error ("Data base file %s could not be opened for reading (error code %d: %s)...", filename, res, sqlite3_errmsg (conn));
+	g_free (filename);
+
+	sqlite3_busy_timeout (conn, 10000);
+	sqlite3_profile (conn, db_profile, NULL);
+	g_private_set (&readerDb, conn);
+
+	return conn;
+}
+
+GSList *
+db_reader_items_load (gulong first, gulong last)
+{
+	sqlite3		*conn = db_reader_get ();
+	sqlite3_stmt	*stmt;
+	GSList		*items = NULL;
+
+	debug2 (DEBUG_DB, "loading items %lu to %lu", first, last);
+
+	stmt = db_get_statement_for (conn, "itemRangeLoadStmt");
+	sqlite3_bind_int64 (stmt, 1, first);
+	sqlite3_bind_int64 (stmt, 2, last);
+
+	while (sqlite3_step (stmt) == SQLITE_ROW) {
+		itemPtr item = db_load_item_from_columns (conn, stmt);
+
+		/* load the description too as item_get_description()
+		   would use the main connection */
+		item->description = db_item_content_load (conn, item->id);
+		items = g_slist_prepend (items, item);
+	}
+
+	sqlite3_finalize (stmt);
+
+	return g_slist_reverse (items);
+}
+
 /* Item modification methods */
 
 static int
@@ -917,23 +1839,18 @@ db_item_set_id_cb (void *user_data,
 		   char **values,
 		   char **columns) 
 {
-	itemPtr	item = (itemPtr)user_data;
-	
 	g_assert(NULL != values);
 
-	if(values[0]) {
-		/* the result in *values should be MAX(item_id),
-		   so adding one should give a unique new id */
-		item->id = 1 + atol(values[0]); 
-	} else {
-		/* empty table causes no result in values[0]... */
-		item->id = 1;
-	}
-	
-	debug2(DEBUG_DB, "new item id=%lu for \"%s\"", item->id, item->title);
+	/* the result in *values should be MAX(item_id),
+	   so adding one should give a unique new id,
+	   an empty table causes no result in values[0]... */
+	nextItemId = values[0]?(1 + atol(values[0])):1;
+
 	return 0;
 }
 
+/* Item ids are assigned synchronously so that they are known
+   before the insert is executed by the writer */
 static void
 db_item_set_id (itemPtr item) 
 {
@@ -941,88 +1858,141 @@ db_item_set_id (itemPtr item)
 	gint	res;
 	
 	g_assert (0 == item->id);
-	
-	sql = sqlite3_mprintf ("SELECT MAX(item_id) FROM items");
-	res = sqlite3_exec (db, sql, db_item_set_id_cb, item, &err);
-	if (SQLITE_OK != res) 
-		g_warning ("Select failed (%s) SQL: %s", err, sql);
-	sqlite3_free (sql);
-	sqlite3_free (err);
+
+	if (!nextItemId) {
+		db_writer_flush ();
+
+		sql = sqlite3_mprintf ("SELECT MAX(item_id) FROM items");
+		res = sqlite3_exec (db, sql, db_item_set_id_cb, NULL, &err);
+		if (SQLITE_OK != res) 
+			g_warning ("Select failed (%s) SQL: %s", err, sql);
+		sqlite3_free (sql);
+		sqlite3_free (err);
+	}
+
+	item->id = nextItemId++;
+	debug2(DEBUG_DB, "new item id=%lu for \"%s\"", item->id, item->title);
+}
+
+/* Creates a copy of all item fields written to the DB */
+static itemPtr
+db_item_copy (itemPtr item)
+{
+	itemPtr copy = item_new ();
+
+	copy->id		= item->id;
+	copy->readStatus	= item->readStatus;
+	copy->updateStatus	= item->updateStatus;
+	copy->popupStatus	= item->popupStatus;
+	copy->flagStatus	= item->flagStatus;
+	copy->validGuid		= item->validGuid;
+	copy->time		= item->time;
+	copy->isComment		= item->isComment;
+	copy->parentItemId	= item->parentItemId;
+	copy->title		= g_strdup (item->title);
+	copy->source		= g_strdup (item->source);
+	copy->sourceId		= g_strdup (item->sourceId);
+	copy->description	= g_strdup (item->description);
+	copy->commentFeedId	= g_strdup (item->commentFeedId);
+	copy->nodeId		= g_strdup (item->nodeId);
+	copy->parentNodeId	= g_strdup (item->parentNodeId);
+	copy->metadata		= metadata_list_copy (item->metadata);
+
+	return copy;
+}
+
+static GSList *
+db_search_folder_ids (GSList *vfolders)
+{
+	GSList	*ids = NULL, *iter;
+
+	for (iter = vfolders; iter; iter = g_slist_next (iter))
+		ids = g_slist_prepend (ids, g_strdup (((vfolderPtr)iter->data)->node->id));
+	g_slist_free (vfolders);
+
+	return ids;
 }
 
+/* Determines the search folder membership of the item for the writer.
+   Only search folders with rules depending on the changed item
+   properties are checked, all others keep their membership. */
 static void
-db_item_search_folders_update (itemPtr item)
+db_item_search_folders_prepare (dbWriteCommandPtr cmd, itemPtr item, guint changed)
 {
-	sqlite3_stmt	*stmt;
-	gint 		res;
-	GSList		*iter, *list;
+	GSList	*matching, *notMatching;
 
 	/* Bail on comments which are not covered by search folders */
 	if (item->isComment)
 		return;
-	
-	/* Add item to all search folders it now belongs to */
 
-	stmt = db_get_statement ("itemUpdateSearchFoldersStmt");
-	iter = list = vfolder_get_all_with_item_id (item);
-	while (iter) {
-		vfolderPtr vfolder = (vfolderPtr)iter->data;
+	vfolder_check_item (item, changed, &matching, &notMatching);
+	cmd->searchFoldersAdd = db_search_folder_ids (matching);
+	cmd->searchFoldersRemove = db_search_folder_ids (notMatching);
+}
+
+static void
+db_writer_item_search_folders_update (dbWriteCommandPtr cmd)
+{
+	sqlite3_stmt	*stmt;
+	gint 		res;
+	GSList		*iter;
+	GHashTable	*current;
+	itemPtr		item = cmd->item;
+
+	if (!cmd->searchFoldersAdd && !cmd->searchFoldersRemove)
+		return;
+
+	/* Diff against the current membership to write changes only */
+
+	current = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	stmt = db_writer_get_statement ("searchFolderItemNodesStmt");
+	sqlite3_bind_int (stmt, 1, item->id);
+	while (sqlite3_step (stmt) == SQLITE_ROW)
+		g_hash_table_add (current, g_strdup ((const gchar *)sqlite3_column_text (stmt, 0)));
+	sqlite3_finalize (stmt);
+
+	/* Add item to all search folders it newly belongs to */
+
+	stmt = db_writer_get_statement ("itemUpdateSearchFoldersStmt");
+	for (iter = cmd->searchFoldersAdd; iter; iter = g_slist_next (iter)) {
+		if (g_hash_table_contains (current, iter->data))
+			continue;
+
 		sqlite3_reset (stmt);
-		sqlite3_bind_text (stmt, 1, vfolder->node->id, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text (stmt, 1, (gchar *)iter->data, -1, SQLITE_TRANSIENT);
 		sqlite3_bind_text (stmt, 2, item->nodeId, -1, SQLITE_TRANSIENT);
 		sqlite3_bind_int (stmt, 3, item->id);
 		res = sqlite3_step (stmt);
 
 		if (SQLITE_DONE != res) 
-			g_warning ("item add to search folder failed (error code=%d, %s)", res, sqlite3_errmsg (db));
-		iter = g_slist_next (iter);
-
+			g_warning ("item add to search folder failed (error code=%d, %s)", res, sqlite3_errmsg (writerDb));
 	}
-	g_slist_free (list);
-
 	sqlite3_finalize (stmt);
 
-	/* Remove item from all search folders it does not belong
-	   (we do not check if it is in there, just remove it) */
+	/* Remove item from all search folders it no longer belongs to */
+
+	stmt = db_writer_get_statement ("itemRemoveFromSearchFolderStmt");
+	for (iter = cmd->searchFoldersRemove; iter; iter = g_slist_next (iter)) {
+		if (!g_hash_table_contains (current, iter->data))
+			continue;
 
-	stmt = db_get_statement ("itemRemoveFromSearchFolderStmt");
-	iter = list = vfolder_get_all_without_item_id (item);
-	while (iter) {
-		vfolderPtr vfolder = (vfolderPtr)iter->data;
 		sqlite3_reset (stmt);
-		sqlite3_bind_text (stmt, 1, vfolder->node->id, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text (stmt, 1, (gchar *)iter->data, -1, SQLITE_TRANSIENT);
 		sqlite3_bind_int (stmt, 2, item->id);
 		res = sqlite3_step (stmt);
 
 		if (SQLITE_DONE != res) 
-			g_warning ("item remove from search folder failed (error code=%d, %s)", res, sqlite3_errmsg (db));
-		iter = g_slist_next (iter);
-
+			g_warning ("item remove from search folder failed (error code=%d, %s)", res, sqlite3_errmsg (writerDb));
 	}
-	g_slist_free (list);
-
 	sqlite3_finalize (stmt);
+
+	g_hash_table_destroy (current);
 }
 
-void
-db_item_update (itemPtr item) 
+/* Binds the item columns for itemUpdateStmt and itemInsertStmt */
+static void
+db_bind_item (sqlite3_stmt *stmt, itemPtr item)
 {
-	sqlite3_stmt	*stmt;
-	gint		res;
-	
-	debug2 (DEBUG_DB, "update of item \"%s\" (id=%lu)", item->title, item->id);
-	debug_start_measurement (DEBUG_DB);
-	
-	db_begin_transaction ();
-
-	if (!item->id) {
-		db_item_set_id (item);
-
-		debug1(DEBUG_DB, "insert into table \"items\": \"%s\"", item->title);	
-	}
-
-	/* Update the item... */
-	stmt = db_get_statement ("itemUpdateStmt");
 	sqlite3_bind_text (stmt, 1,  item->title, -1, SQLITE_TRANSIENT);
 	sqlite3_bind_int  (stmt, 2,  item->readStatus?1:0);
 	sqlite3_bind_int  (stmt, 3,  item->updateStatus?1:0);
@@ -1031,57 +2001,116 @@ db_item_update (itemPtr item)
 	sqlite3_bind_text (stmt, 6,  item->source, -1, SQLITE_TRANSIENT);
 	sqlite3_bind_text (stmt, 7,  item->sourceId, -1, SQLITE_TRANSIENT);
 	sqlite3_bind_int  (stmt, 8,  item->validGuid?1:0);
-	sqlite3_bind_text (stmt, 9,  item->description, -1, SQLITE_TRANSIENT);
-	sqlite3_bind_int64  (stmt, 10, item->time);
-	sqlite3_bind_text (stmt, 11, item->commentFeedId, -1, SQLITE_TRANSIENT);
-	sqlite3_bind_int  (stmt, 12, item->isComment?1:0);
-	sqlite3_bind_int  (stmt, 13, item->id);
-	sqlite3_bind_int  (stmt, 14, item->parentItemId);
-	sqlite3_bind_text (stmt, 15, item->nodeId, -1, SQLITE_TRANSIENT);
-	sqlite3_bind_text (stmt, 16, item->parentNodeId, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int64  (stmt, 9, item->time);
+	sqlite3_bind_text (stmt, 10, item->commentFeedId, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int  (stmt, 11, item->isComment?1:0);
+	sqlite3_bind_int  (stmt, 12, item->id);
+	sqlite3_bind_int  (stmt, 13, item->parentItemId);
+	sqlite3_bind_text (stmt, 14, item->nodeId, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text (stmt, 15, item->parentNodeId, -1, SQLITE_TRANSIENT);
+}
+
+static void
+db_writer_item_update (dbWriteCommandPtr cmd)
+{
+	sqlite3_stmt	*stmt;
+	gint		res;
+	itemPtr		item = cmd->item;
 
+	/* Update the item or insert it if it is new... */
+	stmt = db_writer_get_statement ("itemUpdateStmt");
+	db_bind_item (stmt, item);
 	res = sqlite3_step (stmt);
+	sqlite3_finalize (stmt);
+
+	if (SQLITE_DONE == res && 0 == sqlite3_changes (writerDb)) {
+		stmt = db_writer_get_statement ("itemInsertStmt");
+		db_bind_item (stmt, item);
+		res = sqlite3_step (stmt);
+		sqlite3_finalize (stmt);
+	}
 
 	if (SQLITE_DONE != res) 
-		g_warning ("item update failed (error code=%d, %s)", res, sqlite3_errmsg (db));
+		g_warning ("item update failed (error code=%d, %s)", res, sqlite3_errmsg (writerDb));
 
-	sqlite3_finalize (stmt);
+	/* ...and its description, unless it was never loaded */
+	if (item->description) {
+		stmt = db_writer_get_statement ("itemContentUpdateStmt");
+		sqlite3_bind_int  (stmt, 1, item->id);
+		db_bind_description (stmt, 2, item->description);
 
-	db_item_metadata_update (item);
-	db_item_search_folders_update (item);
+		res = sqlite3_step (stmt);
 
-	db_end_transaction ();
+		if (SQLITE_DONE != res) 
+			g_warning ("item content update failed (error code=%d, %s)", res, sqlite3_errmsg (writerDb));
+
+		sqlite3_finalize (stmt);
+	}
 
-	debug_end_measurement (DEBUG_DB, "item update");
+	db_item_metadata_update (item);
+	db_writer_item_search_folders_update (cmd);
 }
 
-void
-db_item_state_update (itemPtr item)
+static void
+db_writer_item_state_update (dbWriteCommandPtr cmd)
 {
 	sqlite3_stmt	*stmt;
-	
-	if (!item->id) {
-		db_item_update (item);
-		return;
-	}
+	itemPtr		item = cmd->item;
 
-	db_item_search_folders_update (item);
+	db_writer_item_search_folders_update (cmd);
 
-	debug_start_measurement (DEBUG_DB);
-	
-	stmt = db_get_statement ("itemStateUpdateStmt");
+	stmt = db_writer_get_statement ("itemStateUpdateStmt");
 	sqlite3_bind_int (stmt, 1, item->readStatus?1:0);
 	sqlite3_bind_int (stmt, 2, item->flagStatus?1:0);
 	sqlite3_bind_int (stmt, 3, item->updateStatus?1:0);
 	sqlite3_bind_int (stmt, 4, item->id);
 
 	if (sqlite3_step (stmt) != SQLITE_DONE) 
-		g_warning ("item state update failed (%s)", sqlite3_errmsg (db));
+		g_warning ("item state update failed (%s)", sqlite3_errmsg (writerDb));
 	
 	sqlite3_finalize (stmt);
+}
 
-	debug_end_measurement (DEBUG_DB, "item state update");
+void
+db_item_update (itemPtr item) 
+{
+	dbWriteCommandPtr	cmd;
 
+	debug2 (DEBUG_DB, "update of item \"%s\" (id=%lu)", item->title, item->id);
+
+	if (!item->id) {
+		db_item_set_id (item);
+
+		debug1(DEBUG_DB, "insert into table \"items\": \"%s\"", item->title);	
+	}
+
+	cmd = g_new0 (struct dbWriteCommand, 1);
+	cmd->type = DB_WRITE_ITEM;
+	cmd->item = db_item_copy (item);
+	db_item_search_folders_prepare (cmd, item, RULE_DEPENDS_ALL);
+	db_writer_push (cmd);
+}
+
+void
+db_item_state_update (itemPtr item, guint changed)
+{
+	dbWriteCommandPtr	cmd;
+	
+	if (!item->id) {
+		db_item_update (item);
+		return;
+	}
+
+	cmd = g_new0 (struct dbWriteCommand, 1);
+	cmd->type = DB_WRITE_ITEM_STATE;
+	cmd->item = item_new ();
+	cmd->item->id = item->id;
+	cmd->item->readStatus = item->readStatus;
+	cmd->item->flagStatus = item->flagStatus;
+	cmd->item->updateStatus = item->updateStatus;
+	cmd->item->nodeId = g_strdup (item->nodeId);
+	db_item_search_folders_prepare (cmd, item, changed);
+	db_writer_push (cmd);
 }
 
 void
@@ -1092,6 +2121,7 @@ db_item_remove (gulong id)
 	
 	debug1 (DEBUG_DB, "removing item with id %lu", id);
 	
+	db_writer_wait_item (id);
 	stmt = db_get_statement ("itemsetRemoveStmt");
 	sqlite3_bind_int (stmt, 1, id);
 	sqlite3_bind_int (stmt, 2, id);
@@ -1112,6 +2142,7 @@ db_item_get_duplicates (const gchar *guid)
 
 	debug_start_measurement (DEBUG_DB);
 
+	db_writer_flush ();
 	stmt = db_get_statement ("duplicatesFindStmt");
 	res = sqlite3_bind_text (stmt, 1, guid, -1, SQLITE_TRANSIENT);
 	if (SQLITE_OK != res)
@@ -1139,6 +2170,7 @@ db_item_get_duplicate_nodes (const gchar *guid)
 
 	debug_start_measurement (DEBUG_DB);
 
+	db_writer_flush ();
 	stmt = db_get_statement ("duplicateNodesFindStmt");
 	res = sqlite3_bind_text (stmt, 1, guid, -1, SQLITE_TRANSIENT);
 	if (SQLITE_OK != res)
@@ -1165,6 +2197,7 @@ db_itemset_remove_all (const gchar *id)
 	
 	debug1(DEBUG_DB, "removing all items for item set with %s", id);
 		
+	db_writer_wait_node (id);
 	stmt = db_get_statement ("itemsetRemoveAllStmt");
 	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
 	sqlite3_bind_text (stmt, 2, id, -1, SQLITE_TRANSIENT);
@@ -1185,6 +2218,7 @@ db_itemset_mark_all_popup (const gchar *id)
 	
 	debug1 (DEBUG_DB, "marking all items popup for item set with %s", id);
 		
+	db_writer_wait_node (id);
 	stmt = db_get_statement ("itemsetMarkAllPopupStmt");
 	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
 	res = sqlite3_step (stmt);
@@ -1196,28 +2230,6 @@ db_itemset_mark_all_popup (const gchar *id)
 
 }
 
-gboolean
-db_itemset_get (itemSetPtr itemSet, gulong offset, guint limit)
-{
-	sqlite3_stmt	*stmt;
-	gboolean	success = FALSE;
-
-	debug2 (DEBUG_DB, "loading %d items offset %lu", limit, offset);
-
-	stmt = db_get_statement ("itemsetLoadOffsetStmt");
-	sqlite3_bind_int (stmt, 1, limit);
-	sqlite3_bind_int (stmt, 2, offset);
-
-	while (sqlite3_step (stmt) == SQLITE_ROW) {
-		itemSet->ids = g_list_append (itemSet->ids, GUINT_TO_POINTER (sqlite3_column_int (stmt, 0)));
-		success = TRUE;
-	}
-
-	sqlite3_finalize (stmt);
-
-	return success;
-}
-
 /* Statistics interface */
 
 guint 
@@ -1229,6 +2241,7 @@ db_itemset_get_unread_count (const gchar *id)
 	
 	debug_start_measurement (DEBUG_DB);
 	
+	db_writer_wait_node (id);
 	stmt = db_get_statement ("itemsetReadCountStmt");
 	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
 	res = sqlite3_step (stmt);
@@ -1254,6 +2267,7 @@ db_itemset_get_item_count (const gchar *id)
 
 	debug_start_measurement (DEBUG_DB);
 	
+	db_writer_wait_node (id);
 	stmt = db_get_statement ("itemsetItemCountStmt");
 	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
 	res = sqlite3_step (stmt);
@@ -1348,24 +2362,30 @@ db_search_folder_load (const gchar *id)
 	gint		res;
 	sqlite3_stmt	*stmt;
 	itemSetPtr 	itemSet;
+	GArray		*ids;
 
 	debug1 (DEBUG_DB, "loading search folder node \"%s\"", id);
 
+	db_writer_wait_node (id);
 	stmt = db_get_statement ("searchFolderLoadStmt");
 	res = sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
 	if (SQLITE_OK != res)
 		g_error ("db_search_folder_load: sqlite bind failed (error code %d)!", res);
 	
-	itemSet = g_new0 (struct itemSet, 1);
-	itemSet->nodeId = (gchar *)id;
+	itemSet = itemset_new (id);
 
+	ids = g_array_new (FALSE, FALSE, sizeof (guint));
 	while (sqlite3_step (stmt) == SQLITE_ROW) {
-		itemSet->ids = g_list_append (itemSet->ids, GUINT_TO_POINTER (sqlite3_column_int (stmt, 0)));
+		guint itemId = sqlite3_column_int (stmt, 0);
+		g_array_append_val (ids, itemId);
 	}
 	
 	sqlite3_finalize (stmt);
 
-	debug1 (DEBUG_DB, "loading search folder finished (%d items)", g_list_length (itemSet->ids));
+	itemset_add_ids (itemSet, (guint *)ids->data, ids->len);
+	g_array_free (ids, TRUE);
+
+	debug1 (DEBUG_DB, "loading search folder finished (%u items)", itemSet->ids->len);
 
 	return itemSet;
 }
@@ -1378,7 +2398,10 @@ db_search_folder_reset (const gchar *id)
 
 	debug1 (DEBUG_DB, "resetting search folder node \"%s\"", id);
 	
-	sql = sqlite3_mprintf ("DELETE FROM search_folder_items WHERE node_id = '%s';", id);
+	db_writer_wait_node (id);
+
+	sql = sqlite3_mprintf ("DELETE FROM search_folder_items WHERE node_id = '%q'; "
+	                       "DELETE FROM search_folder_counts WHERE node_id = '%q';", id, id);
 	res = sqlite3_exec (db, sql, NULL, NULL, &err);
 	if (SQLITE_OK != res)
 		g_warning ("resetting search folder failed (%s) SQL: %s", err, sql);
@@ -1398,6 +2421,7 @@ db_search_folder_add_items (const gchar *id, GSList *items)
 
 	debug2 (DEBUG_DB, "add %d items to search folder node \"%s\"", g_slist_length (items), id);
 
+	db_writer_flush ();
 	stmt = db_get_statement ("itemUpdateSearchFoldersStmt");
 	
 	iter = items;
@@ -1421,29 +2445,29 @@ db_search_folder_add_items (const gchar *id, GSList *items)
 	debug0 (DEBUG_DB, "adding items to search folder finished");
 }
 
-guint 
-db_search_folder_get_item_count (const gchar *id) 
+void
+db_search_folder_get_counts (const gchar *id, guint *itemCount, guint *unreadCount)
 {
 	sqlite3_stmt	*stmt;
 	gint		res;
-	guint		count = 0;
-	
-	debug_start_measurement (DEBUG_DB);
-	
-	stmt = db_get_statement ("searchFolderCountStmt");
+
+	*itemCount = 0;
+	*unreadCount = 0;
+
+	db_writer_wait_node (id);
+	stmt = db_get_statement ("searchFolderCountsStmt");
 	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
 	res = sqlite3_step (stmt);
-	
-	if (SQLITE_ROW == res)
-		count = sqlite3_column_int (stmt, 0);
-	else
-		g_warning("item read counting failed (error code=%d, %s)", res, sqlite3_errmsg (db));
-		
-	sqlite3_finalize (stmt);
 
-	debug_end_measurement (DEBUG_DB, "counting unread items");
+	/* No row means the search folder has no items yet */
+	if (SQLITE_ROW == res) {
+		*itemCount = sqlite3_column_int (stmt, 0);
+		*unreadCount = sqlite3_column_int (stmt, 1);
+	} else if (SQLITE_DONE != res) {
+		g_warning ("search folder counting failed (error code=%d, %s)", res, sqlite3_errmsg (db));
+	}
 
-	return count;
+	sqlite3_finalize (stmt);
 }
 
 static GSList *
@@ -1453,6 +2477,7 @@ db_subscription_metadata_load (const gchar *id)
 	sqlite3_stmt	*stmt;
 	gint		res;
 
+	db_writer_wait_node (id);
 	stmt = db_get_statement ("subscriptionMetadataLoadStmt");
 	res = sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
 	if (SQLITE_OK != res)
@@ -1475,63 +2500,73 @@ db_subscription_metadata_update_cb (const gchar *key,
                                     gpointer user_data) 
 {
 	sqlite3_stmt	*stmt;
-	nodePtr		node = (nodePtr)user_data;
+	const gchar	*nodeId = (const gchar *)user_data;
 	gint		res;
 
-	stmt = db_get_statement ("subscriptionMetadataUpdateStmt");
-	sqlite3_bind_text (stmt, 1, node->id, -1, SQLITE_TRANSIENT);
+	stmt = db_writer_get_statement ("subscriptionMetadataUpdateStmt");
+	sqlite3_bind_text (stmt, 1, nodeId, -1, SQLITE_TRANSIENT);
 	sqlite3_bind_int  (stmt, 2, index);
 	sqlite3_bind_text (stmt, 3, key, -1, SQLITE_TRANSIENT);
 	sqlite3_bind_text (stmt, 4, value, -1, SQLITE_TRANSIENT);
 	res = sqlite3_step (stmt);
 	if (SQLITE_DONE != res) 
-		g_warning ("Update in \"subscription_metadata\" table failed (error code=%d, %s)", res, sqlite3_errmsg (db));
+		g_warning ("Update in \"subscription_metadata\" table failed (error code=%d, %s)", res, sqlite3_errmsg (writerDb));
 
 	sqlite3_finalize (stmt);
 }
 
-static void
-db_subscription_metadata_update (subscriptionPtr subscription) 
-{
-	metadata_list_foreach (subscription->metadata, db_subscription_metadata_update_cb, subscription->node);
-}
-
 void
 db_subscription_load (subscriptionPtr subscription)
 {
 	subscription->metadata = db_subscription_metadata_load (subscription->node->id);
 }
 
-void
-db_subscription_update (subscriptionPtr subscription)
+static void
+db_writer_subscription_update (dbWriteCommandPtr cmd)
 {
 	sqlite3_stmt	*stmt;
 	gint		res;
 	
-	debug1 (DEBUG_DB, "updating subscription info %s", subscription->node->id);
-	debug_start_measurement (DEBUG_DB);
-	
-	stmt = db_get_statement ("subscriptionUpdateStmt");
-	sqlite3_bind_text (stmt, 1, subscription->node->id, -1, SQLITE_TRANSIENT);
-	sqlite3_bind_text (stmt, 2, subscription->source, -1, SQLITE_TRANSIENT);
-	sqlite3_bind_text (stmt, 3, subscription->origSource, -1, SQLITE_TRANSIENT);	
-	sqlite3_bind_text (stmt, 4, subscription->filtercmd, -1, SQLITE_TRANSIENT);
-	sqlite3_bind_int  (stmt, 5, subscription->updateInterval);
-	sqlite3_bind_int  (stmt, 6, subscription->defaultInterval);
-	sqlite3_bind_int  (stmt, 7, subscription->discontinued?1:0);
-	sqlite3_bind_int  (stmt, 8, (subscription->updateError ||
-	                             subscription->httpError ||
-				     subscription->filterError)?1:0);
+	stmt = db_writer_get_statement ("subscriptionUpdateStmt");
+	sqlite3_bind_text (stmt, 1, cmd->text[0], -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text (stmt, 2, cmd->text[1], -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text (stmt, 3, cmd->text[2], -1, SQLITE_TRANSIENT);	
+	sqlite3_bind_text (stmt, 4, cmd->text[3], -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int  (stmt, 5, cmd->value[0]);
+	sqlite3_bind_int  (stmt, 6, cmd->value[1]);
+	sqlite3_bind_int  (stmt, 7, cmd->value[2]);
+	sqlite3_bind_int  (stmt, 8, cmd->value[3]);
 	
 	res = sqlite3_step (stmt);
 	if (SQLITE_DONE != res)
-		g_warning ("Could not update subscription info for node id %s in DB (error code %d)!", subscription->node->id, res);
+		g_warning ("Could not update subscription info for node id %s in DB (error code %d)!", cmd->text[0], res);
 	
 	sqlite3_finalize (stmt);
 
-	db_subscription_metadata_update (subscription);
-		
-	debug_end_measurement (DEBUG_DB, "subscription update");
+	metadata_list_foreach (cmd->metadata, db_subscription_metadata_update_cb, cmd->text[0]);
+}
+
+void
+db_subscription_update (subscriptionPtr subscription)
+{
+	dbWriteCommandPtr	cmd;
+	
+	debug1 (DEBUG_DB, "updating subscription info %s", subscription->node->id);
+
+	cmd = g_new0 (struct dbWriteCommand, 1);
+	cmd->type = DB_WRITE_SUBSCRIPTION;
+	cmd->text[0] = g_strdup (subscription->node->id);
+	cmd->text[1] = g_strdup (subscription->source);
+	cmd->text[2] = g_strdup (subscription->origSource);
+	cmd->text[3] = g_strdup (subscription->filtercmd);
+	cmd->value[0] = subscription->updateInterval;
+	cmd->value[1] = subscription->defaultInterval;
+	cmd->value[2] = subscription->discontinued?1:0;
+	cmd->value[3] = (subscription->updateError ||
+	                 subscription->httpError ||
+	                 subscription->filterError)?1:0;
+	cmd->metadata = metadata_list_copy (subscription->metadata);
+	db_writer_push (cmd);
 }
 
 void
@@ -1543,6 +2578,7 @@ db_subscription_remove (const gchar *id)
 	debug1 (DEBUG_DB, "removing subscription %s", id);
 	debug_start_measurement (DEBUG_DB);
 	
+	db_writer_wait_node (id);
 	stmt = db_get_statement ("subscriptionRemoveStmt");
 	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
 
@@ -1555,32 +2591,360 @@ db_subscription_remove (const gchar *id)
 	debug_end_measurement (DEBUG_DB, "subscription remove");
 }
 
-void
-db_node_update (nodePtr node)
+static void
+db_writer_node_update (dbWriteCommandPtr cmd)
 {
 	sqlite3_stmt	*stmt;
 	gint		res;
 	
-	debug1 (DEBUG_DB, "updating node info %s", node->id);
-	debug_start_measurement (DEBUG_DB);
-	
-	stmt = db_get_statement ("nodeUpdateStmt");
-	sqlite3_bind_text (stmt, 1, node->id, -1, SQLITE_TRANSIENT);
-	sqlite3_bind_text (stmt, 2, node->parent->id, -1, SQLITE_TRANSIENT);
-	sqlite3_bind_text (stmt, 3, node->title, -1, SQLITE_TRANSIENT);	
-	sqlite3_bind_text (stmt, 4, node_type_to_str (node), -1, SQLITE_TRANSIENT);
-	sqlite3_bind_int  (stmt, 5, node->expanded?1:0);
-	sqlite3_bind_int  (stmt, 6, node->viewMode);
-	sqlite3_bind_int  (stmt, 7, node->sortColumn);
-	sqlite3_bind_int  (stmt, 8, node->sortReversed?1:0);
+	stmt = db_writer_get_statement ("nodeUpdateStmt");
+	sqlite3_bind_text (stmt, 1, cmd->text[0], -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text (stmt, 2, cmd->text[1], -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text (stmt, 3, cmd->text[2], -1, SQLITE_TRANSIENT);	
+	sqlite3_bind_text (stmt, 4, cmd->text[3], -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int  (stmt, 5, cmd->value[0]);
+	sqlite3_bind_int  (stmt, 6, cmd->value[1]);
+	sqlite3_bind_int  (stmt, 7, cmd->value[2]);
+	sqlite3_bind_int  (stmt, 8, cmd->value[3]);
 	
 	res = sqlite3_step (stmt);
 	if (SQLITE_DONE != res)
-		g_warning ("Could not update node info %s in DB (error code %d)!", node->id, res);
+		g_warning ("Could not update node info %s in DB (error code %d)!", cmd->text[0], res);
 
 	sqlite3_finalize (stmt);
-		
-	debug_end_measurement (DEBUG_DB, "node update");
+}
+
+void
+db_node_update (nodePtr node)
+{
+	dbWriteCommandPtr	cmd;
+	
+	debug1 (DEBUG_DB, "updating node info %s", node->id);
+
+	cmd = g_new0 (struct dbWriteCommand, 1);
+	cmd->type = DB_WRITE_NODE;
+	cmd->text[0] = g_strdup (node->id);
+	cmd->text[1] = g_strdup (node->parent->id);
+	cmd->text[2] = g_strdup (node->title);
+	cmd->text[3] = g_strdup (node_type_to_str (node));
+	cmd->value[0] = node->expanded?1:0;
+	cmd->value[1] = node->viewMode;
+	cmd->value[2] = node->sortColumn;
+	cmd->value[3] = node->sortReversed?1:0;
+	db_writer_push (cmd);
+}
+
+/* Writer thread */
+
+static void
+db_writer_command_free (dbWriteCommandPtr cmd)
+{
+	guint	i;
+
+	if (cmd->item)
+		item_unload (cmd->item);
+	g_slist_free_full (cmd->searchFoldersAdd, g_free);
+	g_slist_free_full (cmd->searchFoldersRemove, g_free);
+	for (i = 0; i < G_N_ELEMENTS (cmd->text); i++)
+		g_free (cmd->text[i]);
+	metadata_list_free (cmd->metadata);
+	g_slist_free_full (cmd->keys, g_free);
+	g_free (cmd);
+}
+
+static void
+db_writer_command_add_key (dbWriteCommandPtr cmd, gchar *key)
+{
+	guint count = GPOINTER_TO_UINT (g_hash_table_lookup (writerKeys, key));
+
+	g_hash_table_insert (writerKeys, g_strdup (key), GUINT_TO_POINTER (count + 1));
+	cmd->keys = g_slist_prepend (cmd->keys, key);
+}
+
+/* Registers the keys of a command, to be called with the writer lock held */
+static void
+db_writer_command_add_keys (dbWriteCommandPtr cmd)
+{
+	GSList	*iter;
+
+	switch (cmd->type) {
+		case DB_WRITE_ITEM:
+		case DB_WRITE_ITEM_STATE:
+			db_writer_command_add_key (cmd, g_strdup_printf ("item:%lu", cmd->item->id));
+			if (cmd->item->nodeId)
+				db_writer_command_add_key (cmd, g_strdup_printf ("node:%s", cmd->item->nodeId));
+			for (iter = cmd->searchFoldersAdd; iter; iter = g_slist_next (iter))
+				db_writer_command_add_key (cmd, g_strdup_printf ("node:%s", (gchar *)iter->data));
+			for (iter = cmd->searchFoldersRemove; iter; iter = g_slist_next (iter))
+				db_writer_command_add_key (cmd, g_strdup_printf ("node:%s", (gchar *)iter->data));
+			break;
+		case DB_WRITE_SUBSCRIPTION:
+		case DB_WRITE_NODE:
+			db_writer_command_add_key (cmd, g_strdup_printf ("node:%s", cmd->text[0]));
+			break;
+		case DB_WRITE_VACUUM:
+		case DB_WRITE_SYNC:
+			break;
+	}
+}
+
+/* Drops the keys of a committed command, to be called with the writer lock held */
+static void
+db_writer_command_remove_keys (dbWriteCommandPtr cmd)
+{
+	GSList	*iter;
+
+	for (iter = cmd->keys; iter; iter = g_slist_next (iter)) {
+		guint count = GPOINTER_TO_UINT (g_hash_table_lookup (writerKeys, iter->data));
+
+		if (count > 1)
+			g_hash_table_insert (writerKeys, g_strdup (iter->data), GUINT_TO_POINTER (count - 1));
+		else
+			g_hash_table_remove (writerKeys, iter->data);
+	}
+}
+
+static void
+db_writer_push (dbWriteCommandPtr cmd)
+{
+	if (!writerThread) {
+		g_warning ("DB writer not running, dropping update!");
+		db_writer_command_free (cmd);
+		return;
+	}
+
+	g_mutex_lock (&writerLock);
+	writerPending++;
+	db_writer_command_add_keys (cmd);
+	g_mutex_unlock (&writerLock);
+
+	g_async_queue_push (writerQueue, cmd);
+}
+
+static gboolean
+db_writer_dispatch (gpointer user_data)
+{
+	dbWriteCommandPtr cmd = (dbWriteCommandPtr)user_data;
+
+	(*cmd->callback) (cmd->user_data);
+	db_writer_command_free (cmd);
+
+	return FALSE;
+}
+
+static void
+db_writer_execute (dbWriteCommandPtr cmd)
+{
+	switch (cmd->type) {
+		case DB_WRITE_ITEM:
+			db_writer_item_update (cmd);
+			break;
+		case DB_WRITE_ITEM_STATE:
+			db_writer_item_state_update (cmd);
+			break;
+		case DB_WRITE_SUBSCRIPTION:
+			db_writer_subscription_update (cmd);
+			break;
+		case DB_WRITE_NODE:
+			db_writer_node_update (cmd);
+			break;
+		case DB_WRITE_VACUUM:
+			debug_start_measurement (DEBUG_DB);
+			db_writer_exec ("PRAGMA auto_vacuum = INCREMENTAL;");
+			db_writer_exec ("VACUUM;");
+			debug_end_measurement (DEBUG_DB, "VACUUM");
+			break;
+		case DB_WRITE_SYNC:
+			break;
+	}
+}
+
+static void
+db_writer_exec (const gchar *sql)
+{
+	gchar	*err = NULL;
+
+	if (SQLITE_OK != sqlite3_exec (writerDb, sql, NULL, NULL, &err))
+		g_warning ("DB writer: \"%s\" failed (%s)", sql, err);
+	sqlite3_free (err);
+}
+
+static gboolean
+db_search_folder_ids_contain (GSList *ids, const gchar *id)
+{
+	return NULL != g_slist_find_custom (ids, id, (GCompareFunc)strcmp);
+}
+
+/* Takes over the search folder checks of an obsolete state update
+   that the newer state update of the same item did not repeat */
+static void
+db_writer_merge_search_folders (dbWriteCommandPtr cmd, dbWriteCommandPtr obsolete)
+{
+	GSList	*iter;
+
+	for (iter = obsolete->searchFoldersAdd; iter; iter = g_slist_next (iter)) {
+		if (!db_search_folder_ids_contain (cmd->searchFoldersAdd, iter->data) &&
+		    !db_search_folder_ids_contain (cmd->searchFoldersRemove, iter->data))
+			cmd->searchFoldersAdd = g_slist_prepend (cmd->searchFoldersAdd, g_strdup (iter->data));
+	}
+	for (iter = obsolete->searchFoldersRemove; iter; iter = g_slist_next (iter)) {
+		if (!db_search_folder_ids_contain (cmd->searchFoldersAdd, iter->data) &&
+		    !db_search_folder_ids_contain (cmd->searchFoldersRemove, iter->data))
+			cmd->searchFoldersRemove = g_slist_prepend (cmd->searchFoldersRemove, g_strdup (iter->data));
+	}
+}
+
+static gpointer
+db_writer_thread (gpointer data)
+{
+	GPtrArray	*batch = g_ptr_array_new ();
+	GHashTable	*stateUpdates = g_hash_table_new (g_direct_hash, g_direct_equal);
+	gboolean	quit = FALSE, transaction;
+	guint		i;
+	dbWriteCommandPtr next = NULL;	/* first command of the next batch */
+
+	debug_trace_set_thread_name ("DB writer");
+
+	while (!quit) {
+		dbWriteCommandPtr cmd = next?next:g_async_queue_pop (writerQueue);
+
+		next = NULL;
+
+		/* Collect everything queued meanwhile into one transaction */
+		while (cmd && batch->len < DB_WRITER_MAX_BATCH) {
+			if (cmd == &writerQuit) {
+				quit = TRUE;
+				break;
+			}
+
+			/* A VACUUM cannot run in a transaction and is executed alone */
+			if (DB_WRITE_VACUUM == cmd->type) {
+				if (!batch->len) {
+					g_ptr_array_add (batch, cmd);
+					cmd = NULL;
+				}
+				break;
+			}
+
+			/* A state update makes a former state update of the
+			   same item obsolete as all state columns are written */
+			if (DB_WRITE_ITEM_STATE == cmd->type) {
+				gpointer key = GUINT_TO_POINTER (cmd->item->id);
+				gpointer index = g_hash_table_lookup (stateUpdates, key);
+
+				if (index) {
+					dbWriteCommandPtr obsolete = g_ptr_array_index (batch, GPOINTER_TO_UINT (index) - 1);
+					db_writer_merge_search_folders (cmd, obsolete);
+					obsolete->type = DB_WRITE_SYNC;
+				}
+				g_hash_table_insert (stateUpdates, key, GUINT_TO_POINTER (batch->len + 1));
+			}
+
+			g_ptr_array_add (batch, cmd);
+			cmd = g_async_queue_try_pop (writerQueue);
+		}
+		if (cmd && cmd != &writerQuit)
+			next = cmd;
+
+		if (!batch->len)
+			continue;
+
+		debug_start_measurement (DEBUG_DB);
+		debug_span_begin ("DB writer commit");
+		debug_span_arg_int ("commands", batch->len);
+		transaction = (DB_WRITE_VACUUM != ((dbWriteCommandPtr)g_ptr_array_index (batch, 0))->type);
+		if (transaction)
+			db_writer_exec ("BEGIN");
+		for (i = 0; i < batch->len; i++)
+			db_writer_execute (g_ptr_array_index (batch, i));
+		if (transaction)
+			db_writer_exec ("COMMIT");
+		debug_span_end ();
+		debug_end_measurement (DEBUG_DB, "DB writer commit");
+		debug1 (DEBUG_DB, "DB writer committed %u commands", batch->len);
+
+		g_mutex_lock (&writerLock);
+		for (i = 0; i < batch->len; i++)
+			db_writer_command_remove_keys (g_ptr_array_index (batch, i));
+		writerPending -= batch->len;
+		g_cond_broadcast (&writerCommitted);
+		g_mutex_unlock (&writerLock);
+
+		for (i = 0; i < batch->len; i++) {
+			cmd = g_ptr_array_index (batch, i);
+			if (cmd->callback)
+				g_idle_add (db_writer_dispatch, cmd);
+			else
+				db_writer_command_free (cmd);
+		}
+
+		g_ptr_array_set_size (batch, 0);
+		g_hash_table_remove_all (stateUpdates);
+	}
+
+	g_ptr_array_free (batch, TRUE);
+	g_hash_table_destroy (stateUpdates);
+
+	return NULL;
+}
+
+static void
+db_writer_start (void)
+{
+	gchar	*filename;
+	gint	res;
+
+	filename = db_get_filename ();
+	res = sqlite3_open_v2 (filename, &writerDb, SQLITE_OPEN_READWRITE, NULL);
+	if (SQLITE_OK != res)
+		g_error ("Data base file %s could not be opened for writing (error code %d: %s)...", filename, res, sqlite3_errmsg (writerDb));
+	g_free (filename);
+
+	sqlite3_extended_result_codes (writerDb, TRUE);
+	sqlite3_busy_timeout (writerDb, 10000);
+	sqlite3_profile (writerDb, db_profile, NULL);
+	db_writer_exec ("PRAGMA synchronous=NORMAL");
+
+	writerQueue = g_async_queue_new ();
+	writerKeys = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	writerThread = g_thread_new ("db writer", db_writer_thread, NULL);
+}
+
+static void
+db_writer_stop (void)
+{
+	if (!writerThread)
+		return;
+
+	g_async_queue_push (writerQueue, &writerQuit);
+	g_thread_join (writerThread);
+	writerThread = NULL;
+
+	g_async_queue_unref (writerQueue);
+	writerQueue = NULL;
+	g_hash_table_destroy (writerKeys);
+	writerKeys = NULL;
+
+	if (SQLITE_OK != sqlite3_close (writerDb))
+		g_warning ("DB writer close failed: %s", sqlite3_errmsg (writerDb));
+	writerDb = NULL;
+}
+
+void
+db_sync (dbSyncCallback callback, gpointer user_data)
+{
+	dbWriteCommandPtr	cmd;
+
+	if (!writerThread) {
+		(*callback) (user_data);
+		return;
+	}
+
+	cmd = g_new0 (struct dbWriteCommand, 1);
+	cmd->type = DB_WRITE_SYNC;
+	cmd->callback = callback;
+	cmd->user_data = user_data;
+	db_writer_push (cmd);
 }
 
 static gboolean
@@ -1607,7 +2971,8 @@ db_node_remove (const gchar *id)
 	sqlite3_stmt	*stmt;
 	gint		res;
 
-	stmt = db_get_statement ("nodeRemoveStmt");	
+	db_writer_wait_node (id);
+	stmt = db_get_statement ("nodeRemoveStmt");
 	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
 
 	res = sqlite3_step (stmt);
@@ -1625,6 +2990,7 @@ db_node_cleanup (nodePtr root)
 	debug0 (DEBUG_DB, "Cleaning node ids...");
 
 	/* Fetch all node ids */
+	db_writer_flush ();
 	stmt = db_get_statement ("nodeIdListStmt");
 	while (sqlite3_step (stmt) == SQLITE_ROW) {
 		/* Drop node ids not in feed list anymore */
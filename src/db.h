@@ -38,6 +38,18 @@ void    db_init (void);
  */
 void    db_deinit (void);
 
+typedef void (*dbQueryPlanFunc) (const gchar *name, const gchar *sql, const gchar *plan, gpointer user_data);
+
+/**
+ * Runs EXPLAIN QUERY PLAN on all prepared statements and passes
+ * each line of the resulting plans to the given callback. Used to
+ * check that no statement needs a full table scan.
+ *
+ * @param func		callback (statement name, SQL, plan line, user data)
+ * @param user_data	user data passed to the callback
+ */
+void	db_foreach_query_plan (dbQueryPlanFunc func, gpointer user_data);
+
 /* item set access (note: item sets are identified by the node id string) */
 
 /**
@@ -83,18 +95,24 @@ guint	db_itemset_get_unread_count (const gchar *id);
 guint   db_itemset_get_item_count (const gchar *id);
 
 /**
- * Returns a batch of items starting with the given
- * offset and no more than the given limit. 
- * 
- * To be used for batched item loading (search folder loaders)
+ * Returns the highest item id in use.
  *
- * @param itemSet       an itemset to add the items to
- * @param offset        the current offset
- * @param limit         maximum number of items to fetch
- * 
- * @returns FALSE if no more items to fetch
+ * @returns item id (0 if there are no items)
+ */
+gulong	db_item_get_max_id (void);
+
+/**
+ * Loads all items (but no comments) with ids in the given range
+ * including their descriptions. Uses a read-only connection of
+ * the calling thread and therefore may be called from worker
+ * threads (search folder loaders).
+ *
+ * @param first		first item id
+ * @param last		last item id
+ *
+ * @returns list of new items, must be free'd using item_unload()
  */
-gboolean        db_itemset_get (itemSetPtr itemSet, gulong offset, guint limit);
+GSList *	db_reader_items_load (gulong first, gulong last);
 
 /* item access (note: items are identified by the numeric item id) */
 
@@ -108,7 +126,54 @@ gboolean        db_itemset_get (itemSetPtr itemSet, gulong offset, guint limit);
 itemPtr	db_item_load(gulong id);
 
 /**
- * Updates all attributes of the item in the DB
+ * Loads the description of the item specified by id from the DB.
+ * Item descriptions are stored apart from the item state and are
+ * not loaded by db_item_load().
+ *
+ * @param id		the id
+ *
+ * @returns new description string (empty if there is none), must be free'd
+ */
+gchar * db_item_load_description (gulong id);
+
+/**
+ * Loads the item with the given GUID from the given node.
+ * Uses the (node_id, source_id) index and therefore does
+ * not need to load the node's item set.
+ *
+ * @param node		the node the item belongs to
+ * @param sourceId	the item GUID
+ *
+ * @returns new item structure or NULL, must be free'd using item_unload()
+ */
+itemPtr	db_item_find_by_source_id (nodePtr node, const gchar *sourceId);
+
+/**
+ * Returns statistics on the item description compression.
+ * Note: this scans the whole items table.
+ *
+ * @param rawCount		returns the number of uncompressed descriptions
+ * @param compressedCount	returns the number of compressed descriptions
+ * @param storedSize		returns the stored size of all descriptions
+ * @param originalSize		returns the uncompressed size of all descriptions
+ */
+void	db_get_description_stats (guint *rawCount, guint *compressedCount, gint64 *storedSize, gint64 *originalSize);
+
+typedef void (*dbSyncCallback) (gpointer user_data);
+
+/**
+ * Requests a callback in the main loop once all DB updates
+ * queued so far are committed. Use this instead of reading
+ * right after an update to avoid waiting for the DB writer.
+ *
+ * @param callback	the callback
+ * @param user_data	user data passed to the callback
+ */
+void	db_sync (dbSyncCallback callback, gpointer user_data);
+
+/**
+ * Updates all attributes of the item in the DB. Assigns an
+ * id to new items. The update is executed asynchronously.
  *
  * @param item		the item
  */
@@ -123,10 +188,13 @@ void	db_item_remove(gulong id);
 
 /**
  * Update the attributes related to item state only.
+ * The update is executed asynchronously.
  *
  * @param item          the item
+ * @param changed	ruleDepends flags of the changed state
+ *			(decides which search folders are re-checked)
  */
-void    db_item_state_update (itemPtr item);
+void    db_item_state_update (itemPtr item, guint changed);
 
 /**
  * Returns a list of item ids with the given GUID. 
@@ -171,13 +239,14 @@ void    db_search_folder_reset (const gchar *id);
 void    db_search_folder_add_items (const gchar *id, GSList *items);
 
 /**
- * Returns the number of items for the given search folder.
+ * Returns the item and unread item count for the given search folder.
+ * The counters are maintained by the DB, so this is a single lookup.
  *
- * @param id	the node id
- *
- * @returns the number of items
+ * @param id		the node id
+ * @param itemCount	returns the number of items
+ * @param unreadCount	returns the number of unread items
  */
-guint   db_search_folder_get_item_count (const gchar *id);
+void    db_search_folder_get_counts (const gchar *id, guint *itemCount, guint *unreadCount);
 
 /**
  * Load the metadata and update state of the given subscription.
@@ -188,6 +257,7 @@ void db_subscription_load (subscriptionPtr subscription);
 
 /**
  * Updates (or inserts) the properties of the given subscription in the DB.
+ * The update is executed asynchronously.
  *
  * @param subscription	the subscription
  */
@@ -202,6 +272,7 @@ void db_subscription_remove (const gchar *id);
 
 /**
  * Updates the given nodes properties in the DB.
+ * The update is executed asynchronously.
  *
  * @param node		the node
  */
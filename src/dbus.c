@@ -22,8 +22,11 @@
 #include "dbus.h"
 #include "debug.h"
 #include "feedlist.h"
+#include "item.h"
+#include "metrics.h"
 #include "net_monitor.h"
 #include "subscription.h"
+#include "update.h"
 #include "ui/liferea_shell.h"
 
 static GDBusNodeInfo *introspection_data = NULL;
@@ -51,6 +54,10 @@ static const gchar introspection_xml[] =
 "    <method name='Refresh'>"
 "      <arg name='result' type='b' direction='out' />"
 "    </method>"
+"    <method name='GetStats'>"
+"      <arg name='counters' type='a{st}' direction='out' />"
+"      <arg name='histograms' type='a{s(tttat)}' direction='out' />"
+"    </method>"
 "  </interface>"
 "</node>";
 
@@ -96,6 +103,28 @@ liferea_dbus_refresh (LifereaDBus *self, GError **err)
 	return TRUE;
 }
 
+/* Counters and gauges as name/value pairs plus duration histograms
+   as name/(count, sum, max, log2 buckets) all in microseconds */
+static GVariant *
+liferea_dbus_get_stats (LifereaDBus *self, GError **err)
+{
+	GVariantBuilder	counters, histograms;
+	guint		queued, active;
+
+	g_variant_builder_init (&counters, G_VARIANT_TYPE ("a{st}"));
+	metrics_add_counters (&counters);
+
+	update_get_job_counts (&queued, &active);
+	g_variant_builder_add (&counters, "{st}", "update.jobs_queued", (guint64)queued);
+	g_variant_builder_add (&counters, "{st}", "update.jobs_active", (guint64)active);
+	g_variant_builder_add (&counters, "{st}", "items.loaded", (guint64)item_get_loaded_count ());
+
+	g_variant_builder_init (&histograms, G_VARIANT_TYPE ("a{s(tttat)}"));
+	metrics_add_histograms (&histograms);
+
+	return g_variant_new ("(a{st}a{s(tttat)})", &counters, &histograms);
+}
+
 static void
 handle_method_call (GDBusConnection       *connection,
 		    const gchar           *sender,
@@ -139,6 +168,9 @@ handle_method_call (GDBusConnection       *connection,
 		res = liferea_dbus_refresh (self, NULL);
 		g_dbus_method_invocation_return_value (invocation,
 			g_variant_new ("(b)", res));
+	} else if (g_str_equal (method_name, "GetStats")) {
+		g_dbus_method_invocation_return_value (invocation,
+			liferea_dbus_get_stats (self, NULL));
 	} else {
 		g_warning ("Unknown method name or unknown parameters: %s",
 			   method_name);
@@ -37,8 +37,41 @@
 #endif
 
 unsigned long debug_level = 0;
-static GHashTable * t2d = NULL; /**< per thread call tree depth */
-static GHashTable *startTimes = NULL;
+/* Measurements are started and ended on the same thread, so the call
+   tree depth and the start times are kept per thread */
+static GPrivate threadDepth = G_PRIVATE_INIT (NULL);
+static GPrivate threadStartTimes = G_PRIVATE_INIT ((GDestroyNotify)g_hash_table_destroy);
+static GTimer *startupTimer = NULL;	/**< startup timeline clock (only with --profile-startup) */
+static gdouble startupLastPhase = 0;
+
+/* Span tracing: every thread records into its own buffer, the buffer
+   lock is only contended while a trace is dumped. Buffers outlive
+   their threads, so the dump covers finished worker threads too. */
+
+#define DEBUG_TRACE_MAX_EVENTS	500000	/* per thread, further spans are dropped */
+
+typedef struct traceEvent {
+	const char	*name;
+	gint64		start;		/**< monotonic ns */
+	gint64		end;		/**< monotonic ns, 0 while open */
+	GString		*args;		/**< JSON object members, or NULL */
+} traceEvent;
+
+typedef struct traceBuffer {
+	GMutex		lock;
+	guint		tid;
+	const char	*name;		/**< thread name or NULL */
+	GArray		*events;	/**< traceEvent */
+	GArray		*open;		/**< stack of indices of open events, -1 for dropped spans */
+	guint		dropped;
+} *traceBufferPtr;
+
+int debug_tracing = FALSE;
+static gchar *traceFile = NULL;
+static gint64 traceStart = 0;
+static GMutex traceLock;		/**< protects traceBuffers */
+static GSList *traceBuffers = NULL;
+static GPrivate threadTraceBuffer = G_PRIVATE_INIT (NULL);
 
 static const char *
 debug_get_prefix (unsigned long flag) 
@@ -60,39 +93,28 @@ debug_get_prefix (unsigned long flag)
 static void
 debug_set_depth (gint newDepth)
 {
-	const gpointer self = g_thread_self ();
-
-	/* Track per-thread call tree depth */
-	if (t2d == NULL)
-		t2d = g_hash_table_new (g_direct_hash, g_direct_equal);
-
-	if (newDepth < 0)
-		g_hash_table_insert(t2d, self, GINT_TO_POINTER(0));
-	else
-		g_hash_table_insert(t2d, self, GINT_TO_POINTER(newDepth));
+	g_private_set (&threadDepth, GINT_TO_POINTER (MAX (newDepth, 0)));
 }
 
 static gint
 debug_get_depth (void)
 {
-	const gpointer self = g_thread_self ();
-
-	if (!t2d)
-		return 0;
-
-	return GPOINTER_TO_INT (g_hash_table_lookup (t2d, self));
+	return GPOINTER_TO_INT (g_private_get (&threadDepth));
 }
 
 void
 debug_start_measurement_func (const char * function)
 {
+	GHashTable	*startTimes = g_private_get (&threadStartTimes);
 	GTimeVal	*startTime = NULL;
 	
 	if (!function)
 		return;
 		
-	if (!startTimes)
-		startTimes = g_hash_table_new (g_str_hash, g_str_equal);
+	if (!startTimes) {
+		startTimes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+		g_private_set (&threadStartTimes, startTimes);
+	}
 	
 	startTime = (GTimeVal *) g_hash_table_lookup (startTimes, function);
 	
@@ -110,6 +132,7 @@ debug_end_measurement_func (const char * function,
                             unsigned long flags, 
 			    const char *name)
 {
+	GHashTable	*startTimes = g_private_get (&threadStartTimes);
 	GTimeVal	*startTime = NULL;
 	GTimeVal	endTime;
 	unsigned long	duration = 0;
@@ -146,7 +169,269 @@ debug_end_measurement_func (const char * function,
 	if (duration > 250)
 		debug2 (DEBUG_PERF, "function \"%s\" is slow! Took %dms.", name, duration);
 }
+
+void
+debug_startup_profile_enable (void)
+{
+	if (startupTimer)
+		return;
+
+	startupTimer = g_timer_new ();
+	g_print ("Startup profile:\n");
+	g_print ("  %10s  %10s  %s\n", "elapsed", "duration", "phase");
+}
+
+void
+debug_startup_phase (const char *phase)
+{
+	gdouble	now;
+
+	if (!startupTimer)
+		return;
+
+	now = g_timer_elapsed (startupTimer, NULL);
+	g_print ("  %8.1fms  %8.1fms  %s\n", now * 1000, (now - startupLastPhase) * 1000, phase);
+	startupLastPhase = now;
+}
+
+void
+debug_startup_profile_finish (void)
+{
+	if (!startupTimer)
+		return;
+
+	debug_startup_phase ("main loop idle");
+	g_print ("Startup finished after %.1fms\n", g_timer_elapsed (startupTimer, NULL) * 1000);
+
+	g_timer_destroy (startupTimer);
+	startupTimer = NULL;
+}
  
+static gint64
+debug_trace_clock (void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec	ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (gint64)ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+#else
+	return g_get_monotonic_time () * 1000;
+#endif
+}
+
+static traceBufferPtr
+debug_trace_get_buffer (void)
+{
+	traceBufferPtr	buffer = g_private_get (&threadTraceBuffer);
+
+	if (!buffer) {
+		buffer = g_new0 (struct traceBuffer, 1);
+		g_mutex_init (&buffer->lock);
+		buffer->events = g_array_new (FALSE, FALSE, sizeof (traceEvent));
+		buffer->open = g_array_new (FALSE, FALSE, sizeof (gint));
+		g_private_set (&threadTraceBuffer, buffer);
+
+		g_mutex_lock (&traceLock);
+		buffer->tid = g_slist_length (traceBuffers) + 1;
+		traceBuffers = g_slist_append (traceBuffers, buffer);
+		g_mutex_unlock (&traceLock);
+	}
+
+	return buffer;
+}
+
+void
+debug_trace_enable (const char *filename)
+{
+	g_free (traceFile);
+	traceFile = g_strdup (filename);
+	traceStart = debug_trace_clock ();
+	debug_tracing = TRUE;
+	debug_trace_set_thread_name ("main");
+}
+
+void
+debug_trace_set_thread_name (const char *name)
+{
+	if (debug_tracing)
+		debug_trace_get_buffer ()->name = name;
+}
+
+void
+debug_span_begin_func (const char *name)
+{
+	traceBufferPtr	buffer = debug_trace_get_buffer ();
+	traceEvent	event = { name, debug_trace_clock (), 0, NULL };
+	gint		index = -1;
+
+	g_mutex_lock (&buffer->lock);
+	if (buffer->events->len < DEBUG_TRACE_MAX_EVENTS) {
+		index = buffer->events->len;
+		g_array_append_val (buffer->events, event);
+	} else {
+		buffer->dropped++;
+	}
+	g_array_append_val (buffer->open, index);
+	g_mutex_unlock (&buffer->lock);
+}
+
+void
+debug_span_end_func (void)
+{
+	traceBufferPtr	buffer = debug_trace_get_buffer ();
+	gint64		now = debug_trace_clock ();
+	gint		index;
+
+	g_mutex_lock (&buffer->lock);
+	if (buffer->open->len) {
+		index = g_array_index (buffer->open, gint, buffer->open->len - 1);
+		if (index >= 0)
+			g_array_index (buffer->events, traceEvent, index).end = now;
+		g_array_set_size (buffer->open, buffer->open->len - 1);
+	}
+	g_mutex_unlock (&buffer->lock);
+}
+
+static void
+debug_json_append_string (GString *json, const char *str)
+{
+	g_string_append_c (json, '"');
+	for (; str && *str; str++) {
+		switch (*str) {
+			case '"':	g_string_append (json, "\\\""); break;
+			case '\\':	g_string_append (json, "\\\\"); break;
+			case '\n':	g_string_append (json, "\\n"); break;
+			case '\t':	g_string_append (json, "\\t"); break;
+			default:
+				if ((guchar)*str < 0x20)
+					g_string_append_printf (json, "\\u%04x", (guchar)*str);
+				else
+					g_string_append_c (json, *str);
+				break;
+		}
+	}
+	g_string_append_c (json, '"');
+}
+
+/* Returns the argument list of the innermost open span with the
+   buffer locked, or NULL (and the buffer unlocked) if there is none */
+static GString *
+debug_span_lock_args (traceBufferPtr buffer, const char *key)
+{
+	traceEvent	*event;
+	gint		index;
+
+	g_mutex_lock (&buffer->lock);
+	index = buffer->open->len?g_array_index (buffer->open, gint, buffer->open->len - 1):-1;
+	if (index < 0) {
+		g_mutex_unlock (&buffer->lock);
+		return NULL;
+	}
+
+	event = &g_array_index (buffer->events, traceEvent, index);
+	if (!event->args)
+		event->args = g_string_new (NULL);
+	else
+		g_string_append_c (event->args, ',');
+
+	debug_json_append_string (event->args, key);
+	g_string_append_c (event->args, ':');
+
+	return event->args;
+}
+
+void
+debug_span_arg_str_func (const char *key, const char *value)
+{
+	traceBufferPtr	buffer = debug_trace_get_buffer ();
+	GString		*args = debug_span_lock_args (buffer, key);
+
+	if (args) {
+		debug_json_append_string (args, value);
+		g_mutex_unlock (&buffer->lock);
+	}
+}
+
+void
+debug_span_arg_int_func (const char *key, long long value)
+{
+	traceBufferPtr	buffer = debug_trace_get_buffer ();
+	GString		*args = debug_span_lock_args (buffer, key);
+
+	if (args) {
+		g_string_append_printf (args, "%lld", value);
+		g_mutex_unlock (&buffer->lock);
+	}
+}
+
+void
+debug_trace_dump (void)
+{
+	GString		*json;
+	GSList		*iter;
+	GError		*error = NULL;
+	gint64		now = debug_trace_clock ();
+	guint		i, count = 0, dropped = 0;
+
+	if (!debug_tracing)
+		return;
+
+	json = g_string_new ("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	g_mutex_lock (&traceLock);
+	for (iter = traceBuffers; iter; iter = g_slist_next (iter)) {
+		traceBufferPtr buffer = (traceBufferPtr)iter->data;
+
+		g_mutex_lock (&buffer->lock);
+		g_string_append_printf (json, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", buffer->tid);
+		if (buffer->name) {
+			debug_json_append_string (json, buffer->name);
+		} else {
+			gchar *name = g_strdup_printf ("thread %u", buffer->tid);
+			debug_json_append_string (json, name);
+			g_free (name);
+		}
+		g_string_append (json, "}}");
+
+		for (i = 0; i < buffer->events->len; i++) {
+			traceEvent *event = &g_array_index (buffer->events, traceEvent, i);
+
+			/* spans still open are shown up to now */
+			g_string_append (json, ",\n{\"name\":");
+			debug_json_append_string (json, event->name);
+			g_string_append_printf (json, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+			                        buffer->tid,
+			                        (event->start - traceStart) / 1000.0,
+			                        ((event->end?event->end:now) - event->start) / 1000.0);
+			if (event->args)
+				g_string_append_printf (json, ",\"args\":{%s}", event->args->str);
+			g_string_append_c (json, '}');
+		}
+		count += buffer->events->len;
+		dropped += buffer->dropped;
+		g_mutex_unlock (&buffer->lock);
+
+		if (g_slist_next (iter))
+			g_string_append (json, ",\n");
+	}
+	g_mutex_unlock (&traceLock);
+
+	g_string_append (json, "\n]}\n");
+
+	if (g_file_set_contents (traceFile, json->str, json->len, &error)) {
+		g_print ("Wrote %u trace spans to %s", count, traceFile);
+		if (dropped)
+			g_print (" (%u spans dropped)", dropped);
+		g_print ("\n");
+	} else {
+		g_warning ("Could not write trace file: %s", error->message);
+		g_error_free (error);
+	}
+
+	g_string_free (json, TRUE);
+}
+
 void
 set_debug_level (unsigned long level)
 {
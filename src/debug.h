@@ -65,6 +65,81 @@ extern void debug_end_measurement_func (const char * function, unsigned long fla
 
 #define debug_end_measurement(level, name) if ((debug_level) & level) debug_end_measurement_func (PRETTY_FUNCTION, level, name)
 
+/**
+ * Enables startup profiling (--profile-startup) and starts
+ * the startup timeline.
+ */
+extern void debug_startup_profile_enable (void);
+
+/**
+ * Marks the end of a startup phase. If startup profiling is
+ * enabled the time since start and the phase duration are printed.
+ *
+ * @param phase		name of the finished startup phase
+ */
+extern void debug_startup_phase (const char *phase);
+
+/**
+ * Prints the total startup time and ends startup profiling.
+ */
+extern void debug_startup_profile_finish (void);
+
+/**
+ * Enables span tracing (--trace-file). Spans are recorded into
+ * per-thread buffers until debug_trace_dump() writes them.
+ *
+ * @param filename	file to write the trace to
+ */
+extern void debug_trace_enable (const char *filename);
+
+/**
+ * Writes all spans recorded so far as Chrome trace event JSON
+ * to the file given to debug_trace_enable(). The result can be
+ * loaded into chrome://tracing or other trace viewers.
+ */
+extern void debug_trace_dump (void);
+
+/**
+ * Names the calling thread in the trace output.
+ *
+ * @param name		thread name (static string)
+ */
+extern void debug_trace_set_thread_name (const char *name);
+
+/** TRUE if span tracing is enabled */
+extern int debug_tracing;
+
+/**
+ * Starts a span on the calling thread. Spans started before the
+ * matching debug_span_end() on the same thread are nested into it.
+ * Time is taken from a monotonic nanosecond clock.
+ *
+ * @param name		span name (static string)
+ */
+extern void debug_span_begin_func (const char *name);
+
+/**
+ * Adds a string argument (e.g. a node id) to the innermost
+ * open span of the calling thread.
+ */
+extern void debug_span_arg_str_func (const char *key, const char *value);
+
+/**
+ * Adds an integer argument (e.g. a byte count) to the innermost
+ * open span of the calling thread.
+ */
+extern void debug_span_arg_int_func (const char *key, long long value);
+
+/**
+ * Ends the innermost open span of the calling thread.
+ */
+extern void debug_span_end_func (void);
+
+#define debug_span_begin(name) if (debug_tracing) debug_span_begin_func (name)
+#define debug_span_arg_str(key, value) if (debug_tracing) debug_span_arg_str_func (key, value)
+#define debug_span_arg_int(key, value) if (debug_tracing) debug_span_arg_int_func (key, value)
+#define debug_span_end() if (debug_tracing) debug_span_end_func ()
+
 /**
  * Enable debugging for one or more of the given debugging flags.
  *
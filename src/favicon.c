@@ -38,14 +38,23 @@
 #include "html.h"
 #include "metadata.h"
 
+typedef struct faviconWaiter {
+	gchar			*id;		/**< favicon cache id */
+	faviconUpdatedCb	callback;	/**< usually feed_favicon_updated() */
+	gpointer		user_data;	/**< usually the node pointer */
+} *faviconWaiterPtr;
+
 typedef struct faviconDownloadCtxt {
-	gchar		        *id;		/**< favicon cache id */
+	gchar		        *id;		/**< favicon cache id of the first requester */
+	gchar			*key;		/**< host the favicon is downloaded for */
 	GSList			*urls;		/**< ordered list of URLs to try */
 	updateOptionsPtr	options;	/**< download options */
-	faviconUpdatedCb	callback;	/**< usually feed_favicon_updated() */
-	gpointer		user_data;	/**< usually the node pointer */
+	GSList			*waiters;	/**< list of faviconWaiters to notify */
 } *faviconDownloadCtxtPtr;
 
+/** running favicon downloads (host -> faviconDownloadCtxt) */
+static GHashTable *downloads = NULL;
+
 static faviconDownloadCtxtPtr
 favicon_download_ctxt_new () 
 {
@@ -58,17 +67,232 @@ favicon_download_ctxt_free (faviconDownloadCtxtPtr ctxt)
 	GSList  *iter; 
 
 	if (!ctxt) return;
+
+	g_hash_table_remove (downloads, ctxt->key);
+
 	g_free (ctxt->id);
+	g_free (ctxt->key);
 	
 	for (iter = ctxt->urls; iter; iter = g_slist_next (iter))
 		g_free (iter->data);
 
+	for (iter = ctxt->waiters; iter; iter = g_slist_next (iter)) {
+		g_free (((faviconWaiterPtr)iter->data)->id);
+		g_free (iter->data);
+	}
+
 	g_slist_free (ctxt->urls);
+	g_slist_free (ctxt->waiters);
 	update_options_free (ctxt->options);
+	g_free (ctxt);
 }
 
 static void favicon_download_run(faviconDownloadCtxtPtr ctxt);
 
+/* Packed favicon cache
+
+   All favicons are kept pre-scaled in a single cache file which is
+   memory-mapped on first use. Loading a favicon from it neither needs
+   a stat() nor PNG decoding and scaling, the returned pixbufs directly
+   use the mapped pixel data. The file layout is
+
+	header		magic, version, icon size and entry count
+	index		entry count * (favicon id, pixel data offset)
+	pixel data	entry count * (size * size RGBA pixels)
+
+   Favicons missing in the packed cache are loaded from the PNG cache
+   (which is still needed for HTML rendering) and are added to the
+   packed cache on the next save. */
+
+#define FAVICON_CACHE_MAGIC		"LFIC"
+#define FAVICON_CACHE_VERSION		1
+#define FAVICON_CACHE_ICON_SIZE		32
+#define FAVICON_CACHE_ICON_BYTES	(FAVICON_CACHE_ICON_SIZE * FAVICON_CACHE_ICON_SIZE * 4)
+#define FAVICON_CACHE_ID_LEN		16
+
+/** delay (in seconds) for saving the packed cache after changes */
+#define FAVICON_CACHE_SAVE_DELAY	10
+
+typedef struct faviconCacheHeader {
+	gchar	magic[4];
+	guint32	version;
+	guint32	size;				/**< width / height of all icons */
+	guint32	count;				/**< number of index entries */
+} faviconCacheHeader;
+
+typedef struct faviconCacheEntry {
+	gchar	id[FAVICON_CACHE_ID_LEN];	/**< zero padded favicon id */
+	guint32	offset;				/**< file offset of the pixel data */
+} faviconCacheEntry;
+
+static GMappedFile	*cacheFile = NULL;	/**< currently mapped packed cache */
+static GHashTable	*cacheIndex = NULL;	/**< favicon id -> pixel data in cacheFile */
+static GHashTable	*cachePending = NULL;	/**< favicon id -> scaled pixbuf not yet packed */
+static guint		cacheSaveTimeout = 0;
+
+static gchar *
+favicon_cache_get_filename (void)
+{
+	return common_create_cache_filename (NULL, "favicons", "cache");
+}
+
+static void
+favicon_cache_map (void)
+{
+	const faviconCacheHeader	*header;
+	const faviconCacheEntry		*entries;
+	const gchar			*data;
+	gchar				*filename;
+	GError				*error = NULL;
+	gsize				length;
+	guint32				i;
+
+	g_hash_table_remove_all (cacheIndex);
+	if (cacheFile) {
+		/* Pixbufs still using the old mapping keep their own reference */
+		g_mapped_file_unref (cacheFile);
+		cacheFile = NULL;
+	}
+
+	filename = favicon_cache_get_filename ();
+	if (g_file_test (filename, G_FILE_TEST_EXISTS)) {
+		/* Map writable (copy-on-write) as pixbuf pixels are not const */
+		cacheFile = g_mapped_file_new (filename, TRUE, &error);
+		if (!cacheFile) {
+			g_warning ("Could not map favicon cache %s: %s", filename, error->message);
+			g_error_free (error);
+		}
+	}
+	g_free (filename);
+
+	if (!cacheFile)
+		return;
+
+	data = g_mapped_file_get_contents (cacheFile);
+	length = g_mapped_file_get_length (cacheFile);
+	header = (const faviconCacheHeader *)data;
+
+	if (length < sizeof (faviconCacheHeader) ||
+	    strncmp (header->magic, FAVICON_CACHE_MAGIC, 4) ||
+	    header->version != FAVICON_CACHE_VERSION ||
+	    header->size != FAVICON_CACHE_ICON_SIZE ||
+	    length < sizeof (faviconCacheHeader) + (gsize)header->count * sizeof (faviconCacheEntry)) {
+		debug0 (DEBUG_CACHE, "ignoring invalid favicon cache");
+		g_mapped_file_unref (cacheFile);
+		cacheFile = NULL;
+		return;
+	}
+
+	entries = (const faviconCacheEntry *)(data + sizeof (faviconCacheHeader));
+	for (i = 0; i < header->count; i++) {
+		if ((gsize)entries[i].offset + FAVICON_CACHE_ICON_BYTES > length)
+			continue;
+
+		g_hash_table_insert (cacheIndex, g_strndup (entries[i].id, FAVICON_CACHE_ID_LEN), (gpointer)(data + entries[i].offset));
+	}
+
+	debug1 (DEBUG_CACHE, "mapped favicon cache with %u icons", g_hash_table_size (cacheIndex));
+}
+
+static void
+favicon_cache_init (void)
+{
+	if (cacheIndex)
+		return;
+
+	cacheIndex = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	cachePending = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+
+	favicon_cache_map ();
+}
+
+static gboolean
+favicon_cache_save (gpointer user_data)
+{
+	faviconCacheHeader	header;
+	GString			*buffer;
+	GList			*ids, *iter;
+	gchar			*filename;
+	GError			*error = NULL;
+	guint32			i;
+
+	cacheSaveTimeout = 0;
+
+	ids = g_list_concat (g_hash_table_get_keys (cacheIndex), g_hash_table_get_keys (cachePending));
+
+	memset (&header, 0, sizeof (header));
+	memcpy (header.magic, FAVICON_CACHE_MAGIC, 4);
+	header.version = FAVICON_CACHE_VERSION;
+	header.size = FAVICON_CACHE_ICON_SIZE;
+	header.count = g_list_length (ids);
+
+	buffer = g_string_sized_new (sizeof (header) + header.count * (sizeof (faviconCacheEntry) + FAVICON_CACHE_ICON_BYTES));
+	g_string_append_len (buffer, (gchar *)&header, sizeof (header));
+
+	for (iter = ids, i = 0; iter; iter = g_list_next (iter), i++) {
+		faviconCacheEntry entry;
+
+		memset (&entry, 0, sizeof (entry));
+		strncpy (entry.id, (gchar *)iter->data, FAVICON_CACHE_ID_LEN);
+		entry.offset = sizeof (header) + header.count * sizeof (faviconCacheEntry) + i * FAVICON_CACHE_ICON_BYTES;
+		g_string_append_len (buffer, (gchar *)&entry, sizeof (entry));
+	}
+
+	for (iter = ids; iter; iter = g_list_next (iter)) {
+		const gchar	*pixels = g_hash_table_lookup (cacheIndex, iter->data);
+		GdkPixbuf	*pixbuf;
+		gint		y;
+
+		if (pixels) {
+			g_string_append_len (buffer, pixels, FAVICON_CACHE_ICON_BYTES);
+			continue;
+		}
+
+		/* Rows of pending pixbufs might be padded */
+		pixbuf = g_hash_table_lookup (cachePending, iter->data);
+		pixels = (const gchar *)gdk_pixbuf_get_pixels (pixbuf);
+		for (y = 0; y < FAVICON_CACHE_ICON_SIZE; y++)
+			g_string_append_len (buffer, pixels + y * gdk_pixbuf_get_rowstride (pixbuf), FAVICON_CACHE_ICON_SIZE * 4);
+	}
+	g_list_free (ids);
+
+	filename = favicon_cache_get_filename ();
+	if (g_file_set_contents (filename, buffer->str, buffer->len, &error)) {
+		debug2 (DEBUG_CACHE, "saved %u favicons to %s", header.count, filename);
+		g_hash_table_remove_all (cachePending);
+		favicon_cache_map ();
+	} else {
+		g_warning ("Could not save favicon cache %s: %s", filename, error->message);
+		g_error_free (error);
+	}
+	g_free (filename);
+	g_string_free (buffer, TRUE);
+
+	return FALSE;
+}
+
+static void
+favicon_cache_schedule_save (void)
+{
+	if (!cacheSaveTimeout)
+		cacheSaveTimeout = g_timeout_add_seconds (FAVICON_CACHE_SAVE_DELAY, favicon_cache_save, NULL);
+}
+
+static void
+favicon_cache_invalidate (const gchar *id)
+{
+	favicon_cache_init ();
+
+	if (g_hash_table_remove (cacheIndex, id) | g_hash_table_remove (cachePending, id))
+		favicon_cache_schedule_save ();
+}
+
+static void
+favicon_cache_pixbuf_destroy (guchar *pixels, gpointer data)
+{
+	g_mapped_file_unref ((GMappedFile *)data);
+}
+
 GdkPixbuf *
 favicon_load_from_cache (const gchar *id, guint size)
 {
@@ -76,6 +300,23 @@ favicon_load_from_cache (const gchar *id, guint size)
 	gchar		*filename;
 	GdkPixbuf	*pixbuf, *result = NULL;
 	GError 		*error = NULL;
+	gboolean	packed;
+
+	favicon_cache_init ();
+
+	packed = (size == FAVICON_CACHE_ICON_SIZE && strlen (id) <= FAVICON_CACHE_ID_LEN);
+	if (packed) {
+		const gchar *pixels = g_hash_table_lookup (cacheIndex, id);
+		if (pixels)
+			return gdk_pixbuf_new_from_data ((const guchar *)pixels, GDK_COLORSPACE_RGB, TRUE, 8,
+			                                 FAVICON_CACHE_ICON_SIZE, FAVICON_CACHE_ICON_SIZE,
+			                                 FAVICON_CACHE_ICON_SIZE * 4,
+			                                 favicon_cache_pixbuf_destroy, g_mapped_file_ref (cacheFile));
+
+		pixbuf = g_hash_table_lookup (cachePending, id);
+		if (pixbuf)
+			return g_object_ref (pixbuf);
+	}
 
 	filename = common_create_cache_filename ("favicons", id, "png");
 	
@@ -91,6 +332,17 @@ favicon_load_from_cache (const gchar *id, guint size)
 		}
 	}
 	g_free (filename);
+
+	if (result && packed) {
+		if (!gdk_pixbuf_get_has_alpha (result)) {
+			pixbuf = gdk_pixbuf_add_alpha (result, FALSE, 0, 0, 0);
+			g_object_unref (result);
+			result = pixbuf;
+		}
+
+		g_hash_table_insert (cachePending, g_strdup (id), g_object_ref (result));
+		favicon_cache_schedule_save ();
+	}
 	
 	return result;
 }
@@ -107,10 +359,67 @@ favicon_update_needed(const gchar *id, updateStatePtr updateState, GTimeVal *now
 	return result;
 }
 
+static void
+favicon_download_remove_waiter (gpointer key, gpointer value, gpointer user_data)
+{
+	faviconDownloadCtxtPtr	ctxt = (faviconDownloadCtxtPtr)value;
+	GSList			*iter = ctxt->waiters;
+
+	while (iter) {
+		faviconWaiterPtr waiter = (faviconWaiterPtr)iter->data;
+
+		iter = g_slist_next (iter);
+		if (g_str_equal (waiter->id, (gchar *)user_data)) {
+			ctxt->waiters = g_slist_remove (ctxt->waiters, waiter);
+			g_free (waiter->id);
+			g_free (waiter);
+		}
+	}
+}
+
+static void
+favicon_download_collect_unused (gpointer key, gpointer value, gpointer user_data)
+{
+	faviconDownloadCtxtPtr	ctxt = (faviconDownloadCtxtPtr)value;
+	GSList			**unused = (GSList **)user_data;
+
+	if (!ctxt->waiters)
+		*unused = g_slist_prepend (*unused, ctxt);
+}
+
+void
+favicon_download_cancel (const gchar *id)
+{
+	GSList	*unused = NULL, *iter;
+
+	if (!downloads)
+		return;
+
+	g_hash_table_foreach (downloads, favicon_download_remove_waiter, (gpointer)id);
+
+	/* Stop downloads nobody is waiting for anymore. The contexts
+	   cannot be freed during the iteration as they remove
+	   themselves from the hash table. */
+	g_hash_table_foreach (downloads, favicon_download_collect_unused, &unused);
+	for (iter = unused; iter; iter = g_slist_next (iter)) {
+		faviconDownloadCtxtPtr ctxt = (faviconDownloadCtxtPtr)iter->data;
+
+		debug1 (DEBUG_UPDATE, "cancelling favicon download for %s", ctxt->key);
+		update_job_cancel_by_owner (ctxt);
+		favicon_download_ctxt_free (ctxt);
+	}
+	g_slist_free (unused);
+}
+
 void favicon_remove_from_cache(const gchar *id) {
 	gchar		*filename;
 
 	debug_enter("favicon_remove");
+
+	/* do not notify about downloads for removed favicons */
+	favicon_download_cancel (id);
+
+	favicon_cache_invalidate (id);
 	
 	/* try to load a saved favicon */
 	filename = common_create_cache_filename ("favicons", id, "png");
@@ -138,10 +447,26 @@ favicon_pixbuf_size_prepared_cb (GdkPixbufLoader *loader, gint width, gint heigh
 	}
 }
 
+/* Runs the favicon-updated callbacks of all waiters and frees the context */
+static void
+favicon_download_finish (faviconDownloadCtxtPtr ctxt)
+{
+	GSList	*iter;
+
+	for (iter = ctxt->waiters; iter; iter = g_slist_next (iter)) {
+		faviconWaiterPtr waiter = (faviconWaiterPtr)iter->data;
+		if (waiter->callback)
+			(waiter->callback) (waiter->user_data);
+	}
+
+	favicon_download_ctxt_free (ctxt);
+}
+
 static void
 favicon_download_icon_cb (const struct updateResult * const result, gpointer user_data, updateFlags flags)
 {
 	faviconDownloadCtxtPtr	ctxt = (faviconDownloadCtxtPtr)user_data;
+	GSList		*iter;
 	gchar		*tmp;
 	GError		*err = NULL;
 	gboolean	success = FALSE;
@@ -161,17 +486,23 @@ favicon_download_icon_cb (const struct updateResult * const result, gpointer use
 			if (gdk_pixbuf_loader_close (loader, &err)) {
 				pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
 				if (pixbuf) {
-					tmp = common_create_cache_filename ("favicons", ctxt->id, "png");
-					debug2 (DEBUG_UPDATE, "saving favicon %s to file %s", ctxt->id, tmp);
-					if (!gdk_pixbuf_save (pixbuf, tmp, "png", &err, NULL)) {
-						g_warning ("Could not save favicon (id=%s) to file %s!", ctxt->id, tmp);
-					} else {
-						success = TRUE;
-						/* Run favicon-updated callback */
-						if (ctxt->callback)
-							(ctxt->callback) (ctxt->user_data);
+					/* Save the icon for all subscriptions sharing this download */
+					for (iter = ctxt->waiters; iter; iter = g_slist_next (iter)) {
+						faviconWaiterPtr waiter = (faviconWaiterPtr)iter->data;
+
+						tmp = common_create_cache_filename ("favicons", waiter->id, "png");
+						debug2 (DEBUG_UPDATE, "saving favicon %s to file %s", waiter->id, tmp);
+						if (!gdk_pixbuf_save (pixbuf, tmp, "png", &err, NULL)) {
+							g_warning ("Could not save favicon (id=%s) to file %s!", waiter->id, tmp);
+							g_clear_error (&err);
+						} else {
+							favicon_cache_invalidate (waiter->id);
+						}
+						g_free (tmp);
 					}
-					g_free (tmp);
+
+					success = TRUE;
+					favicon_download_finish (ctxt);
 				} else {
 					debug0 (DEBUG_UPDATE, "gdk_pixbuf_loader_get_pixbuf() failed!");
 				}
@@ -193,11 +524,8 @@ favicon_download_icon_cb (const struct updateResult * const result, gpointer use
 		debug1 (DEBUG_UPDATE, "No data in download result for favicon %s!", ctxt->id);
 	}
 	
-	if (!success) {
+	if (!success)
 		favicon_download_run (ctxt);	/* try next... */
-	} else {
-		favicon_download_ctxt_free (ctxt);
-	}
 }
 
 static void
@@ -213,7 +541,7 @@ favicon_download_html_cb (const struct updateResult * const result, gpointer use
 			request = update_request_new ();
 			request->source = iconUri;
 			request->options = update_options_copy (ctxt->options);
-			update_execute_request (ctxt->user_data, request, favicon_download_icon_cb, ctxt, flags);
+			update_execute_request (ctxt, request, favicon_download_icon_cb, ctxt, flags);
 			
 			return;
 		}
@@ -246,13 +574,10 @@ favicon_download_run (faviconDownloadCtxtPtr ctxt)
 		else
 			callback = favicon_download_html_cb;
 
-		update_execute_request (ctxt->user_data, request, callback, ctxt, FEED_REQ_PRIORITY_HIGH);
+		update_execute_request (ctxt, request, callback, ctxt, FEED_REQ_PRIORITY_HIGH);
 	} else {
 		debug1 (DEBUG_UPDATE, "favicon %s could not be downloaded!", ctxt->id);
-		/* Run favicon-updated callback */
-		if (ctxt->callback)
-			(ctxt->callback) (ctxt->user_data);
-		favicon_download_ctxt_free (ctxt);
+		favicon_download_finish (ctxt);
 	}
 	
 	debug_exit ("favicon_download_run");
@@ -268,6 +593,24 @@ static gint count_slashes(const gchar *str) {
 	return slashes;
 }
 
+/* Returns the lower-case host name of the given URL or NULL */
+static gchar *
+favicon_get_host (const gchar *url)
+{
+	const gchar	*host;
+	gsize		len;
+
+	if (!url || !(host = strstr (url, "://")))
+		return NULL;
+
+	host += 3;
+	len = strcspn (host, "/?#");
+	if (!len)
+		return NULL;
+
+	return g_ascii_strdown (host, len);
+}
+
 void
 favicon_download (subscriptionPtr subscription,
 		  const gchar *html_url,
@@ -278,17 +621,43 @@ favicon_download (subscriptionPtr subscription,
 {
 	const gchar		*id;
 	faviconDownloadCtxtPtr	ctxt;
-	gchar			*tmp, *tmp2;
+	faviconWaiterPtr	waiter;
+	gchar			*key, *tmp, *tmp2;
 
 	debug_enter("favicon_download");
 
 	id = subscription->node->id;
 
+	waiter = g_new0 (struct faviconWaiter, 1);
+	waiter->id = g_strdup (id);
+	waiter->callback = callback;
+	waiter->user_data = user_data;
+
+	/* Subscriptions of the same host share one download */
+	key = favicon_get_host (html_url);
+	if (!key)
+		key = favicon_get_host (source_url);
+	if (!key)
+		key = g_strdup (id);
+
+	if (!downloads)
+		downloads = g_hash_table_new (g_str_hash, g_str_equal);
+
+	ctxt = g_hash_table_lookup (downloads, key);
+	if (ctxt) {
+		debug2 (DEBUG_UPDATE, "favicon %s joins running download for %s", id, key);
+		ctxt->waiters = g_slist_append (ctxt->waiters, waiter);
+		g_free (key);
+		debug_exit ("favicon_download");
+		return;
+	}
+
 	ctxt = favicon_download_ctxt_new ();
 	ctxt->id = g_strdup (id);
+	ctxt->key = key;
 	ctxt->options = update_options_copy (options);
-	ctxt->callback = callback;
-	ctxt->user_data = user_data;
+	ctxt->waiters = g_slist_append (NULL, waiter);
+	g_hash_table_insert (downloads, ctxt->key, ctxt);
 
 	/*
 	 * This code tries to download from a series of URLs. If there are no
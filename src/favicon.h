@@ -29,7 +29,8 @@
 #include "update.h"
 
 /**
- * Tries to load a given favicon from cache.
+ * Tries to load a given favicon from cache. Favicons of the default
+ * size are served from the memory-mapped packed favicon cache.
  *
  * @param id		the favicon id
  * @param size		width / height in pixel
@@ -65,7 +66,8 @@ typedef void (*faviconUpdatedCb)(gpointer user_data);
 /**
  * Tries to download a favicon from and relative to a given
  * feed source URL and an optional feed HTML URL. Can be used
- * for non-feed related favicon download too.
+ * for non-feed related favicon download too. Concurrent downloads
+ * for subscriptions of the same host are merged into one.
  *
  * @param subscription	subscription whose icon is going to be updated
  * @param html_url	URL of a website where a favicon could be found (optional)
@@ -76,4 +78,13 @@ typedef void (*faviconUpdatedCb)(gpointer user_data);
  */
 void favicon_download (subscriptionPtr subscription, const gchar *html_url, const gchar *source_url, const updateOptionsPtr options, faviconUpdatedCb callback, gpointer user_data);
 
+/**
+ * Drops all pending favicon download notifications for the given
+ * favicon id. Downloads no one else is waiting for are cancelled.
+ * Must be called before the callback user data of the waiters is freed.
+ *
+ * @param id		the favicon id
+ */
+void favicon_download_cancel (const gchar *id);
+
 #endif
@@ -32,6 +32,7 @@
 #include "html.h"
 #include "itemlist.h"
 #include "metadata.h"
+#include "metrics.h"
 #include "node.h"
 #include "render.h"
 #include "update.h"
@@ -287,11 +288,12 @@ feed_enrich_item (subscriptionPtr subscription, itemPtr item)
 /* implementation of subscription type interface */
 
 static void
-feed_process_update_result (subscriptionPtr subscription, const struct updateResult * const result, updateFlags flags)
+feed_process_update_result (subscriptionPtr subscription, const struct updateResult * const result, updateTimingsPtr timings, updateFlags flags)
 {
 	feedParserCtxtPtr	ctxt;
 	nodePtr			node = subscription->node;
 	feedPtr			feed = (feedPtr)node->data;
+	gint64			parseStart, mergeStart;
 
 	debug_enter ("feed_process_update_result");
 	
@@ -301,10 +303,18 @@ feed_process_update_result (subscriptionPtr subscription, const struct updateRes
 		ctxt->feed = feed;
 		ctxt->data = result->data;
 		ctxt->dataLength = result->size;
+		ctxt->doc = result->doc;
 		ctxt->subscription = subscription;
 
 		/* try to parse the feed */
+		debug_span_begin ("feed parse");
+		debug_span_arg_int ("bytes", result->size);
+		parseStart = g_get_monotonic_time ();
 		feed_parse (ctxt);
+		timings->parse = g_get_monotonic_time () - parseStart;
+		metrics_record (METRIC_FEED_PARSE, timings->parse);
+		debug_span_arg_int ("items", g_list_length (ctxt->items));
+		debug_span_end ();
 		
 		if (ctxt->failed) {
 			/* No feed found, display an error */
@@ -325,10 +335,12 @@ feed_process_update_result (subscriptionPtr subscription, const struct updateRes
 			node->available = TRUE;
 			
 			/* merge the resulting items into the node's item set */
+			mergeStart = g_get_monotonic_time ();
 			itemSet = node_get_itemset (node);
 			node->newCount = itemset_merge_items (itemSet, ctxt->items, ctxt->feed->valid, ctxt->feed->markAsRead);
 			itemlist_merge_itemset (itemSet);
 			itemset_free (itemSet);
+			timings->merge = g_get_monotonic_time () - mergeStart;
 		
 			/* restore user defined properties if necessary */
 			if ((flags & FEED_REQ_RESET_TITLE) && ctxt->title)
@@ -32,6 +32,10 @@
 
 static GSList *feedHandlers = NULL;	/**< list of available parser implementations */
 
+/* Item strings are allocated from arena blocks of this size,
+   longer strings (like large HTML descriptions) get their own block */
+#define FEED_PARSER_ARENA_SIZE	65536
+
 struct feed_type {
 	gint id_num;
 	gchar *id_str;
@@ -87,6 +91,8 @@ feed_create_parser_ctxt (void)
 
 	ctxt = g_new0 (struct feedParserCtxt, 1);
 	ctxt->tmpdata = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+	ctxt->dispatch = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)g_hash_table_destroy);
+	ctxt->arena = g_string_chunk_new (FEED_PARSER_ARENA_SIZE);
 	return ctxt;
 }
 
@@ -96,11 +102,101 @@ feed_free_parser_ctxt (feedParserCtxtPtr ctxt)
 	if (ctxt) {
 		/* Don't free the itemset! */
 		g_hash_table_destroy (ctxt->tmpdata);
+		g_hash_table_destroy (ctxt->dispatch);
+		g_string_chunk_free (ctxt->arena);
 		g_free (ctxt->title);
 		g_free (ctxt);
 	}
 }
 
+/* The dispatch caches hold one hash table per names list or namespace
+   handler table, all of them keyed by pointers into the current document. */
+static GHashTable *
+feed_parser_ctxt_get_cache (feedParserCtxtPtr ctxt, gconstpointer owner, gboolean *created)
+{
+	GHashTable	*cache;
+
+	cache = g_hash_table_lookup (ctxt->dispatch, owner);
+	*created = !cache;
+	if (!cache) {
+		cache = g_hash_table_new (g_direct_hash, g_direct_equal);
+		g_hash_table_insert (ctxt->dispatch, (gpointer)owner, cache);
+	}
+
+	return cache;
+}
+
+gint
+feed_parser_ctxt_element_id (feedParserCtxtPtr ctxt, const gchar **names, xmlNodePtr cur)
+{
+	GHashTable	*cache;
+	xmlDictPtr	dict = cur->doc?cur->doc->dict:NULL;
+	gboolean	created;
+	guint		i;
+
+	if (!dict) {
+		/* No interned names without dictionary, compare strings */
+		for (i = 0; names[i]; i++)
+			if (xmlStrEqual (cur->name, BAD_CAST names[i]))
+				return i;
+		return -1;
+	}
+
+	cache = feed_parser_ctxt_get_cache (ctxt, names, &created);
+	if (created) {
+		for (i = 0; names[i]; i++)
+			g_hash_table_insert (cache, (gpointer)xmlDictLookup (dict, BAD_CAST names[i], -1), GINT_TO_POINTER (i + 1));
+	}
+
+	return GPOINTER_TO_INT (g_hash_table_lookup (cache, cur->name)) - 1;
+}
+
+gint
+feed_parser_ctxt_ns_id (feedParserCtxtPtr ctxt, const gchar **uris, xmlNodePtr cur)
+{
+	GHashTable	*cache;
+	gpointer	id;
+	gboolean	created;
+	gint		i;
+
+	if (!cur->ns || !cur->ns->href)
+		return -1;
+
+	cache = feed_parser_ctxt_get_cache (ctxt, uris, &created);
+	id = g_hash_table_lookup (cache, cur->ns);
+	if (!id) {
+		for (i = 0; uris[i]; i++)
+			if (xmlStrEqual (cur->ns->href, BAD_CAST uris[i]))
+				break;
+		id = GINT_TO_POINTER (uris[i]?i + 1:-1);
+		g_hash_table_insert (cache, cur->ns, id);
+	}
+
+	return (GPOINTER_TO_INT (id) > 0)?GPOINTER_TO_INT (id) - 1:-1;
+}
+
+NsHandler *
+feed_parser_ctxt_ns_handler (feedParserCtxtPtr ctxt, xmlNodePtr cur, GHashTable *uriTable, GHashTable *prefixTable)
+{
+	GHashTable	*cache;
+	gpointer	nsh = NULL;
+	gboolean	created;
+
+	if (!cur->ns)
+		return NULL;
+
+	cache = feed_parser_ctxt_get_cache (ctxt, uriTable, &created);
+	if (!g_hash_table_lookup_extended (cache, cur->ns, NULL, &nsh)) {
+		if (cur->ns->href)
+			nsh = g_hash_table_lookup (uriTable, cur->ns->href);
+		if (!nsh && cur->ns->prefix)
+			nsh = g_hash_table_lookup (prefixTable, cur->ns->prefix);
+		g_hash_table_insert (cache, cur->ns, nsh);
+	}
+
+	return (NsHandler *)nsh;
+}
+
 /**
  * This function tries to find a feed link for a given HTTP URI. It
  * tries to download it. If it finds a valid feed source it parses
@@ -151,6 +247,7 @@ gboolean
 feed_parse (feedParserCtxtPtr ctxt)
 {
 	xmlNodePtr	cur;
+	xmlDocPtr	filterDoc = ctxt->doc;	/* owned by the update result */
 	gboolean	success = FALSE;
 
 	debug_enter("feed_parse");
@@ -235,9 +332,11 @@ feed_parse (feedParserCtxtPtr ctxt)
 	}
 	
 	if(ctxt->doc) {
-		xmlFreeDoc(ctxt->doc);
+		if(ctxt->doc != filterDoc)
+			xmlFreeDoc(ctxt->doc);
 		ctxt->doc = NULL;
 	}
+	g_hash_table_remove_all (ctxt->dispatch);
 		
 	debug_exit("feed_parse");
 	
@@ -39,10 +39,15 @@ typedef struct feedParserCtxt {
 	gchar		*data;		/**< data buffer to parse */
 	gsize		dataLength;	/**< length of the data buffer */
 
-	xmlDocPtr	doc;		/**< the parsed data buffer */
+	xmlDocPtr	doc;		/**< the parsed data buffer (or a preset XSLT filter result, not owned) */
 	gboolean	failed;		/**< TRUE if parsing failed because feed type could not be detected */
+
+	GHashTable	*dispatch;	/**< per document element and namespace lookup caches */
+	GStringChunk	*arena;		/**< string arena for the parsed items, see item_promote() */
 } *feedParserCtxtPtr;
 
+struct NsHandler;
+
 
 /**
  * Function type which parses the given feed data.
@@ -78,12 +83,53 @@ feedParserCtxtPtr feed_create_parser_ctxt (void);
 
 /**
  * Frees the given parser context. Note: it does
- * not free the list of new items!
+ * not free the list of new items! Items still in use
+ * must have been promoted with item_promote() before.
  *
  * @param ctxt		the feed parsing context
  */
 void feed_free_parser_ctxt (feedParserCtxtPtr ctxt);
 
+/**
+ * Returns the id of an element for dispatching on its name. On first
+ * use for a document all names are interned in the document dictionary,
+ * afterwards a lookup only hashes the element name pointer and costs
+ * the same no matter how many names there are.
+ *
+ * @param ctxt		the feed parsing context
+ * @param names		NULL terminated list of element names (the id is the index)
+ * @param cur		the element
+ *
+ * @returns the index of the element name in names or -1
+ */
+gint feed_parser_ctxt_element_id (feedParserCtxtPtr ctxt, const gchar **names, xmlNodePtr cur);
+
+/**
+ * Returns the id of the namespace of an element. The namespace
+ * URI is compared only once per namespace declaration of a document.
+ *
+ * @param ctxt		the feed parsing context
+ * @param uris		NULL terminated list of namespace URIs (the id is the index)
+ * @param cur		the element
+ *
+ * @returns the index of the namespace URI in uris or -1
+ */
+gint feed_parser_ctxt_ns_id (feedParserCtxtPtr ctxt, const gchar **uris, xmlNodePtr cur);
+
+/**
+ * Returns the namespace handler for an element. The handler is
+ * looked up by namespace URI and then by prefix only once per
+ * namespace declaration of a document.
+ *
+ * @param ctxt		the feed parsing context
+ * @param cur		the element
+ * @param uriTable	namespace handlers by URI
+ * @param prefixTable	namespace handlers by prefix
+ *
+ * @returns the namespace handler or NULL
+ */
+struct NsHandler * feed_parser_ctxt_ns_handler (feedParserCtxtPtr ctxt, xmlNodePtr cur, GHashTable *uriTable, GHashTable *prefixTable);
+
 /**
  * Lookup a feed type string from the feed type id.
  *
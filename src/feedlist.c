@@ -20,6 +20,7 @@
  */
 
 #include <libxml/uri.h>
+#include <unistd.h>
 
 #include "comments.h"
 #include "common.h"
@@ -38,9 +39,11 @@
 #include "ui/itemview.h"
 #include "ui/liferea_shell.h"
 #include "ui/feed_list_node.h"
+#include "ui/ui_update.h"
 #include "fl_sources/node_source.h"
 
 static void feedlist_save	(void);
+static void feedlist_snapshot_save (void);
 
 #define FEEDLIST_GET_PRIVATE(object)(G_TYPE_INSTANCE_GET_PRIVATE ((object), FEEDLIST_TYPE, FeedListPrivate))
 
@@ -72,6 +75,11 @@ static guint feedlist_signals[LAST_SIGNAL] = { 0 };
 static GObjectClass *parent_class = NULL;
 FeedList *feedlist = NULL;
 
+/* feed list counter snapshot state (see feedlist_snapshot_load()) */
+static GHashTable	*snapshot = NULL;		/*<< node id -> snapshotCounters */
+static GSList		*snapshotValidation = NULL;	/*<< ids of nodes still to validate */
+static guint		snapshotValidationTimer = 0;
+
 G_DEFINE_TYPE (FeedList, feedlist, G_TYPE_OBJECT);
 
 static void
@@ -96,9 +104,16 @@ feedlist_finalize (GObject *object)
 		g_source_remove (feedlist->priv->saveTimer);
 		feedlist->priv->saveTimer = 0;
 	}
+	if (snapshotValidationTimer) {
+		g_source_remove (snapshotValidationTimer);
+		snapshotValidationTimer = 0;
+	}
+	g_slist_free_full (snapshotValidation, g_free);
+	snapshotValidation = NULL;
 
 	/* Enforce synchronous save upon exit */
 	feedlist_save ();		
+	feedlist_snapshot_save ();
 
 	/* Save last selection for next start */
 	if (feedlist->priv->selectedNode)
@@ -173,17 +188,136 @@ on_network_status_changed (gpointer instance, gboolean online, gpointer data)
 	if (online) feedlist_auto_update (NULL);
 }
 
+/* Node counter snapshot
+
+   To show the feed list with correct unread counters immediately on
+   startup the counters of all nodes are saved to a snapshot file at
+   shutdown. On the next start the snapshot is used instead of
+   counting the items of each node in the DB. The counters are then
+   validated against the DB in the background. The snapshot file is
+   removed once it is loaded, so after a crash the counters are
+   calculated at startup as before. */
+
+/** number of nodes to validate per idle callback */
+#define FEEDLIST_SNAPSHOT_VALIDATE_BATCH	25
+
+typedef struct snapshotCounters {
+	guint	unreadCount;
+	guint	itemCount;
+} snapshotCounters;
+
+static gchar *
+feedlist_snapshot_get_filename (void)
+{
+	return common_create_cache_filename (NULL, "feedlist", "snapshot");
+}
+
+static void
+feedlist_snapshot_write_node (nodePtr node, gpointer user_data)
+{
+	g_string_append_printf ((GString *)user_data, "%s %u %u\n", node->id, node->unreadCount, node->itemCount);
+
+	node_foreach_child_data (node, feedlist_snapshot_write_node, user_data);
+}
+
+static void
+feedlist_snapshot_save (void)
+{
+	GString	*buffer = g_string_new (NULL);
+	gchar	*filename = feedlist_snapshot_get_filename ();
+	GError	*error = NULL;
+
+	feedlist_snapshot_write_node (ROOTNODE, buffer);
+
+	if (!g_file_set_contents (filename, buffer->str, buffer->len, &error)) {
+		g_warning ("Could not save feed list snapshot %s: %s", filename, error->message);
+		g_error_free (error);
+	}
+
+	g_free (filename);
+	g_string_free (buffer, TRUE);
+}
+
+static void
+feedlist_snapshot_load (void)
+{
+	gchar	*filename = feedlist_snapshot_get_filename ();
+	gchar	*contents = NULL;
+	gchar	**lines, **iter;
+
+	if (g_file_get_contents (filename, &contents, NULL, NULL)) {
+		/* Never use the same snapshot twice */
+		unlink (filename);
+
+		snapshot = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+		lines = g_strsplit (contents, "\n", -1);
+		for (iter = lines; *iter; iter++) {
+			gchar			id[64];
+			snapshotCounters	counters, *copy;
+
+			if (3 != sscanf (*iter, "%63s %u %u", id, &counters.unreadCount, &counters.itemCount))
+				continue;
+
+			copy = g_new (snapshotCounters, 1);
+			*copy = counters;
+			g_hash_table_insert (snapshot, g_strdup (id), copy);
+		}
+		g_strfreev (lines);
+		g_free (contents);
+
+		debug1 (DEBUG_CACHE, "loaded counters of %u nodes from feed list snapshot", g_hash_table_size (snapshot));
+	}
+
+	g_free (filename);
+}
+
+static gboolean
+feedlist_snapshot_validate (gpointer user_data)
+{
+	guint	i;
+
+	for (i = 0; snapshotValidation && i < FEEDLIST_SNAPSHOT_VALIDATE_BATCH; i++) {
+		gchar	*id = (gchar *)snapshotValidation->data;
+		nodePtr	node = node_from_id (id);
+
+		/* Updates the feed list if the snapshot was wrong */
+		if (node)
+			node_update_counters (node);
+
+		snapshotValidation = g_slist_delete_link (snapshotValidation, snapshotValidation);
+		g_free (id);
+	}
+
+	if (snapshotValidation)
+		return TRUE;
+
+	snapshotValidationTimer = 0;
+	debug0 (DEBUG_CACHE, "feed list snapshot validation finished");
+	return FALSE;
+}
+
 /* This method is used to initialize the node states in the feed list */
 static void
 feedlist_init_node (nodePtr node) 
 {
+	snapshotCounters	*counters = NULL;
+
 	if (node->expanded)
 		feed_list_node_set_expansion (node, TRUE);
 	
 	if (node->subscription)
 		db_subscription_load (node->subscription);
-		
-	node_update_counters (node);
+
+	if (snapshot)
+		counters = g_hash_table_lookup (snapshot, node->id);
+
+	if (counters) {
+		node->unreadCount = counters->unreadCount;
+		node->itemCount = counters->itemCount;
+		snapshotValidation = g_slist_prepend (snapshotValidation, g_strdup (node->id));
+	} else {
+		node_update_counters (node);
+	}
 	feed_list_node_update (node->id);	/* Necessary to initially set folder unread counters */
 	
 	node_foreach_child (node, feedlist_init_node);
@@ -206,10 +340,21 @@ feedlist_init (FeedList *fl)
 	/* 2. Set up a root node and import the feed list source structure. */
 	debug0 (DEBUG_CACHE, "Setting up root node");
 	ROOTNODE = node_source_setup_root ();
+	debug_startup_phase ("feed list import");
 
 	/* 3. Ensure folder expansion and unread count*/
 	debug0 (DEBUG_CACHE, "Initializing node state");
+	feedlist_snapshot_load ();
 	feedlist_foreach (feedlist_init_node);
+	if (snapshot) {
+		g_hash_table_destroy (snapshot);
+		snapshot = NULL;
+
+		/* The validation list is in reverse tree order, so child
+		   nodes are validated before their parents */
+		snapshotValidationTimer = g_idle_add (feedlist_snapshot_validate, NULL);
+	}
+	debug_startup_phase ("node state setup");
 
 	/* 4. Check if feeds do need updating. */
 	debug0 (DEBUG_UPDATE, "Performing initial feed update");
@@ -226,9 +371,11 @@ feedlist_init (FeedList *fl)
 		debug0 (DEBUG_UPDATE, "initial update: resetting feed counter");
 		feedlist_reset_update_counters (NULL);
 	}
+	debug_startup_phase ("initial feed update");
 
 	/* 5. Purge old nodes from the database */
 	db_node_cleanup (feedlist_get_root ());
+	debug_startup_phase ("DB node cleanup");
 
 	/* 6. Start automatic updating */
 	feedlist->priv->autoUpdateTimer = g_timeout_add_seconds (10, feedlist_auto_update, NULL);
@@ -471,6 +618,7 @@ feedlist_node_removed (nodePtr node)
 	node_remove (node);
 
 	feed_list_node_remove_node (node);
+	ui_update_remove_node (node);
 
 	node->parent->children = g_slist_remove (node->parent->children, node);
 
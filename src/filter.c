@@ -0,0 +1,355 @@
+/**
+ * @file filter.c  persistent conversion filter processes
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "filter.h"
+
+#include <glib-unix.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "common.h"
+#include "debug.h"
+
+#define FILTER_READ_SIZE	65536
+
+typedef struct filterCoprocess {
+	gchar		*cmd;		/**< the filter command */
+	GMutex		lock;		/**< serializes the documents passed */
+	GPid		pid;		/**< process id (or 0 if not running) */
+	gint		in;		/**< stdin of the filter */
+	gint		out;		/**< stdout of the filter */
+} *filterCoprocessPtr;
+
+typedef enum {
+	FILTER_EXCHANGE_OK,
+	FILTER_EXCHANGE_DIED,		/**< the filter exited, worth a restart */
+	FILTER_EXCHANGE_FAILED		/**< timeout or protocol error */
+} filterExchangeResult;
+
+/** running coprocesses (command -> filterCoprocessPtr) */
+static GHashTable *coprocesses = NULL;
+static GMutex coprocessesLock;
+
+const gchar *
+filter_get_coprocess_cmd (const gchar *filtercmd)
+{
+	if (!filtercmd || !g_str_has_prefix (filtercmd, FILTER_COPROCESS_PREFIX))
+		return NULL;
+
+	return filtercmd + strlen (FILTER_COPROCESS_PREFIX);
+}
+
+/* Writes to the filter without raising SIGPIPE when it has exited.
+   Instead of changing the process-wide disposition, which children
+   would inherit, SIGPIPE is blocked for the calling thread during the
+   write and a SIGPIPE raised by the write is discarded. */
+static gssize
+filter_coprocess_write (gint fd, const gchar *data, gsize length)
+{
+	sigset_t	sigpipe, pending, old;
+	gboolean	wasPending;
+	gssize		n;
+	gint		savedErrno;
+
+	sigemptyset (&sigpipe);
+	sigaddset (&sigpipe, SIGPIPE);
+
+	sigpending (&pending);
+	wasPending = sigismember (&pending, SIGPIPE);
+	pthread_sigmask (SIG_BLOCK, &sigpipe, &old);
+
+	n = write (fd, data, length);
+	savedErrno = errno;
+
+	if (n < 0 && EPIPE == savedErrno && !wasPending) {
+		struct timespec	zero = { 0, 0 };
+
+		while (sigtimedwait (&sigpipe, NULL, &zero) < 0 && EINTR == errno);
+	}
+
+	pthread_sigmask (SIG_SETMASK, &old, NULL);
+	errno = savedErrno;
+
+	return n;
+}
+
+static gboolean
+filter_coprocess_start (filterCoprocessPtr cp, gchar **error)
+{
+	gchar	*argv[] = { "/bin/sh", "-c", cp->cmd, NULL };
+	GError	*err = NULL;
+
+	debug1 (DEBUG_UPDATE, "starting filter coprocess \"%s\"", cp->cmd);
+
+	if (!g_spawn_async_with_pipes (NULL, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD,
+	                               NULL, NULL,
+	                               &cp->pid, &cp->in, &cp->out, NULL, &err)) {
+		*error = g_strdup_printf (_("Could not start filter \"%s\" (%s)"), cp->cmd, err->message);
+		g_error_free (err);
+		cp->pid = 0;
+		return FALSE;
+	}
+
+	g_unix_set_fd_nonblocking (cp->in, TRUE, NULL);
+	g_unix_set_fd_nonblocking (cp->out, TRUE, NULL);
+
+	return TRUE;
+}
+
+static void
+filter_coprocess_stop (filterCoprocessPtr cp)
+{
+	if (!cp->pid)
+		return;
+
+	debug1 (DEBUG_UPDATE, "stopping filter coprocess \"%s\"", cp->cmd);
+
+	close (cp->in);
+	close (cp->out);
+	kill (cp->pid, SIGKILL);
+	waitpid (cp->pid, NULL, 0);
+	g_spawn_close_pid (cp->pid);
+	cp->pid = 0;
+}
+
+/* Parses the length prefix of a response, returns -1 while incomplete
+   and -2 on garbage, otherwise the offset of the document */
+static gssize
+filter_coprocess_parse_header (GString *response, gsize *length)
+{
+	gsize	i;
+
+	for (i = 0; i < response->len; i++) {
+		if ('\n' == response->str[i])
+			break;
+		if (!g_ascii_isdigit (response->str[i]) || i > 18)
+			return -2;
+	}
+	if (i == response->len)
+		return -1;
+	if (0 == i)
+		return -2;
+
+	*length = (gsize)g_ascii_strtoull (response->str, NULL, 10);
+	return i + 1;
+}
+
+/* Writes the request and reads the response at the same time, as a
+   filter might start answering before it has read the whole document */
+static filterExchangeResult
+filter_coprocess_exchange (filterCoprocessPtr cp, const gchar *data, gsize length,
+                           GString *response, gssize *offset, guint timeout, gchar **error)
+{
+	gchar		*header, buf[FILTER_READ_SIZE];
+	const gchar	*chunks[2];
+	gsize		chunkLengths[2], chunk = 0, written = 0, resultLength = 0;
+	gint64		deadline = g_get_monotonic_time () + (gint64)timeout * 1000;
+
+	header = g_strdup_printf ("%" G_GSIZE_FORMAT "\n", length);
+	chunks[0] = header;
+	chunkLengths[0] = strlen (header);
+	chunks[1] = data;
+	chunkLengths[1] = length;
+
+	*offset = -1;
+	while (TRUE) {
+		GPollFD	fds[2];
+		gint	nfds = 0, remaining;
+
+		remaining = (gint)((deadline - g_get_monotonic_time ()) / 1000);
+		if (remaining <= 0) {
+			*error = g_strdup_printf (_("Filter \"%s\" did not respond in time"), cp->cmd);
+			break;
+		}
+
+		memset (fds, 0, sizeof (fds));
+		fds[nfds].fd = cp->out;
+		fds[nfds++].events = G_IO_IN | G_IO_HUP | G_IO_ERR;
+		if (chunk < 2) {
+			fds[nfds].fd = cp->in;
+			fds[nfds++].events = G_IO_OUT | G_IO_ERR;
+		}
+
+		if (g_poll (fds, nfds, remaining) < 0 && EINTR != errno) {
+			*error = g_strdup_printf (_("Polling filter \"%s\" failed (%s)"), cp->cmd, g_strerror (errno));
+			break;
+		}
+
+		if (nfds > 1 && fds[1].revents) {
+			gssize n = filter_coprocess_write (cp->in, chunks[chunk] + written, chunkLengths[chunk] - written);
+			if (n < 0 && EAGAIN != errno && EINTR != errno) {
+				g_free (header);
+				*error = g_strdup_printf (_("Filter \"%s\" exited"), cp->cmd);
+				return FILTER_EXCHANGE_DIED;
+			}
+			if (n > 0)
+				written += n;
+			while (chunk < 2 && written == chunkLengths[chunk]) {
+				chunk++;
+				written = 0;
+			}
+		}
+
+		if (fds[0].revents) {
+			gssize n = read (cp->out, buf, sizeof (buf));
+			if (0 == n) {
+				g_free (header);
+				*error = g_strdup_printf (_("Filter \"%s\" exited"), cp->cmd);
+				return FILTER_EXCHANGE_DIED;
+			}
+			if (n < 0 && EAGAIN != errno && EINTR != errno) {
+				*error = g_strdup_printf (_("Reading from filter \"%s\" failed (%s)"), cp->cmd, g_strerror (errno));
+				break;
+			}
+			if (n > 0)
+				g_string_append_len (response, buf, n);
+
+			if (*offset < 0) {
+				*offset = filter_coprocess_parse_header (response, &resultLength);
+				if (-2 == *offset) {
+					*error = g_strdup_printf (_("Filter \"%s\" sent an invalid length prefix"), cp->cmd);
+					break;
+				}
+			}
+
+			if (*offset >= 0 && response->len >= (gsize)*offset + resultLength) {
+				if (chunk < 2) {
+					*error = g_strdup_printf (_("Filter \"%s\" answered before reading the whole document"), cp->cmd);
+					break;
+				}
+				if (response->len > (gsize)*offset + resultLength) {
+					*error = g_strdup_printf (_("Filter \"%s\" sent more data than announced"), cp->cmd);
+					break;
+				}
+
+				g_free (header);
+				return FILTER_EXCHANGE_OK;
+			}
+		}
+	}
+
+	g_free (header);
+	return FILTER_EXCHANGE_FAILED;
+}
+
+static filterCoprocessPtr
+filter_coprocess_get (const gchar *cmd)
+{
+	filterCoprocessPtr	cp;
+
+	g_mutex_lock (&coprocessesLock);
+	if (!coprocesses)
+		coprocesses = g_hash_table_new (g_str_hash, g_str_equal);
+
+	cp = g_hash_table_lookup (coprocesses, cmd);
+	if (!cp) {
+		cp = g_new0 (struct filterCoprocess, 1);
+		cp->cmd = g_strdup (cmd);
+		g_mutex_init (&cp->lock);
+		g_hash_table_insert (coprocesses, cp->cmd, cp);
+	}
+	g_mutex_unlock (&coprocessesLock);
+
+	return cp;
+}
+
+gchar *
+filter_coprocess_run (const gchar *cmd, const gchar *data, gsize length,
+                      gsize *resultLength, guint timeout, gchar **error)
+{
+	filterCoprocessPtr	cp;
+	GString			*response;
+	gssize			offset;
+	gchar			*result = NULL;
+	gint			attempt;
+
+	*error = NULL;
+	*resultLength = 0;
+	cp = filter_coprocess_get (cmd);
+	response = g_string_sized_new (length + 32);
+
+	g_mutex_lock (&cp->lock);
+	for (attempt = 0; attempt < 2; attempt++) {
+		gboolean		fresh = FALSE;
+		filterExchangeResult	status;
+
+		if (!cp->pid) {
+			if (!filter_coprocess_start (cp, error))
+				break;
+			fresh = TRUE;
+		}
+
+		g_string_truncate (response, 0);
+		status = filter_coprocess_exchange (cp, data, length, response, &offset, timeout, error);
+		if (FILTER_EXCHANGE_OK == status) {
+			*resultLength = response->len - offset;
+			result = g_malloc (*resultLength + 1);
+			memcpy (result, response->str + offset, *resultLength);
+			result[*resultLength] = '\0';
+			break;
+		}
+
+		/* Never keep a filter in an unknown state */
+		filter_coprocess_stop (cp);
+
+		/* A filter that exited since the last document gets another chance */
+		if (FILTER_EXCHANGE_DIED != status || fresh)
+			break;
+
+		debug1 (DEBUG_UPDATE, "restarting filter coprocess \"%s\"", cp->cmd);
+		g_free (*error);
+		*error = NULL;
+	}
+	g_mutex_unlock (&cp->lock);
+
+	g_string_free (response, TRUE);
+
+	return result;
+}
+
+void
+filter_deinit (void)
+{
+	GHashTableIter		iter;
+	filterCoprocessPtr	cp;
+
+	g_mutex_lock (&coprocessesLock);
+	if (coprocesses) {
+		g_hash_table_iter_init (&iter, coprocesses);
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&cp)) {
+			g_mutex_lock (&cp->lock);
+			filter_coprocess_stop (cp);
+			g_mutex_unlock (&cp->lock);
+			g_mutex_clear (&cp->lock);
+			g_free (cp->cmd);
+			g_free (cp);
+		}
+		g_hash_table_destroy (coprocesses);
+		coprocesses = NULL;
+	}
+	g_mutex_unlock (&coprocessesLock);
+}
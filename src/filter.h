@@ -0,0 +1,72 @@
+/**
+ * @file filter.h  persistent conversion filter processes
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _FILTER_H
+#define _FILTER_H
+
+#include <glib.h>
+
+/*
+ * Conversion filters prefixed with "coprocess:" are started once and
+ * kept running. Instead of one document per process they read any
+ * number of documents from stdin, each framed as
+ *
+ *   <decimal length>\n<length bytes>
+ *
+ * and answer each with a converted document framed the same way on
+ * stdout. A filter that dies is restarted with the next document, a
+ * filter that does not answer in time is killed.
+ */
+
+#define FILTER_COPROCESS_PREFIX		"coprocess:"
+#define FILTER_COPROCESS_TIMEOUT	30000	/* ms per document */
+
+/**
+ * Checks whether a filter command uses the coprocess protocol.
+ *
+ * @param filtercmd	the filter command of a subscription
+ *
+ * @returns the command to run (without prefix) or NULL for one-shot filters
+ */
+const gchar * filter_get_coprocess_cmd (const gchar *filtercmd);
+
+/**
+ * Passes a document through the coprocess running the given command,
+ * starting the coprocess if needed. Can be called from any thread,
+ * documents for the same command are processed one after another.
+ *
+ * @param cmd		the filter command (without prefix)
+ * @param data		the document
+ * @param length	length of the document
+ * @param resultLength	returns the length of the result
+ * @param timeout	maximum time to wait for the result (in ms)
+ * @param error		returns an error message on failure (to be free'd using g_free())
+ *
+ * @returns the NUL terminated result (to be free'd using g_free()) or NULL
+ */
+gchar * filter_coprocess_run (const gchar *cmd, const gchar *data, gsize length,
+                              gsize *resultLength, guint timeout, gchar **error);
+
+/**
+ * Stops all coprocesses.
+ */
+void filter_deinit (void);
+
+#endif
@@ -0,0 +1,196 @@
+/**
+ * @file google_reader_api_sync.c  Google Reader API incremental sync
+ * 
+ * Copyright (C) 2013-2014 Lars Windolf <lars.windolf@gmx.de>
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. 
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "google_reader_api_sync.h"
+
+#include <string.h>
+
+#include "common.h"
+#include "db.h"
+#include "debug.h"
+#include "json.h"
+#include "metadata.h"
+#include "update.h"
+#include "xml.h"
+#include "fl_sources/node_source.h"
+
+typedef struct syncCtxt {
+	nodePtr		root;
+	GHashTable	*pending;	/**< subscription URL -> newest item timestamp */
+	GHashTable	*streams;	/**< stream id -> node */
+} *syncCtxtPtr;
+
+static void
+google_reader_api_sync_collect_streams (nodePtr node, GHashTable *streams, const gchar *feedIdKey)
+{
+	GSList *iter;
+
+	if (node->subscription && node != node->source->root) {
+		const gchar *id = metadata_list_get (node->subscription->metadata, feedIdKey);
+
+		if (id)
+			g_hash_table_insert (streams, g_strdup (id), node);
+		else
+			g_hash_table_insert (streams, g_strdup_printf ("feed/%s", node->subscription->source), node);
+	}
+
+	for (iter = node->children; iter; iter = g_slist_next (iter))
+		google_reader_api_sync_collect_streams ((nodePtr)iter->data, streams, feedIdKey);
+}
+
+static void
+google_reader_api_sync_check_stream (syncCtxtPtr ctxt, const gchar *id, const gchar *newestItemTimestamp)
+{
+	nodePtr		node;
+	const gchar	*last;
+
+	if (!id || !newestItemTimestamp)
+		return;
+
+	node = g_hash_table_lookup (ctxt->streams, id);
+	if (!node)
+		return;
+
+	last = metadata_list_get (node->subscription->metadata, GOOGLE_READER_API_SYNC_NEWEST_ITEM);
+	if (last && g_str_equal (last, newestItemTimestamp))
+		return;
+
+	debug3 (DEBUG_UPDATE, "GoogleReaderAPI: updating %s [old timestamp %s, timestamp %s]", id, last, newestItemTimestamp);
+	g_hash_table_insert (ctxt->pending, g_strdup (node->subscription->source), g_strdup (newestItemTimestamp));
+	subscription_update (node->subscription, 0);
+}
+
+static void
+google_reader_api_sync_xml_helper (xmlNodePtr match, gpointer userdata)
+{
+	xmlChar	*id, *newestItemTimestamp;
+
+	id = xmlNodeGetContent (xpath_find (match, "./string[@name='id']"));
+	newestItemTimestamp = xmlNodeGetContent (xpath_find (match, "./number[@name='newestItemTimestampUsec']"));
+
+	google_reader_api_sync_check_stream ((syncCtxtPtr)userdata, (gchar *)id, (gchar *)newestItemTimestamp);
+
+	xmlFree (newestItemTimestamp);
+	xmlFree (id);
+}
+
+static void
+google_reader_api_sync_json_helper (JsonArray *array, guint index, JsonNode *node, gpointer userdata)
+{
+	JsonNode	*timestamp = json_get_node (node, "newestItemTimestampUsec");
+	gchar		*newestItemTimestamp = NULL;
+
+	/* Depending on the service the timestamp is a string or a number */
+	if (timestamp && JSON_NODE_HOLDS_VALUE (timestamp)) {
+		if (json_node_get_value_type (timestamp) == G_TYPE_STRING)
+			newestItemTimestamp = g_strdup (json_node_get_string (timestamp));
+		else
+			newestItemTimestamp = g_strdup_printf ("%" G_GINT64_FORMAT, json_node_get_int (timestamp));
+	}
+
+	google_reader_api_sync_check_stream ((syncCtxtPtr)userdata, json_get_string (node, "id"), newestItemTimestamp);
+
+	g_free (newestItemTimestamp);
+}
+
+static void
+google_reader_api_sync_unread_count_cb (const struct updateResult* const result, gpointer userdata, updateFlags flags)
+{
+	syncCtxtPtr	ctxt = (syncCtxtPtr) userdata;
+
+	if (!result->data || result->httpstatus != 200) {
+		debug0 (DEBUG_UPDATE, "GoogleReaderAPI: Unable to get unread counts, this update is aborted.");
+	} else if (result->data[0] == '{') {
+		JsonParser *parser = json_parser_new ();
+
+		if (json_parser_load_from_data (parser, result->data, -1, NULL)) {
+			JsonNode *counts = json_get_node (json_parser_get_root (parser), "unreadcounts");
+			if (counts && JSON_NODE_TYPE (counts) == JSON_NODE_ARRAY)
+				json_array_foreach_element (json_node_get_array (counts), google_reader_api_sync_json_helper, ctxt);
+		} else {
+			debug0 (DEBUG_UPDATE, "GoogleReaderAPI: Invalid JSON returned on unread count request!");
+		}
+
+		g_object_unref (parser);
+	} else {
+		xmlDocPtr doc = xml_parse (result->data, result->size, NULL);
+
+		if (doc) {
+			xpath_foreach_match (xmlDocGetRootElement (doc),
+			                     "/object/list[@name='unreadcounts']/object",
+			                     google_reader_api_sync_xml_helper, ctxt);
+			xmlFreeDoc (doc);
+		} else {
+			debug0 (DEBUG_UPDATE, "GoogleReaderAPI: The XML failed to parse, maybe the session has expired.");
+		}
+	}
+
+	g_hash_table_destroy (ctxt->streams);
+	g_free (ctxt);
+}
+
+void
+google_reader_api_sync_update (nodePtr root, GHashTable *pending, const gchar *feedIdKey)
+{
+	updateRequestPtr	request;
+	syncCtxtPtr		ctxt;
+
+	ctxt = g_new0 (struct syncCtxt, 1);
+	ctxt->root = root;
+	ctxt->pending = pending;
+	ctxt->streams = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	google_reader_api_sync_collect_streams (root, ctxt->streams, feedIdKey);
+
+	request = update_request_new ();
+	request->updateState = update_state_copy (root->subscription->updateState);
+	request->options = update_options_copy (root->subscription->updateOptions);
+	update_request_set_source (request, root->source->type->api.unread_count);
+	update_request_set_auth_value (request, root->source->authToken);
+
+	update_execute_request (root->data, request, google_reader_api_sync_unread_count_cb, ctxt, 0);
+}
+
+gint64
+google_reader_api_sync_get_watermark (subscriptionPtr subscription, GHashTable *pending)
+{
+	const gchar *last;
+
+	if (!g_hash_table_lookup (pending, subscription->source))
+		return 0;
+
+	last = metadata_list_get (subscription->metadata, GOOGLE_READER_API_SYNC_NEWEST_ITEM);
+	if (!last)
+		return 0;
+
+	return g_ascii_strtoll (last, NULL, 10) / G_USEC_PER_SEC;
+}
+
+void
+google_reader_api_sync_commit (subscriptionPtr subscription, GHashTable *pending)
+{
+	const gchar *timestamp = g_hash_table_lookup (pending, subscription->source);
+
+	if (!timestamp)
+		return;
+
+	metadata_list_set (&subscription->metadata, GOOGLE_READER_API_SYNC_NEWEST_ITEM, timestamp);
+	g_hash_table_remove (pending, subscription->source);
+}
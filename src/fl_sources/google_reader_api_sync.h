@@ -0,0 +1,72 @@
+/**
+ * @file google_reader_api_sync.h  Google Reader API incremental sync
+ * 
+ * Copyright (C) 2013-2014 Lars Windolf <lars.windolf@gmx.de>
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. 
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _GOOGLE_READER_API_SYNC_H
+#define _GOOGLE_READER_API_SYNC_H
+
+#include <glib.h>
+
+#include "node.h"
+#include "subscription.h"
+
+/* The newest item timestamp of each stream as reported by the unread-count
+   endpoint is persisted in the subscription metadata once the stream was
+   fetched successfully. A quick update fetches only streams whose newest
+   item timestamp has changed since and uses the persisted one as the
+   "ot=" watermark so that only newer items cross the wire. */
+
+/** subscription metadata key of the persisted newest item timestamp */
+#define GOOGLE_READER_API_SYNC_NEWEST_ITEM "google-reader-newest-item-usec"
+
+/**
+ * Fetches the unread counts of the given Google Reader API source and
+ * triggers an update of all subscriptions that have new items.
+ *
+ * @param root		the node source root node
+ * @param pending	hash to remember new timestamps until the stream
+ *			update succeeds (subscription URL -> timestamp)
+ * @param feedIdKey	subscription metadata key holding the stream id
+ */
+void google_reader_api_sync_update (nodePtr root, GHashTable *pending, const gchar *feedIdKey);
+
+/**
+ * Returns the "ot=" watermark (in seconds) to use for fetching the given
+ * subscription. Only incremental updates triggered by
+ * google_reader_api_sync_update() have a watermark, all other updates
+ * fetch the full stream to sync item states.
+ *
+ * @param subscription	the subscription to update
+ * @param pending	the pending timestamp hash
+ *
+ * @returns the watermark or 0 if the full stream is to be fetched
+ */
+gint64 google_reader_api_sync_get_watermark (subscriptionPtr subscription, GHashTable *pending);
+
+/**
+ * To be called after a subscription stream was processed successfully.
+ * Persists the pending newest item timestamp of the subscription.
+ *
+ * @param subscription	the updated subscription
+ * @param pending	the pending timestamp hash
+ */
+void google_reader_api_sync_commit (subscriptionPtr subscription, GHashTable *pending);
+
+#endif
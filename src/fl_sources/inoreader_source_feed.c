@@ -30,6 +30,7 @@
 
 #include "feedlist.h"
 #include "google_reader_api_edit.h"
+#include "google_reader_api_sync.h"
 #include "inoreader_source.h"
 #include "subscription.h"
 #include "node.h"
@@ -64,13 +65,13 @@ inoreader_source_migrate_node(nodePtr node)
 {
 	/* scan the node for bad ID's, if so, brutally remove the node */
 	itemSetPtr itemset = node_get_itemset (node);
-	GList *iter = itemset->ids;
-	for (; iter; iter = g_list_next (iter)) {
-		itemPtr item = item_load (GPOINTER_TO_UINT (iter->data));
+	guint i;
+	for (i = 0; i < itemset->ids->len; i++) {
+		itemPtr item = item_load (g_array_index (itemset->ids, guint, i));
 		if (item && item->sourceId) {
 			if (!g_str_has_prefix(item->sourceId, "tag:google.com")) {
 				debug1(DEBUG_UPDATE, "Item with sourceId [%s] will be deleted.", item->sourceId);
-				db_item_remove(GPOINTER_TO_UINT(iter->data));
+				db_item_remove(g_array_index (itemset->ids, guint, i));
 			} 
 		}
 		if (item) item_unload (item);
@@ -87,44 +88,8 @@ inoreader_source_xml_unlink_node (xmlNodePtr node, gpointer data)
 	xmlFreeNode (node);
 }
 
-static itemPtr
-inoreader_source_load_item_from_sourceid (nodePtr node, gchar *sourceId, GHashTable *cache) 
-{
-	gpointer    ret = g_hash_table_lookup (cache, sourceId);
-	itemSetPtr  itemset;
-	int         num = g_hash_table_size (cache);
-	GList       *iter; 
-	itemPtr     item = NULL;
-
-	if (ret) return item_load (GPOINTER_TO_UINT (ret));
-
-	/* skip the top 'num' entries */
-	itemset = node_get_itemset (node);
-	iter = itemset->ids;
-	while (num--) iter = g_list_next (iter);
-
-	for (; iter; iter = g_list_next (iter)) {
-		item = item_load (GPOINTER_TO_UINT (iter->data));
-		if (item) {
-			if (item->sourceId) {
-				/* save to cache */
-				g_hash_table_insert (cache, g_strdup(item->sourceId), (gpointer) item->id);
-				if (g_str_equal (item->sourceId, sourceId)) {
-					itemset_free (itemset);
-					return item;
-				}
-			}
-			item_unload (item);
-		}
-	}
-
-	g_print ("Could not find item for %s!", sourceId);
-	itemset_free (itemset);
-	return NULL;
-}
-
 static void
-inoreader_source_item_retrieve_status (const xmlNodePtr entry, subscriptionPtr subscription, GHashTable *cache)
+inoreader_source_item_retrieve_status (const xmlNodePtr entry, subscriptionPtr subscription)
 {
 	xmlNodePtr      xml;
 	nodePtr         node = subscription->node;
@@ -158,7 +123,7 @@ inoreader_source_item_retrieve_status (const xmlNodePtr entry, subscriptionPtr s
 		return;
 	}
 
-	itemPtr item = inoreader_source_load_item_from_sourceid (node, id, cache);
+	itemPtr item = db_item_find_by_source_id (node, id);
 	if (item && item->sourceId) {
 		if (g_str_equal (item->sourceId, id) && !google_reader_api_edit_is_in_queue (node->source, id)) {
 			
@@ -173,11 +138,18 @@ inoreader_source_item_retrieve_status (const xmlNodePtr entry, subscriptionPtr s
 }
 
 static void
-inoreader_feed_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult* const result, updateFlags flags)
+inoreader_feed_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult* const result, updateTimingsPtr timings, updateFlags flags)
 {
-	
+	InoreaderSourcePtr	source = (InoreaderSourcePtr) node_source_root_from_node (subscription->node)->data;
+	gchar			*id, *newest;
+
 	debug_start_measurement (DEBUG_UPDATE);
 
+	/* Save the remote id and the sync timestamp as the feed parser
+	   drops all previous metadata */
+	id = g_strdup (metadata_list_get (subscription->metadata, "inoreader-feed-id"));
+	newest = g_strdup (metadata_list_get (subscription->metadata, GOOGLE_READER_API_SYNC_NEWEST_ITEM));
+
 	if (result->data) { 
 		updateResultPtr resultCopy;
 
@@ -210,18 +182,29 @@ inoreader_feed_subscription_process_update_result (subscriptionPtr subscription,
 		xmlFree (newXml);
 		xmlFreeDoc (doc);
 		
-		feed_get_subscription_type ()->process_update_result (subscription, resultCopy, flags);
+		feed_get_subscription_type ()->process_update_result (subscription, resultCopy, timings, flags);
 		update_result_free (resultCopy);
 	} else { 
-		feed_get_subscription_type ()->process_update_result (subscription, result, flags);
-		return ; 
+		feed_get_subscription_type ()->process_update_result (subscription, result, timings, flags);
 	}
 
+	if (id)
+		metadata_list_set (&subscription->metadata, "inoreader-feed-id", id);
+	if (newest)
+		metadata_list_set (&subscription->metadata, GOOGLE_READER_API_SYNC_NEWEST_ITEM, newest);
+	g_free (id);
+	g_free (newest);
+
+	if (!result->data)
+		return;
+
+	if (subscription->node->available)
+		google_reader_api_sync_commit (subscription, source->lastTimestampMap);
+
 	xmlDocPtr doc = xml_parse (result->data, result->size, NULL);
 	if (doc) {		
 		xmlNodePtr root = xmlDocGetRootElement (doc);
 		xmlNodePtr entry = root->children ; 
-		GHashTable *cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
 		while (entry) { 
 			if (!g_str_equal (entry->name, "entry")) {
@@ -229,11 +212,10 @@ inoreader_feed_subscription_process_update_result (subscriptionPtr subscription,
 				continue; /* not an entry */
 			}
 			
-			inoreader_source_item_retrieve_status (entry, subscription, cache);
+			inoreader_source_item_retrieve_status (entry, subscription);
 			entry = entry->next;
 		}
 		
-		g_hash_table_unref (cache);
 		xmlFreeDoc (doc);
 	} else { 
 		debug0 (DEBUG_UPDATE, "google_feed_subscription_process_update_result(): Couldn't parse XML!");
@@ -249,6 +231,7 @@ inoreader_feed_subscription_prepare_update_request (subscriptionPtr subscription
 {
 	debug0 (DEBUG_UPDATE, "preparing InoReader feed subscription for update\n");
 	nodePtr node = subscription->node; 
+	gint64 watermark;
 	
 	if (node->source->loginState == NODE_SOURCE_STATE_NONE) { 
 		subscription_update (node_source_root_from_node (node)->subscription, 0) ;
@@ -258,6 +241,15 @@ inoreader_feed_subscription_prepare_update_request (subscriptionPtr subscription
 
 	gchar* source_escaped = g_uri_escape_string(request->source, NULL, TRUE);
 	gchar* newUrl = g_strdup_printf ("http://www.inoreader.com/reader/atom/feed/%s", source_escaped);
+
+	/* Fetch only items newer than the last sync if possible */
+	watermark = google_reader_api_sync_get_watermark (subscription, ((InoreaderSourcePtr) node_source_root_from_node (node)->data)->lastTimestampMap);
+	if (watermark > 0) {
+		gchar *tmp = newUrl;
+		newUrl = g_strdup_printf ("%s?ot=%" G_GINT64_FORMAT, tmp, watermark);
+		g_free (tmp);
+	}
+
 	update_request_set_source (request, newUrl);
 	g_free (newUrl);
 	g_free (source_escaped);
@@ -27,154 +27,221 @@
 #include "metadata.h"
 #include "xml.h"
 
-JsonNode *
-json_api_get_node (JsonNode *parent, const gchar *mapping)
+/* Mapping paths like "summary/content" are split once per
+   json_api_get_items() call into the list of object steps to
+   walk and the final field name, instead of splitting them
+   again for each field of each item. */
+typedef struct jsonApiPath {
+	gchar		**steps;	/**< object location steps (without field) */
+	const gchar	*field;		/**< the field name (points into mapping) */
+} *jsonApiPathPtr;
+
+typedef struct jsonApiCompiledMapping {
+	jsonApiPathPtr	id;
+	jsonApiPathPtr	title;
+	jsonApiPathPtr	link;
+	jsonApiPathPtr	description;
+	jsonApiPathPtr	updated;
+	jsonApiPathPtr	author;
+	jsonApiPathPtr	read;
+	jsonApiPathPtr	flag;
+} jsonApiCompiledMapping;
+
+static jsonApiPathPtr
+json_api_path_compile (const gchar *mapping)
 {
-	JsonNode	*node = parent;
-	gchar		**step;
-	gchar		**steps = g_strsplit (g_strdup (mapping), "/", 0);
+	jsonApiPathPtr	path;
+	const gchar	*field;
+
+	if (!mapping)
+		return NULL;
+
+	path = g_new0 (struct jsonApiPath, 1);
+	field = strrchr (mapping, '/');
+	if (!field) {
+		path->field = mapping;
+		path->steps = g_new0 (gchar *, 1);
+	} else {
+		gchar *parent = g_strndup (mapping, field - mapping);
+		path->field = field + 1;
+		path->steps = g_strsplit (parent, "/", 0);
+		g_free (parent);
+	}
+
+	return path;
+}
+
+static void
+json_api_path_free (jsonApiPathPtr path)
+{
+	if (!path)
+		return;
+
+	g_strfreev (path->steps);
+	g_free (path);
+}
+
+static void
+json_api_mapping_compile (jsonApiCompiledMapping *compiled, jsonApiMapping *mapping)
+{
+	compiled->id		= json_api_path_compile (mapping->id);
+	compiled->title		= json_api_path_compile (mapping->title);
+	compiled->link		= json_api_path_compile (mapping->link);
+	compiled->description	= json_api_path_compile (mapping->description);
+	compiled->updated	= json_api_path_compile (mapping->updated);
+	compiled->author	= json_api_path_compile (mapping->author);
+	compiled->read		= json_api_path_compile (mapping->read);
+	compiled->flag		= json_api_path_compile (mapping->flag);
+}
 
-	step = steps;
-	if (!*step)
-		return node;
+static void
+json_api_mapping_free (jsonApiCompiledMapping *compiled)
+{
+	json_api_path_free (compiled->id);
+	json_api_path_free (compiled->title);
+	json_api_path_free (compiled->link);
+	json_api_path_free (compiled->description);
+	json_api_path_free (compiled->updated);
+	json_api_path_free (compiled->author);
+	json_api_path_free (compiled->read);
+	json_api_path_free (compiled->flag);
+}
+
+static JsonNode *
+json_api_get_node (JsonNode *parent, jsonApiPathPtr path)
+{
+	JsonNode	*node = parent;
+	gchar		**step = path->steps;
 
-	while (*(step + 1) && node) {
+	while (*step && node) {
 		node = json_get_node (node, *step);
 		step++;
 	}
 
-	g_strfreev (steps);
-
 	return node;
 }
 
-const gchar *
-json_api_get_string (JsonNode *parent, const gchar *mapping)
+static const gchar *
+json_api_get_string (JsonNode *parent, jsonApiPathPtr path)
 {
 	JsonNode	*node;
-	const gchar	*field;
 
-	if (!parent || !mapping)
+	if (!parent || !path)
 		return NULL;
 
-	node = json_api_get_node (parent, mapping);
+	node = json_api_get_node (parent, path);
 	if (!node)
 		return NULL;
 
-	field = strrchr (mapping, '/');
-	if (!field)
-		field = mapping;
-	else
-		field++;
-
-	return json_get_string (node, field);
+	return json_get_string (node, path->field);
 }
 
-gint
-json_api_get_int (JsonNode *parent, const gchar *mapping)
+static gint
+json_api_get_int (JsonNode *parent, jsonApiPathPtr path)
 {
 	JsonNode	*node;
-	const gchar	*field;
 
-	if (!parent || !mapping)
+	if (!parent || !path)
 		return 0;
 
-	node = json_api_get_node (parent, mapping);
+	node = json_api_get_node (parent, path);
 	if (!node)
 		return 0;
 
-	field = strrchr (mapping, '/');
-	if (!field)
-		field = mapping;
-	else
-		field++;
-
-	return json_get_int (node, field);
+	return json_get_int (node, path->field);
 }
 
-gboolean
-json_api_get_bool (JsonNode *parent, const gchar *mapping)
+static gboolean
+json_api_get_bool (JsonNode *parent, jsonApiPathPtr path)
 {
 	JsonNode	*node;
-	const gchar	*field;
 
-	if (!parent || !mapping)
+	if (!parent || !path)
 		return FALSE;
 
-	node = json_api_get_node (parent, mapping);
+	node = json_api_get_node (parent, path);
 	if (!node)
 		return FALSE;
 
-	field = strrchr (mapping, '/');
-	if (!field)
-		field = mapping;
-	else
-		field++;
+	return json_get_bool (node, path->field);
+}
+
+typedef struct jsonApiItemsCtxt {
+	GList			*items;
+	jsonApiCompiledMapping	paths;
+	jsonApiMapping		*mapping;
+	jsonApiItemCallbackFunc	callback;
+} jsonApiItemsCtxt;
 
-	return json_get_bool (node, field);
+static void
+json_api_map_item (JsonArray *array, guint index, JsonNode *node, gpointer user_data)
+{
+	jsonApiItemsCtxt	*ctxt = (jsonApiItemsCtxt *)user_data;
+	jsonApiCompiledMapping	*paths = &ctxt->paths;
+	itemPtr			item = item_new ();
+
+	/* Parse default feeds */
+	item_set_id	(item, json_api_get_string (node, paths->id));
+	item_set_title	(item, json_api_get_string (node, paths->title));
+	item_set_source	(item, json_api_get_string (node, paths->link));
+
+	item->time       = json_api_get_int (node, paths->updated);
+	item->readStatus = json_api_get_bool (node, paths->read);
+	item->flagStatus = json_api_get_bool (node, paths->flag);
+
+	if (ctxt->mapping->negateRead)
+		item->readStatus = !item->readStatus;
+
+	/* Handling encoded content */
+	const gchar *content; 
+	gchar *xhtml;
+
+	content = json_api_get_string (node, paths->description);
+	if (ctxt->mapping->xhtml) {
+		xhtml = xhtml_extract_from_string (content, NULL);
+		item_set_description (item, xhtml);
+		xmlFree (xhtml);
+	} else {
+		item_set_description (item, content);
+	}
+
+	/* Optional meta data */
+	const gchar *tmp = json_api_get_string (node, paths->author);
+	if (tmp)
+		item->metadata = metadata_list_append (item->metadata, "author", tmp);
+
+	ctxt->items = g_list_prepend (ctxt->items, (gpointer)item);
+
+	/* Allow optional item callback to process stuff */
+	if (ctxt->callback)
+		(*ctxt->callback)(node, item);
 }
 
 GList *
 json_api_get_items (const gchar *json, const gchar *root, jsonApiMapping *mapping, jsonApiItemCallbackFunc callback)
 {
-	GList		*items = NULL;
-	JsonParser	*parser = json_parser_new ();
+	jsonApiItemsCtxt	ctxt;
+	JsonParser		*parser = json_parser_new ();
+
+	ctxt.items = NULL;
+	ctxt.mapping = mapping;
+	ctxt.callback = callback;
 
 	if (json_parser_load_from_data (parser, json, -1, NULL)) {
-		JsonArray	*array = json_node_get_array (json_get_node (json_parser_get_root (parser), root));
-		GList		*elements = json_array_get_elements (array);
-		GList		*iter = elements;
+		JsonNode *items = json_get_node (json_parser_get_root (parser), root);
 
 		debug1 (DEBUG_PARSING, "JSON API: found items root node \"%s\"", root);
-                
-		while (iter) {
-			JsonNode *node = (JsonNode *)iter->data;
-			itemPtr item = item_new ();
-
-			/* Parse default feeds */
-			item_set_id	(item, json_api_get_string (node, mapping->id));
-			item_set_title	(item, json_api_get_string (node, mapping->title));
-			item_set_source	(item, json_api_get_string (node, mapping->link));
-
-			item->time       = json_api_get_int (node, mapping->updated);
-			item->readStatus = json_api_get_bool (node, mapping->read);
-			item->flagStatus = json_api_get_bool (node, mapping->flag);
-
-			if (mapping->negateRead)
-				item->readStatus = !item->readStatus;
-
-			/* Handling encoded content */
-			const gchar *content; 
-			gchar *xhtml;
-
-			content = json_api_get_string (node, mapping->description);
-			if (mapping->xhtml) {
-				xhtml = xhtml_extract_from_string (content, NULL);
-				item_set_description (item, xhtml);
-				xmlFree (xhtml);
-			} else {
-				item_set_description (item, content);
-			}
-
-			/* Optional meta data */
-			const gchar *tmp = json_api_get_string (node, mapping->author);
-			if (tmp)
-				item->metadata = metadata_list_append (item->metadata, "author", tmp);
-	
-			items = g_list_append (items, (gpointer)item);
-
-			/* Allow optional item callback to process stuff */
-			if (callback)
-				(*callback)(node, item);
-				
-			iter = g_list_next (iter);
-		}
 
-		g_list_free (elements);
-		g_object_unref (parser);
+		if (items && JSON_NODE_TYPE (items) == JSON_NODE_ARRAY) {
+			json_api_mapping_compile (&ctxt.paths, mapping);
+			json_array_foreach_element (json_node_get_array (items), json_api_map_item, &ctxt);
+			json_api_mapping_free (&ctxt.paths);
+		}
 	} else {
 		debug1 (DEBUG_PARSING, "Could not parse JSON \"%s\"", json);
 	}
 
-	return items;
+	g_object_unref (parser);
+
+	return g_list_reverse (ctxt.items);
 }
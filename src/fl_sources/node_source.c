@@ -31,6 +31,7 @@
 #include "feedlist.h"
 #include "folder.h"
 #include "item_state.h"
+#include "metadata.h"
 #include "node.h"
 #include "node_type.h"
 #include "plugins_engine.h"
@@ -40,6 +41,7 @@
 #include "ui/feed_list_node.h"
 #include "fl_sources/default_source.h"
 #include "fl_sources/dummy_source.h"
+#include "fl_sources/google_reader_api_sync.h"
 #include "fl_sources/google_source.h"
 #include "fl_sources/inoreader_source.h"
 #include "fl_sources/opml_source.h"
@@ -100,6 +102,8 @@ node_source_type_register (nodeSourceTypePtr type)
 		g_assert (type->api.edit_tag_remove_post);
 		g_assert (type->api.edit_tag_ar_tag_post);
 		g_assert (type->api.token);
+
+		metadata_type_register (GOOGLE_READER_API_SYNC_NEWEST_ITEM, METADATA_TYPE_TEXT);
 	}
 
 	nodeSourceTypes = g_slist_append (nodeSourceTypes, type);
@@ -39,103 +39,169 @@
 
 /* OPML subscription list helper functions */
 
+/* Separates the folder titles in folder path keys, chosen as it
+   cannot occur in normalized OPML attribute values */
+#define OPML_SOURCE_PATH_SEPARATOR "\n"
+
 typedef struct mergeCtxt {
-	nodePtr		rootNode;	/**< root node of the OPML feed list source */
-	nodePtr		parent;		/**< currently processed feed list node */
-	xmlNodePtr	xmlNode;	/**< currently processed XML node of old OPML doc */
+	GHashTable	*newUrls;	/**< feed URLs of the downloaded OPML */
+	GHashTable	*newFolders;	/**< folder paths of the downloaded OPML */
+	GHashTable	*feeds;		/**< feed URL -> existing feed node */
+	GHashTable	*folders;	/**< folder path -> existing folder node */
 } *mergeCtxtPtr;
 
-static void
-opml_source_merge_feed (xmlNodePtr match, gpointer user_data)
+static xmlChar *
+opml_source_outline_get_title (xmlNodePtr outline)
 {
-	mergeCtxtPtr	mergeCtxt = (mergeCtxtPtr)user_data;
-	xmlChar		*url, *title;
-	gchar		*expr;
-	nodePtr		node = NULL;
+	xmlChar	*title;
 
-	url = xmlGetProp (match, "xmlUrl");
-	title = xmlGetProp (match, "title");
+	title = xmlGetProp (outline, BAD_CAST"title");
 	if (!title)
-		title = xmlGetProp (match, "description");
+		title = xmlGetProp (outline, BAD_CAST"description");
 	if (!title)
-		title = xmlGetProp (match, "text");
-	if (!title && !url)
-		return;
-		
-	if (url)
-		expr = g_strdup_printf ("//outline[@xmlUrl = '%s']", url);
-	else			
-		expr = g_strdup_printf ("//outline[@title = '%s']", title);
-
-	if (!xpath_find (mergeCtxt->xmlNode, expr)) {
-		debug2(DEBUG_UPDATE, "adding %s (%s)", title, url);
+		title = xmlGetProp (outline, BAD_CAST"text");
+
+	return title;
+}
+
+/* Folders are matched by their path below the source root, so that
+   equally named folders at different levels do not collide */
+static gchar *
+opml_source_path_append (const gchar *path, const gchar *title)
+{
+	return g_strconcat (path, OPML_SOURCE_PATH_SEPARATOR, title, NULL);
+}
+
+static gchar *
+opml_source_node_path (nodePtr node)
+{
+	GString	*path = g_string_new (NULL);
+
+	for (; node && node != node->source->root; node = node->parent) {
+		g_string_prepend (path, node_get_title (node));
+		g_string_prepend (path, OPML_SOURCE_PATH_SEPARATOR);
+	}
+
+	return g_string_free (path, FALSE);
+}
+
+/* Indexes all feed URLs and folder paths of the downloaded OPML document */
+static void
+opml_source_index_outlines (mergeCtxtPtr mergeCtxt, xmlNodePtr parent, const gchar *path)
+{
+	xmlNodePtr	cur;
+
+	for (cur = parent->children; cur; cur = cur->next) {
+		xmlChar		*url, *title;
+
+		if (cur->type != XML_ELEMENT_NODE || !xmlStrEqual (cur->name, BAD_CAST"outline"))
+			continue;
+
+		url = xmlGetProp (cur, BAD_CAST"xmlUrl");
 		if (url) {
-			node = node_new (feed_get_node_type ());
-			node_set_data (node, feed_new ());
-			node_set_subscription (node, subscription_new (url, NULL, NULL));
-		} else {
-			node = node_new (folder_get_node_type ());
-		}
-		node_set_title (node, title);
-		node_set_parent (node, mergeCtxt->rootNode, -1);
-		feedlist_node_imported (node);
-		
-		subscription_update (node->subscription, FEED_REQ_RESET_TITLE | FEED_REQ_PRIORITY_HIGH);
-	}		
-	
-	/* Recursion if this is a folder */
-	if (!url) {
-		if (!node) {
-			/* if the folder node wasn't created above it
-			   must already exist and we search it in the 
-			   parents children list */
-			GSList	*iter = mergeCtxt->parent->children;
-			while (iter) {
-				if (g_str_equal (title, node_get_title (iter->data)))
-					node = iter->data;
-				iter = g_slist_next (iter);
-			}
-		}
-		
-		if (node) {
-			mergeCtxtPtr mc = g_new0 (struct mergeCtxt, 1);
-			mc->rootNode = mergeCtxt->rootNode;
-			mc->parent = node;
-			mc->xmlNode = mergeCtxt->xmlNode;	// FIXME: must be correct child!
-			xpath_foreach_match (match, "./outline", opml_source_merge_feed, (gpointer)mc);
-			g_free (mc);
-		} else {
-			g_print ("opml_source_merge_feed(): bad! bad! very bad!");
+			g_hash_table_add (mergeCtxt->newUrls, g_strdup ((gchar *)url));
+			xmlFree (url);
+		} else if ((title = opml_source_outline_get_title (cur))) {
+			gchar *folderPath = opml_source_path_append (path, (gchar *)title);
+			g_hash_table_add (mergeCtxt->newFolders, folderPath);
+			opml_source_index_outlines (mergeCtxt, cur, folderPath);
+			xmlFree (title);
 		}
 	}
+}
+
+/* Indexes all feeds by URL and all folders by path of the existing tree */
+static void
+opml_source_index_node (nodePtr node, gpointer user_data)
+{
+	mergeCtxtPtr	mergeCtxt = (mergeCtxtPtr)user_data;
 
-	g_free (expr);
-	xmlFree (title);
-	xmlFree (url);
+	if (IS_FEED (node)) {
+		g_hash_table_insert (mergeCtxt->feeds, (gpointer)subscription_get_source (node->subscription), node);
+	} else if (IS_FOLDER (node)) {
+		g_hash_table_insert (mergeCtxt->folders, opml_source_node_path (node), node);
+		node_foreach_child_data (node, opml_source_index_node, user_data);
+	}
 }
 
 static void
 opml_source_check_for_removal (nodePtr node, gpointer user_data)
 {
-	gchar		*expr = NULL;
+	mergeCtxtPtr	mergeCtxt = (mergeCtxtPtr)user_data;
+	gboolean	found;
 
 	if (IS_FEED (node)) {
-		expr = g_strdup_printf ("//outline[ @xmlUrl='%s' ]", subscription_get_source (node->subscription));
+		found = g_hash_table_contains (mergeCtxt->newUrls, subscription_get_source (node->subscription));
 	} else if (IS_FOLDER (node)) {
+		gchar *path = opml_source_node_path (node);
 		node_foreach_child_data (node, opml_source_check_for_removal, user_data);
-		expr = g_strdup_printf ("//outline[ (@title='%s') or (@text='%s') or (@description='%s')]", node->title, node->title, node->title);
+		found = g_hash_table_contains (mergeCtxt->newFolders, path);
+		g_free (path);
 	} else {
 		g_print ("opml_source_check_for_removal(): This should never happen...");
 		return;
 	}
 	
-	if (!xpath_find ((xmlNodePtr)user_data, expr)) {
+	if (!found) {
 		debug1 (DEBUG_UPDATE, "removing %s...", node_get_title (node));
 		feedlist_node_removed (node);
 	} else {
 		debug1 (DEBUG_UPDATE, "keeping %s...", node_get_title (node));
 	}
-	g_free (expr);
+}
+
+/* Adds all outlines of the downloaded OPML that have no existing node */
+static void
+opml_source_merge_outlines (mergeCtxtPtr mergeCtxt, xmlNodePtr parentOutline, nodePtr parent, const gchar *path)
+{
+	xmlNodePtr	cur;
+
+	for (cur = parentOutline->children; cur; cur = cur->next) {
+		xmlChar		*url, *title;
+		nodePtr		node;
+
+		if (cur->type != XML_ELEMENT_NODE || !xmlStrEqual (cur->name, BAD_CAST"outline"))
+			continue;
+
+		url = xmlGetProp (cur, BAD_CAST"xmlUrl");
+		title = opml_source_outline_get_title (cur);
+		if (!title && !url)
+			continue;
+
+		if (url) {
+			if (!g_hash_table_lookup (mergeCtxt->feeds, url)) {
+				debug2 (DEBUG_UPDATE, "adding %s (%s)", title, url);
+				node = node_new (feed_get_node_type ());
+				node_set_data (node, feed_new ());
+				node_set_subscription (node, subscription_new ((gchar *)url, NULL, NULL));
+				node_set_title (node, (gchar *)title);
+				node_set_parent (node, parent, -1);
+				feedlist_node_imported (node);
+
+				/* Only newly added subscriptions need an update */
+				subscription_update (node->subscription, FEED_REQ_RESET_TITLE | FEED_REQ_PRIORITY_HIGH);
+			}
+		} else {
+			gchar *folderPath = opml_source_path_append (path, (gchar *)title);
+
+			node = g_hash_table_lookup (mergeCtxt->folders, folderPath);
+			if (!node) {
+				debug1 (DEBUG_UPDATE, "adding folder %s", title);
+				node = node_new (folder_get_node_type ());
+				node_set_title (node, (gchar *)title);
+				node_set_parent (node, parent, -1);
+				feedlist_node_imported (node);
+				g_hash_table_insert (mergeCtxt->folders, g_strdup (folderPath), node);
+			}
+
+			/* Recursion as this is a folder */
+			opml_source_merge_outlines (mergeCtxt, cur, node, folderPath);
+			g_free (folderPath);
+		}
+
+		xmlFree (title);
+		xmlFree (url);
+	}
 }
 
 /* OPML subscription type implementation */
@@ -148,12 +214,12 @@ opml_subscription_prepare_update_request (subscriptionPtr subscription, struct u
 }
 
 static void
-opml_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult * const result, updateFlags flags)
+opml_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult * const result, updateTimingsPtr timings, updateFlags flags)
 {
 	nodePtr		node = subscription->node;
-	mergeCtxtPtr	mergeCtxt;
-	xmlDocPtr	doc, oldDoc;
-	xmlNodePtr	root, title;
+	struct mergeCtxt mergeCtxt;
+	xmlDocPtr	doc;
+	xmlNodePtr	root, title, body;
 	
 	debug1 (DEBUG_UPDATE, "OPML download finished data=%d", result->data);
 
@@ -162,29 +228,21 @@ opml_subscription_process_update_result (subscriptionPtr subscription, const str
 	if (result->data) {
 		doc = xml_parse (result->data, result->size, NULL);
 		if (doc) {
-			gchar *filename;
-			
 			root = xmlDocGetRootElement (doc);
-			
+			body = xpath_find (root, "/opml/body");
+
+			mergeCtxt.newUrls = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+			mergeCtxt.newFolders = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+			mergeCtxt.feeds = g_hash_table_new (g_str_hash, g_str_equal);
+			mergeCtxt.folders = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+			if (body)
+				opml_source_index_outlines (&mergeCtxt, body, "");
+
 			/* Go through all existing nodes and remove those whose
-			   URLs are not in new feed list. Also removes those URLs
-			   from the list that have corresponding existing nodes. */
-			node_foreach_child_data (node, opml_source_check_for_removal, (gpointer)root);
-						
-			opml_source_export (node);	/* save new feed list tree to disk 
-			                                   to ensure correct document in 
-							   next step */
-			
-			/* Merge up-to-date OPML feed list. */
-			filename = opml_source_get_feedlist (node);
-			oldDoc = xmlParseFile (filename);
-			g_free (filename);
-			
-			mergeCtxt = g_new0 (struct mergeCtxt, 1);
-			mergeCtxt->rootNode = node;
-			mergeCtxt->parent = node;
-			mergeCtxt->xmlNode = xmlDocGetRootElement (oldDoc);
-			
+			   URLs are not in new feed list. */
+			node_foreach_child_data (node, opml_source_check_for_removal, &mergeCtxt);
+
 			if (g_str_equal (node_get_title (node), OPML_SOURCE_DEFAULT_TITLE)) {
 				title = xpath_find (root, "/opml/head/title"); 
 				if (title) {
@@ -196,11 +254,15 @@ opml_subscription_process_update_result (subscriptionPtr subscription, const str
 				}
 			}
 			
-			xpath_foreach_match (root, "/opml/body/outline",
-			                     opml_source_merge_feed,
-			                     (gpointer)mergeCtxt);
-			g_free (mergeCtxt);
-			xmlFreeDoc (oldDoc);			
+			/* Merge up-to-date OPML feed list against the remaining nodes. */
+			node_foreach_child_data (node, opml_source_index_node, &mergeCtxt);
+			if (body)
+				opml_source_merge_outlines (&mergeCtxt, body, node, "");
+
+			g_hash_table_destroy (mergeCtxt.folders);
+			g_hash_table_destroy (mergeCtxt.feeds);
+			g_hash_table_destroy (mergeCtxt.newFolders);
+			g_hash_table_destroy (mergeCtxt.newUrls);
 			xmlFreeDoc (doc);
 			
 			opml_source_export (node);	/* save new feed list tree to disk */
@@ -210,8 +272,6 @@ opml_subscription_process_update_result (subscriptionPtr subscription, const str
 			g_print ("Cannot parse downloaded OPML document!");
 		}
 	}
-	
-	node_foreach_child_data (node, node_update_subscription, GUINT_TO_POINTER (0));
 }
 
 /* subscription type definition */
@@ -296,6 +356,15 @@ opml_source_remove (nodePtr node)
 	g_free (filename);
 }
 
+static void
+opml_source_auto_update_subscription (nodePtr node)
+{
+	if (node->subscription)
+		subscription_auto_update (node->subscription);
+
+	node_foreach_child (node, opml_source_auto_update_subscription);
+}
+
 static void
 opml_source_auto_update (nodePtr node)
 {
@@ -306,6 +375,8 @@ opml_source_auto_update (nodePtr node)
 	/* do daily updates for the feed list and feed updates according to the default interval */
 	if (node->subscription->updateState->lastPoll.tv_sec + OPML_SOURCE_UPDATE_INTERVAL <= now.tv_sec)
 		node_source_update (node);
+
+	node_foreach_child (node, opml_source_auto_update_subscription);
 }
 
 static void opml_source_init(void) { }
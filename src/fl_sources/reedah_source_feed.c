@@ -30,6 +30,7 @@
 #include "item_state.h"
 #include "itemlist.h"
 #include "json.h"
+#include "google_reader_api_sync.h"
 #include "json_api_mapper.h"
 #include "metadata.h"
 #include "node.h"
@@ -42,13 +43,13 @@ reedah_source_migrate_node (nodePtr node)
 {
 	/* scan the node for bad ID's, if so, brutally remove the node */
 	itemSetPtr itemset = node_get_itemset (node);
-	GList *iter = itemset->ids;
-	for (; iter; iter = g_list_next (iter)) {
-		itemPtr item = item_load (GPOINTER_TO_UINT (iter->data));
+	guint i;
+	for (i = 0; i < itemset->ids->len; i++) {
+		itemPtr item = item_load (g_array_index (itemset->ids, guint, i));
 		if (item && item->sourceId) {
 			if (!g_str_has_prefix(item->sourceId, "tag:google.com")) {
 				debug1(DEBUG_UPDATE, "Item with sourceId [%s] will be deleted.", item->sourceId);
-				db_item_remove(GPOINTER_TO_UINT(iter->data));
+				db_item_remove(g_array_index (itemset->ids, guint, i));
 			} 
 		}
 		if (item) item_unload (item);
@@ -98,7 +99,7 @@ reedah_item_callback (JsonNode *node, itemPtr item)
 }
 
 static void
-reedah_feed_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult* const result, updateFlags flags)
+reedah_feed_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult* const result, updateTimingsPtr timings, updateFlags flags)
 {
 	if (result->data && result->httpstatus == 200) {
 		GList		*items = NULL;
@@ -149,6 +150,7 @@ reedah_feed_subscription_process_update_result (subscriptionPtr subscription, co
 			itemset_free (itemSet);
 
 			subscription->node->available = TRUE;
+			google_reader_api_sync_commit (subscription, ((ReedahSourcePtr) node_source_root_from_node (subscription->node)->data)->lastTimestampMap);
 		} else {
 			subscription->node->available = FALSE;
 			g_string_append (((feedPtr)subscription->node->data)->parseErrors, _("Could not parse JSON returned by Reedah API!"));
@@ -164,6 +166,7 @@ reedah_feed_subscription_prepare_update_request (subscriptionPtr subscription,
 {
 	debug0 (DEBUG_UPDATE, "preparing Reedah feed subscription for update\n");
 	ReedahSourcePtr source = (ReedahSourcePtr) node_source_root_from_node (subscription->node)->data; 
+	gint64 watermark;
 	
 	g_assert(source); 
 	if (source->root->source->loginState == NODE_SOURCE_STATE_NONE) { 
@@ -181,6 +184,15 @@ reedah_feed_subscription_prepare_update_request (subscriptionPtr subscription,
 	// FIXME: move to .h
 	// FIXME: do not use 30
 	gchar* newUrl = g_strdup_printf ("http://www.reedah.com/reader/api/0/stream/contents/%s?client=liferea&n=30", source_escaped);
+
+	/* Fetch only items newer than the last sync if possible */
+	watermark = google_reader_api_sync_get_watermark (subscription, source->lastTimestampMap);
+	if (watermark > 0) {
+		gchar *tmp = newUrl;
+		newUrl = g_strdup_printf ("%s&ot=%" G_GINT64_FORMAT, tmp, watermark);
+		g_free (tmp);
+	}
+
 	update_request_set_source (request, newUrl);
 	g_free (newUrl);
 	g_free (source_escaped);
@@ -35,6 +35,7 @@
 #include "subscription.h"
 #include "xml.h" // FIXME
 
+#include "fl_sources/google_reader_api_sync.h"
 #include "fl_sources/opml_source.h"
 #include "fl_sources/reedah_source.h"
 
@@ -190,94 +191,16 @@ reedah_subscription_opml_cb (subscriptionPtr subscription, const struct updateRe
 
 /** functions for an efficient updating mechanism */
 
-static void
-reedah_source_opml_quick_update_helper (xmlNodePtr match, gpointer userdata) 
-{
-	ReedahSourcePtr gsource = (ReedahSourcePtr) userdata;
-	xmlNodePtr      xmlNode;
-	xmlChar         *id, *newestItemTimestamp;
-	nodePtr         node = NULL; 
-	const gchar     *oldNewestItemTimestamp;
-
-	xmlNode = xpath_find (match, "./string[@name='id']");
-	id = xmlNodeGetContent (xmlNode); 
-
-	if (g_str_has_prefix (id, "feed/"))
-		node = feedlist_find_node (gsource->root, NODE_BY_URL, id + strlen ("feed/"));
-	else {
-		xmlFree (id);
-		return;
-	}
-
-	if (node == NULL) {
-		xmlFree (id);
-		return;
-	}
-
-	xmlNode = xpath_find (match, "./number[@name='newestItemTimestampUsec']");
-	newestItemTimestamp = xmlNodeGetContent (xmlNode);
-
-	oldNewestItemTimestamp = g_hash_table_lookup (gsource->lastTimestampMap, node->subscription->source);
-
-	if (!oldNewestItemTimestamp ||
-	    (newestItemTimestamp && 
-	     !g_str_equal (newestItemTimestamp, oldNewestItemTimestamp))) { 
-		debug3(DEBUG_UPDATE, "ReedahSource: auto-updating %s "
-		       "[oldtimestamp%s, timestamp %s]", 
-		       id, oldNewestItemTimestamp, newestItemTimestamp);
-		g_hash_table_insert (gsource->lastTimestampMap,
-				    g_strdup (node->subscription->source), 
-				    g_strdup (newestItemTimestamp));
-				    
-		subscription_update (node->subscription, 0);
-	}
-
-	xmlFree (newestItemTimestamp);
-	xmlFree (id);
-}
-
-static void
-reedah_source_opml_quick_update_cb (const struct updateResult* const result, gpointer userdata, updateFlags flags) 
-{
-	ReedahSourcePtr gsource = (ReedahSourcePtr) userdata;
-	xmlDocPtr       doc;
-
-	if (!result->data) { 
-		/* what do I do? */
-		debug0 (DEBUG_UPDATE, "ReedahSource: Unable to get unread counts, this update is aborted.");
-		return;
-	}
-	doc = xml_parse (result->data, result->size, NULL);
-	if (!doc) {
-		debug0 (DEBUG_UPDATE, "ReedahSource: The XML failed to parse, maybe the session has expired. (FIXME)");
-		return;
-	}
-
-	xpath_foreach_match (xmlDocGetRootElement (doc),
-			    "/object/list[@name='unreadcounts']/object", 
-			    reedah_source_opml_quick_update_helper, gsource);
-	
-	xmlFreeDoc (doc);
-}
-
 gboolean
-reedah_source_opml_quick_update(ReedahSourcePtr source) 
+reedah_source_opml_quick_update (ReedahSourcePtr source)
 {
-	updateRequestPtr request = update_request_new ();
-	request->updateState = update_state_copy (source->root->subscription->updateState);
-	request->options = update_options_copy (source->root->subscription->updateOptions);
-	update_request_set_source (request, source->root->source->type->api.unread_count);
-	update_request_set_auth_value(request, source->root->source->authToken);
-
-	update_execute_request (source, request, reedah_source_opml_quick_update_cb,
-				source, 0);
+	google_reader_api_sync_update (source->root, source->lastTimestampMap, "reedah-feed-id");
 
 	return TRUE;
 }
 
-
 static void
-reedah_source_opml_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult * const result, updateFlags flags)
+reedah_source_opml_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult * const result, updateTimingsPtr timings, updateFlags flags)
 {
 	reedah_subscription_opml_cb (subscription, result, flags);
 }
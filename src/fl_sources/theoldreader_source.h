@@ -63,6 +63,9 @@ typedef struct TheOldReaderSource {
 /** Interval (in seconds) for doing a Quick Update: 10min */
 #define THEOLDREADER_SOURCE_QUICK_UPDATE_INTERVAL 600
 
+/** Interval (in seconds) for full feed list updates: daily */
+#define THEOLDREADER_SOURCE_UPDATE_INTERVAL 60*60*24
+
 /**
  * @returns TheOldReader source type implementation info.
  */
@@ -30,6 +30,7 @@
 
 #include "feedlist.h"
 #include "google_reader_api_edit.h"
+#include "google_reader_api_sync.h"
 #include "theoldreader_source.h"
 #include "subscription.h"
 #include "node.h"
@@ -42,14 +43,14 @@ theoldreader_source_migrate_node (nodePtr node)
 {
 	/* scan the node for bad ID's, if so, brutally remove the node */
 	itemSetPtr itemset = node_get_itemset (node);
-	GList *iter = itemset->ids;
-	for (; iter; iter = g_list_next (iter)) {
-		itemPtr item = item_load (GPOINTER_TO_UINT (iter->data));
+	guint i;
+	for (i = 0; i < itemset->ids->len; i++) {
+		itemPtr item = item_load (g_array_index (itemset->ids, guint, i));
 		if (item && item->sourceId) {
 			// FIXME: does this work?
 			if (!g_str_has_prefix(item->sourceId, "tag:google.com")) {
 				debug1(DEBUG_UPDATE, "Item with sourceId [%s] will be deleted.", item->sourceId);
-				db_item_remove(GPOINTER_TO_UINT(iter->data));
+				db_item_remove(g_array_index (itemset->ids, guint, i));
 			} 
 		}
 		if (item) item_unload (item);
@@ -59,45 +60,8 @@ theoldreader_source_migrate_node (nodePtr node)
 	itemset_free (itemset);
 }
 
-static itemPtr
-theoldreader_source_load_item_from_sourceid (nodePtr node, gchar *sourceId, GHashTable *cache) 
-{
-	gpointer    ret = g_hash_table_lookup (cache, sourceId);
-	itemSetPtr  itemset;
-	int         num = g_hash_table_size (cache);
-	GList       *iter; 
-	itemPtr     item = NULL;
-
-	if (ret)
-		return item_load (GPOINTER_TO_UINT (ret));
-
-	/* skip the top 'num' entries */
-	itemset = node_get_itemset (node);
-	iter = itemset->ids;
-	while (num--) iter = g_list_next (iter);
-
-	for (; iter; iter = g_list_next (iter)) {
-		item = item_load (GPOINTER_TO_UINT (iter->data));
-		if (item) {
-			if (item->sourceId) {
-				/* save to cache */
-				g_hash_table_insert (cache, g_strdup(item->sourceId), (gpointer) item->id);
-				if (g_str_equal (item->sourceId, sourceId)) {
-					itemset_free (itemset);
-					return item;
-				}
-			}
-			item_unload (item);
-		}
-	}
-
-	g_print ("Could not find item for %s!", sourceId);
-	itemset_free (itemset);
-	return NULL;
-}
-
 static void
-theoldreader_source_item_retrieve_status (const xmlNodePtr entry, subscriptionPtr subscription, GHashTable *cache)
+theoldreader_source_item_retrieve_status (const xmlNodePtr entry, subscriptionPtr subscription)
 {
 	xmlNodePtr      xml;
 	nodePtr         node = subscription->node;
@@ -133,7 +97,7 @@ theoldreader_source_item_retrieve_status (const xmlNodePtr entry, subscriptionPt
 		return;
 	}
 	
-	itemPtr item = theoldreader_source_load_item_from_sourceid (node, id, cache);
+	itemPtr item = db_item_find_by_source_id (node, id);
 	if (item && item->sourceId) {
 		if (g_str_equal (item->sourceId, id) && !google_reader_api_edit_is_in_queue(node->source, id)) {
 			
@@ -147,9 +111,10 @@ theoldreader_source_item_retrieve_status (const xmlNodePtr entry, subscriptionPt
 }
 
 static void
-theoldreader_feed_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult* const result, updateFlags flags)
+theoldreader_feed_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult* const result, updateTimingsPtr timings, updateFlags flags)
 {
-	gchar 	*id;
+	TheOldReaderSourcePtr	source = (TheOldReaderSourcePtr) node_source_root_from_node (subscription->node)->data;
+	gchar 			*id, *newest;
 
 	debug_start_measurement (DEBUG_UPDATE);
 
@@ -157,22 +122,28 @@ theoldreader_feed_subscription_process_update_result (subscriptionPtr subscripti
 	   which is mission critical and the feed parser currently drops all
 	   previous metadata :-( */
 	id = g_strdup (metadata_list_get (subscription->metadata, "theoldreader-feed-id"));
+	newest = g_strdup (metadata_list_get (subscription->metadata, GOOGLE_READER_API_SYNC_NEWEST_ITEM));
 
 	/* Always do standard feed parsing to get the items... */
-	feed_get_subscription_type ()->process_update_result (subscription, result, flags);
+	feed_get_subscription_type ()->process_update_result (subscription, result, timings, flags);
 
 	/* Set remote id again */
 	metadata_list_set (&subscription->metadata, "theoldreader-feed-id", id);
+	if (newest)
+		metadata_list_set (&subscription->metadata, GOOGLE_READER_API_SYNC_NEWEST_ITEM, newest);
 	g_free (id);
+	g_free (newest);
 
 	if (!result->data)
 		return;
 
+	if (subscription->node->available)
+		google_reader_api_sync_commit (subscription, source->lastTimestampMap);
+
 	xmlDocPtr doc = xml_parse (result->data, result->size, NULL);
 	if (doc) {		
 		xmlNodePtr root = xmlDocGetRootElement (doc);
 		xmlNodePtr entry = root->children ; 
-		GHashTable *cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
 		while (entry) { 
 			if (!g_str_equal (entry->name, "entry")) {
@@ -180,11 +151,10 @@ theoldreader_feed_subscription_process_update_result (subscriptionPtr subscripti
 				continue; /* not an entry */
 			}
 			
-			theoldreader_source_item_retrieve_status (entry, subscription, cache);
+			theoldreader_source_item_retrieve_status (entry, subscription);
 			entry = entry->next;
 		}
 		
-		g_hash_table_unref (cache);
 		xmlFreeDoc (doc);
 	} else { 
 		debug0 (DEBUG_UPDATE, "theoldreader_feed_subscription_process_update_result(): Couldn't parse XML!");
@@ -200,6 +170,7 @@ theoldreader_feed_subscription_prepare_update_request (subscriptionPtr subscript
 {
 	debug0 (DEBUG_UPDATE, "preparing TheOldReader feed subscription for update");
 	TheOldReaderSourcePtr source = (TheOldReaderSourcePtr) node_source_root_from_node (subscription->node)->data; 
+	gint64 watermark;
 	
 	g_assert (source); 
 	if (source->root->source->loginState == NODE_SOURCE_STATE_NONE) { 
@@ -215,6 +186,15 @@ theoldreader_feed_subscription_prepare_update_request (subscriptionPtr subscript
 	debug1 (DEBUG_UPDATE, "Setting cookies for a TheOldReader subscription '%s'", subscription->source);
 	gchar* source_escaped = g_uri_escape_string(request->source, NULL, TRUE);
 	gchar* newUrl = g_strdup_printf ("http://theoldreader.com/reader/atom/%s", metadata_list_get (subscription->metadata, "theoldreader-feed-id"));
+
+	/* Fetch only items newer than the last sync if possible */
+	watermark = google_reader_api_sync_get_watermark (subscription, source->lastTimestampMap);
+	if (watermark > 0) {
+		gchar *tmp = newUrl;
+		newUrl = g_strdup_printf ("%s?ot=%" G_GINT64_FORMAT, tmp, watermark);
+		g_free (tmp);
+	}
+
 	update_request_set_source (request, newUrl);
 	g_free (newUrl);
 	g_free (source_escaped);
@@ -35,6 +35,7 @@
 #include "subscription.h"
 #include "xml.h"
 
+#include "fl_sources/google_reader_api_sync.h"
 #include "fl_sources/opml_source.h"
 #include "fl_sources/theoldreader_source.h"
 
@@ -195,8 +196,18 @@ theoldreader_subscription_cb (subscriptionPtr subscription, const struct updateR
 		node_foreach_child_data (subscription->node, node_update_subscription, GUINT_TO_POINTER (0));
 }
 
+/** functions for an efficient updating mechanism */
+
+gboolean
+theoldreader_source_opml_quick_update (TheOldReaderSourcePtr source)
+{
+	google_reader_api_sync_update (source->root, source->lastTimestampMap, "theoldreader-feed-id");
+
+	return TRUE;
+}
+
 static void
-theoldreader_source_opml_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult * const result, updateFlags flags)
+theoldreader_source_opml_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult * const result, updateTimingsPtr timings, updateFlags flags)
 {
 	theoldreader_subscription_cb (subscription, result, flags);
 }
@@ -198,6 +198,7 @@ ttrss_source_init (void)
 {
 	metadata_type_register ("ttrss-url", METADATA_TYPE_URL);
 	metadata_type_register ("ttrss-feed-id", METADATA_TYPE_TEXT);
+	metadata_type_register ("ttrss-last-item-id", METADATA_TYPE_TEXT);
 }
 
 static void ttrss_source_deinit (void) { }
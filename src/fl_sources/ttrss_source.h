@@ -35,6 +35,9 @@ typedef struct ttrssSource {
 	gint		apiLevel;		/**< The API level reported by the instance (or 0) */
 	GHashTable	*categories;		/**< Lookup hash for TTRSS feed id to TTRSS category id */
 	GHashTable	*folderToCategory;	/**< Lookup hash for folder node id to TTRSS category id */
+	gint64		headlinesSinceId;	/**< article id watermark the running headlines sync started from */
+	gint64		headlinesMaxId;		/**< highest article id seen by the running headlines sync */
+	guint		headlinesSkip;		/**< number of headlines already fetched by the running sync */
 } *ttrssSourcePtr;
 
 /**
@@ -101,6 +104,32 @@ typedef struct ttrssSource {
  */
 #define TTRSS_JSON_HEADLINES "{\"op\":\"getHeadlines\", \"sid\":\"%s\", \"feed_id\":\"%s\", \"limit\":\"%d\", \"show_content\":\"true\", \"view_mode\":\"all_articles\", \"include_attachments\":\"true\"}"
 
+/**
+ * Fetch TinyTinyRSS headlines of all feeds newer than a given article id,
+ * oldest first so that articles arriving during a paged sync are appended
+ * after the pages already fetched.
+ *
+ * @param sid		session id
+ * @param since_id	highest article id already known
+ * @param limit		page size
+ * @param skip		number of headlines to skip
+ *
+ * @returns JSON headline list
+ */
+#define TTRSS_JSON_HEADLINES_SINCE "{\"op\":\"getHeadlines\", \"sid\":\"%s\", \"feed_id\":\"-4\", \"since_id\":\"%" G_GINT64_FORMAT "\", \"limit\":\"%d\", \"skip\":\"%u\", \"order_by\":\"date_reverse\", \"show_content\":\"true\", \"view_mode\":\"all_articles\", \"include_attachments\":\"true\"}"
+
+/**
+ * Maximum number of headlines TinyTinyRSS returns per getHeadlines call.
+ */
+#define TTRSS_HEADLINES_PAGE_SIZE 200
+
+/**
+ * Interval (in seconds) after which a source update fetches every feed
+ * on its own again to pick up read and flag state changes of articles
+ * older than the incremental sync watermark.
+ */
+#define TTRSS_STATE_REFRESH_INTERVAL (6*60*60)
+
 /**
  * Toggle item flag state.
  *
@@ -126,4 +155,23 @@ nodeSourceTypePtr ttrss_source_get_type (void);
 
 void ttrss_source_login (ttrssSourcePtr source, guint32 flags);
 
+/**
+ * Fetches all articles newer than the last seen article id
+ * (persisted as "ttrss-last-item-id" in the source subscription
+ * metadata) with paginated getHeadlines calls over all feeds and
+ * merges them into the matching feed nodes.
+ *
+ * @param source	the TinyTinyRSS source
+ * @param flags		update flags
+ */
+void ttrss_source_update_headlines (ttrssSourcePtr source, guint32 flags);
+
+/**
+ * Raises the persisted last seen article id if the given id is newer.
+ *
+ * @param source	the TinyTinyRSS source
+ * @param id		an article id seen on the remote side
+ */
+void ttrss_source_set_last_item_id (ttrssSourcePtr source, gint64 id);
+
 #endif
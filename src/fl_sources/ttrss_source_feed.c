@@ -35,18 +35,107 @@
 
 #include "fl_sources/ttrss_source.h"
 
+/* TinyTinyRSS reports ids both as numbers and strings depending on version */
+static gint64
+ttrss_source_json_get_id (JsonNode *node, const gchar *key)
+{
+	JsonNode *value = json_get_node (node, key);
+
+	if (!value || !JSON_NODE_HOLDS_VALUE (value))
+		return 0;
+
+	if (json_node_get_value_type (value) == G_TYPE_STRING)
+		return g_ascii_strtoll (json_node_get_string (value), NULL, 10);
+
+	return json_node_get_int (value);
+}
+
+static itemPtr
+ttrss_source_item_from_json (JsonNode *node)
+{
+	itemPtr item = item_new ();
+	JsonNode *attachments;
+	gchar *id;
+	const gchar *content; 
+	gchar *xhtml;
+
+	id = g_strdup_printf ("%" G_GINT64_FORMAT, json_get_int (node, "id"));
+	item_set_id (item, id);
+	g_free (id);
+	item_set_title (item, json_get_string (node, "title"));
+	item_set_source (item, json_get_string (node, "link"));
+
+	content = json_get_string (node, "content");
+	xhtml = xhtml_extract_from_string (content, NULL);
+	item_set_description (item, xhtml);
+	xmlFree (xhtml);
+
+	item->time = json_get_int (node, "updated");
+	
+	if (json_get_bool (node, "unread")) {
+		item->readStatus = FALSE;
+	} else {
+		item->readStatus = TRUE;
+	}
+	if (json_get_bool (node, "marked"))
+		item->flagStatus = TRUE;
+
+	/* Extract enclosures */
+	attachments = json_get_node (node, "attachments");
+	if (attachments && JSON_NODE_TYPE (attachments) == JSON_NODE_ARRAY) {
+		GList *aiter, *alist;
+		alist = aiter = json_array_get_elements (json_node_get_array (attachments));
+		while (aiter) {
+			JsonNode *enc_node = (JsonNode *)aiter->data;
+
+			/* attachment nodes should look like this:
+				{"id":"1562",
+                                 "content_url":"http:\/\/...",
+			         "content_type":"audio\/mpeg",
+			         "post_id":"44572",
+			         "title":"...",
+			         "duration":"29446311"}]
+			 */
+			if (json_get_string (enc_node, "content_url") &&
+			    json_get_string (enc_node, "content_type")) {
+				gchar *encStr = enclosure_values_to_string (
+					json_get_string (enc_node, "content_url"),
+					json_get_string (enc_node, "content_type"), 
+					0 /* length unknown to TinyTiny RSS*/,
+					FALSE /* not yet downloaded */);
+				item->metadata = metadata_list_append (item->metadata, "enclosure", encStr);
+				item->hasEnclosure = TRUE;
+				g_free (encStr);
+			}
+			aiter = g_list_next (aiter);
+		}
+		g_list_free (alist);
+	}
+
+	return item;
+}
+
+static void
+ttrss_source_merge_items (nodePtr node, GList *items)
+{
+	itemSetPtr itemSet = node_get_itemset (node);
+	node->newCount = itemset_merge_items (itemSet, items, TRUE /* feed valid */, FALSE /* markAsRead */);
+	itemlist_merge_itemset (itemSet);
+	itemset_free (itemSet);
+}
+
 static void
-ttrss_feed_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult* const result, updateFlags flags)
+ttrss_feed_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult* const result, updateTimingsPtr timings, updateFlags flags)
 {
 	if (result->data && result->httpstatus == 200) {
 		JsonParser	*parser = json_parser_new ();
 
 		if (json_parser_load_from_data (parser, result->data, -1, NULL)) {
 			JsonArray	*array = json_node_get_array (json_get_node (json_parser_get_root (parser), "content"));
-			JsonNode	*attachments;
 			GList		*elements = json_array_get_elements (array);
 			GList		*iter = elements;
 			GList		*items = NULL;
+			gint64		maxId = 0;
 
 			/*
 			   We expect to get something like this
@@ -70,65 +159,9 @@ ttrss_feed_subscription_process_update_result (subscriptionPtr subscription, con
                          
 			while (iter) {
 				JsonNode *node = (JsonNode *)iter->data;
-				itemPtr item = item_new ();
-				gchar *id;
-				const gchar *content; 
-				gchar *xhtml;
-
-				id = g_strdup_printf ("%" G_GINT64_FORMAT, json_get_int (node, "id"));
-				item_set_id (item, id);
-				g_free (id);
-				item_set_title (item, json_get_string (node, "title"));
-				item_set_source (item, json_get_string (node, "link"));
-
-				content = json_get_string (node, "content");
-				xhtml = xhtml_extract_from_string (content, NULL);
-				item_set_description (item, xhtml);
-				xmlFree (xhtml);
-
-				item->time = json_get_int (node, "updated");
-				
-				if (json_get_bool (node, "unread")) {
-					item->readStatus = FALSE;
-				} else {
-					item->readStatus = TRUE;
-				}
-				if (json_get_bool (node, "marked"))
-					item->flagStatus = TRUE;
-
-				/* Extract enclosures */
-				attachments = json_get_node (node, "attachments");
-				if (attachments && JSON_NODE_TYPE (attachments) == JSON_NODE_ARRAY) {
-					GList *aiter, *alist;
-					alist = aiter = json_array_get_elements (json_node_get_array (attachments));
-					while (aiter) {
-						JsonNode *enc_node = (JsonNode *)aiter->data;
-
-						/* attachment nodes should look like this:
-							{"id":"1562",
-                                                         "content_url":"http:\/\/...",
-						         "content_type":"audio\/mpeg",
-						         "post_id":"44572",
-						         "title":"...",
-						         "duration":"29446311"}]
-						 */
-						if (json_get_string (enc_node, "content_url") &&
-						    json_get_string (enc_node, "content_type")) {
-							gchar *encStr = enclosure_values_to_string (
-								json_get_string (enc_node, "content_url"),
-								json_get_string (enc_node, "content_type"), 
-								0 /* length unknown to TinyTiny RSS*/,
-								FALSE /* not yet downloaded */);
-							item->metadata = metadata_list_append (item->metadata, "enclosure", encStr);
-							item->hasEnclosure = TRUE;
-							g_free (encStr);
-						}
-						aiter = g_list_next (aiter);
-					}
-					g_list_free (alist);
-				}
-					
-				items = g_list_append (items, (gpointer)item);
+
+				maxId = MAX (maxId, json_get_int (node, "id"));
+				items = g_list_append (items, (gpointer)ttrss_source_item_from_json (node));
 				
 				iter = g_list_next (iter);
 			}
@@ -136,12 +169,11 @@ ttrss_feed_subscription_process_update_result (subscriptionPtr subscription, con
 			g_list_free (elements);
 
 			/* merge against feed cache */
-			if (items) {
-				itemSetPtr itemSet = node_get_itemset (subscription->node);
-				subscription->node->newCount = itemset_merge_items (itemSet, items, TRUE /* feed valid */, FALSE /* markAsRead */);
-				itemlist_merge_itemset (itemSet);
-				itemset_free (itemSet);
-			}
+			if (items)
+				ttrss_source_merge_items (subscription->node, items);
+
+			/* Remember the newest article for the incremental sync */
+			ttrss_source_set_last_item_id ((ttrssSourcePtr) node_source_root_from_node (subscription->node)->data, maxId);
 
 			subscription->node->available = TRUE;
 		} else {
@@ -156,6 +188,162 @@ ttrss_feed_subscription_process_update_result (subscriptionPtr subscription, con
 	}
 }
 
+/* incremental cross-feed headline sync */
+
+void
+ttrss_source_set_last_item_id (ttrssSourcePtr source, gint64 id)
+{
+	subscriptionPtr	subscription = source->root->subscription;
+	const gchar	*last;
+	gchar		*tmp;
+
+	last = metadata_list_get (subscription->metadata, "ttrss-last-item-id");
+	if (last && g_ascii_strtoll (last, NULL, 10) >= id)
+		return;
+
+	tmp = g_strdup_printf ("%" G_GINT64_FORMAT, id);
+	metadata_list_set (&subscription->metadata, "ttrss-last-item-id", tmp);
+	g_free (tmp);
+
+	db_subscription_update (subscription);
+}
+
+static void
+ttrss_source_collect_feeds (nodePtr node, GHashTable *feeds)
+{
+	GSList *iter;
+
+	if (node->subscription) {
+		const gchar *id = metadata_list_get (node->subscription->metadata, "ttrss-feed-id");
+		if (id)
+			g_hash_table_insert (feeds, (gpointer)id, node);
+	}
+
+	for (iter = node->children; iter; iter = g_slist_next (iter))
+		ttrss_source_collect_feeds ((nodePtr)iter->data, feeds);
+}
+
+static void ttrss_source_request_headlines (ttrssSourcePtr source, guint32 flags);
+
+static void
+ttrss_source_headlines_cb (const struct updateResult * const result, gpointer userdata, updateFlags flags)
+{
+	ttrssSourcePtr	source = (ttrssSourcePtr) userdata;
+	JsonParser	*parser;
+	guint		count = 0;
+
+	debug1 (DEBUG_UPDATE, "TinyTinyRSS headlines result processing... status:%d", result->httpstatus);
+
+	if (!(result->data && result->httpstatus == 200)) {
+		debug0 (DEBUG_UPDATE, "ttrss_source_headlines_cb(): Failed to get headlines!");
+		return;
+	}
+
+	parser = json_parser_new ();
+	if (json_parser_load_from_data (parser, result->data, -1, NULL)) {
+		JsonNode	*content = json_get_node (json_parser_get_root (parser), "content");
+
+		if (content && JSON_NODE_TYPE (content) == JSON_NODE_ARRAY) {
+			GHashTable	*feeds = g_hash_table_new (g_str_hash, g_str_equal);
+			GHashTable	*itemsByFeed = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+			GHashTableIter	hiter;
+			gpointer	key, value;
+			GList		*elements, *iter;
+
+			ttrss_source_collect_feeds (source->root, feeds);
+
+			/* Split the headlines by feed in a single pass */
+			elements = iter = json_array_get_elements (json_node_get_array (content));
+			while (iter) {
+				JsonNode *node = (JsonNode *)iter->data;
+				gchar *feedId = g_strdup_printf ("%" G_GINT64_FORMAT, ttrss_source_json_get_id (node, "feed_id"));
+				GList *items = g_hash_table_lookup (itemsByFeed, feedId);
+
+				source->headlinesMaxId = MAX (source->headlinesMaxId, json_get_int (node, "id"));
+				items = g_list_prepend (items, ttrss_source_item_from_json (node));
+				g_hash_table_insert (itemsByFeed, feedId, items);
+				count++;
+
+				iter = g_list_next (iter);
+			}
+			g_list_free (elements);
+
+			/* And merge each feed only once */
+			g_hash_table_iter_init (&hiter, itemsByFeed);
+			while (g_hash_table_iter_next (&hiter, &key, &value)) {
+				nodePtr node = (nodePtr) g_hash_table_lookup (feeds, key);
+				GList *items = g_list_reverse ((GList *)value);
+
+				if (!node) {
+					debug1 (DEBUG_UPDATE, "TinyTinyRSS headlines for unknown feed id %s dropped", (gchar *)key);
+					g_list_free_full (items, (GDestroyNotify)item_unload);
+					continue;
+				}
+
+				ttrss_source_merge_items (node, items);
+				node->available = TRUE;
+				if (node->newCount > 0) {
+					feedlist_new_items (node->newCount);
+					feedlist_node_was_updated (node);
+				}
+			}
+
+			g_hash_table_destroy (itemsByFeed);
+			g_hash_table_destroy (feeds);
+		} else {
+			debug0 (DEBUG_UPDATE, "ttrss_source_headlines_cb(): No headline list found!");
+		}
+	} else {
+		g_print ("Invalid JSON returned on TinyTinyRSS request! >>>%s<<<", result->data);
+	}
+
+	g_object_unref (parser);
+
+	/* A full page means there might be more. Page by offset with
+	   the since id of the sync start: the pages are ordered by date,
+	   not id, so the highest id of a page can be newer than articles
+	   on the next one. The watermark is only stored once all pages
+	   have been fetched. */
+	if (count == TTRSS_HEADLINES_PAGE_SIZE) {
+		source->headlinesSkip += count;
+		ttrss_source_request_headlines (source, flags);
+		return;
+	}
+
+	ttrss_source_set_last_item_id (source, source->headlinesMaxId);
+}
+
+static void
+ttrss_source_request_headlines (ttrssSourcePtr source, guint32 flags)
+{
+	updateRequestPtr	request;
+	gchar			*source_uri;
+
+	debug2 (DEBUG_UPDATE, "TinyTinyRSS fetching headlines since id %" G_GINT64_FORMAT " skipping %u", source->headlinesSinceId, source->headlinesSkip);
+
+	request = update_request_new ();
+	request->options = update_options_copy (source->root->subscription->updateOptions);
+	request->postdata = g_strdup_printf (TTRSS_JSON_HEADLINES_SINCE, source->session_id, source->headlinesSinceId, TTRSS_HEADLINES_PAGE_SIZE, source->headlinesSkip);
+
+	source_uri = g_strdup_printf (TTRSS_URL, source->url);
+	update_request_set_source (request, source_uri);
+	g_free (source_uri);
+
+	update_execute_request (source, request, ttrss_source_headlines_cb, source, flags);
+}
+
+void
+ttrss_source_update_headlines (ttrssSourcePtr source, guint32 flags)
+{
+	const gchar *last = metadata_list_get (source->root->subscription->metadata, "ttrss-last-item-id");
+
+	source->headlinesSinceId = last?g_ascii_strtoll (last, NULL, 10):0;
+	source->headlinesMaxId = source->headlinesSinceId;
+	source->headlinesSkip = 0;
+
+	ttrss_source_request_headlines (source, flags);
+}
+
 static gboolean
 ttrss_feed_subscription_prepare_update_request (subscriptionPtr subscription, 
                                                  struct updateRequest *request)
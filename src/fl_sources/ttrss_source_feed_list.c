@@ -111,6 +111,15 @@ ttrss_source_merge_feed (ttrssSourcePtr source, const gchar *url, const gchar *t
 
 /* source subscription type implementation */
 
+static gboolean
+ttrss_source_state_refresh_needed (subscriptionPtr subscription)
+{
+	const gchar	*last = metadata_list_get (subscription->metadata, "ttrss-last-state-refresh");
+	gint64		now = g_get_real_time () / G_USEC_PER_SEC;
+
+	return !last || now - g_ascii_strtoll (last, NULL, 10) >= TTRSS_STATE_REFRESH_INTERVAL;
+}
+
 static void
 ttrss_source_subscription_list_cb (const struct updateResult * const result, gpointer user_data, guint32 flags)
 {
@@ -201,8 +210,24 @@ ttrss_source_subscription_list_cb (const struct updateResult * const result, gpo
 		debug0 (DEBUG_UPDATE, "ttrss_subscription_cb(): ERROR: failed to get TinyTinyRSS subscription list!");
 	}
 
-	if (!(flags & NODE_SOURCE_UPDATE_ONLY_LIST))
-		node_foreach_child_data (subscription->node, node_update_subscription, GUINT_TO_POINTER (0));	
+	if (!(flags & NODE_SOURCE_UPDATE_ONLY_LIST)) {
+		/* Once we know the newest article id we only fetch what is
+		   newer in a single cross-feed request. Otherwise (first sync)
+		   and every TTRSS_STATE_REFRESH_INTERVAL each feed is fetched
+		   on its own which also records the article id watermark and
+		   updates the read and flag state of older articles. */
+		if (metadata_list_get (subscription->metadata, "ttrss-last-item-id") &&
+		    !ttrss_source_state_refresh_needed (subscription)) {
+			ttrss_source_update_headlines (source, flags);
+		} else {
+			gchar *tmp = g_strdup_printf ("%" G_GINT64_FORMAT, g_get_real_time () / G_USEC_PER_SEC);
+			metadata_list_set (&subscription->metadata, "ttrss-last-state-refresh", tmp);
+			g_free (tmp);
+			db_subscription_update (subscription);
+
+			node_foreach_child_data (subscription->node, node_update_subscription, GUINT_TO_POINTER (0));
+		}
+	}
 }
 
 static void
@@ -272,7 +297,7 @@ ttrss_source_merge_categories (ttrssSourcePtr source, nodePtr parent, gint paren
 }
 
 static void
-ttrss_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult * const result, updateFlags flags)
+ttrss_subscription_process_update_result (subscriptionPtr subscription, const struct updateResult * const result, updateTimingsPtr timings, updateFlags flags)
 {
 	ttrssSourcePtr		source = (ttrssSourcePtr) subscription->node->data;
 
@@ -47,8 +47,7 @@ folder_merge_child_items (nodePtr node, gpointer user_data)
 		return;
 
 	nodeItemSet = node_get_itemset (node);
-	folderItemSet->ids = g_list_concat (folderItemSet->ids, nodeItemSet->ids);
-	nodeItemSet->ids = NULL;
+	itemset_add_ids (folderItemSet, (guint *)nodeItemSet->ids->data, nodeItemSet->ids->len);
 	itemset_free (nodeItemSet);
 }
 
@@ -57,8 +56,7 @@ folder_load (nodePtr node)
 {
 	itemSetPtr	itemSet;
 	
-	itemSet = g_new0 (struct itemSet, 1);
-	itemSet->nodeId = node->id;
+	itemSet = itemset_new (node->id);
 
 	node_foreach_child_data (node, folder_merge_child_items, itemSet);
 	return itemSet;
@@ -88,6 +86,10 @@ folder_add_child_update_counters (nodePtr node, gpointer user_data)
 {
 	guint	*unreadCount = (guint *)user_data;
 
+	/* Search folders only show items of other feeds */
+	if (IS_VFOLDER (node))
+		return;
+
 	*unreadCount += node->unreadCount;
 }
 
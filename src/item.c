@@ -32,6 +32,8 @@
 #include "metadata.h"
 #include "xml.h"
 
+static gint loadedItems = 0;	/**< number of items in memory */
+
 itemPtr
 item_new (void)
 {
@@ -39,10 +41,53 @@ item_new (void)
 	
 	item = g_new0 (struct item, 1);
 	item->popupStatus = TRUE;
+	g_atomic_int_inc (&loadedItems);
 	
 	return item;
 }
 
+itemPtr
+item_new_in_arena (GStringChunk *arena)
+{
+	itemPtr		item;
+
+	item = item_new ();
+	item->arena = arena;
+
+	return item;
+}
+
+/* String fields of items in an arena are never freed one by one */
+static gchar *
+item_strdup (itemPtr item, const gchar *str)
+{
+	if (item->arena && str)
+		return g_string_chunk_insert (item->arena, str);
+
+	return g_strdup (str);
+}
+
+static void
+item_strfree (itemPtr item, gchar *str)
+{
+	if (!item->arena)
+		g_free (str);
+}
+
+void
+item_promote (itemPtr item)
+{
+	if (!item->arena)
+		return;
+
+	item->title = g_strdup (item->title);
+	item->source = g_strdup (item->source);
+	item->sourceId = g_strdup (item->sourceId);
+	item->description = g_strdup (item->description);
+	metadata_list_promote (item->metadata);
+	item->arena = NULL;
+}
+
 itemPtr
 item_load (gulong id)
 {
@@ -56,7 +101,7 @@ item_copy (itemPtr item)
 
 	item_set_title (copy, item->title);
 	item_set_source (copy, item->source);
-	item_set_description (copy, item->description);
+	item_set_description (copy, item_get_description (item));
 	item_set_id (copy, item->sourceId);
 	
 	copy->updateStatus = item->updateStatus;
@@ -83,12 +128,12 @@ item_copy (itemPtr item)
 void
 item_set_title (itemPtr item, const gchar * title)
 {
-	g_free (item->title);
+	item_strfree (item, item->title);
 
 	if (title)
-		item->title = g_strstrip (g_strdelimit (g_strdup (title), "\r\n", ' '));
+		item->title = g_strstrip (g_strdelimit (item_strdup (item, title), "\r\n", ' '));
 	else
-		item->title = g_strdup ("");
+		item->title = item_strdup (item, "");
 }
 
 void
@@ -97,20 +142,20 @@ item_set_description (itemPtr item, const gchar *description)
 	if (!description)
 		return;
 
-	if (item->description)
+	if (item_get_description (item))
 		if (!(strlen (description) > strlen (item->description)))
 			return;
 
-	g_free (item->description);
-	item->description = g_strdup (description);
+	item_strfree (item, item->description);
+	item->description = item_strdup (item, description);
 }
 
 void
 item_set_source (itemPtr item, const gchar * source)
 {
-	g_free (item->source);
+	item_strfree (item, item->source);
 	if (source) 
-		item->source = g_strstrip (g_strdup (source));
+		item->source = g_strstrip (item_strdup (item, source));
 	else
 		item->source = NULL;
 }
@@ -118,15 +163,36 @@ item_set_source (itemPtr item, const gchar * source)
 void
 item_set_id (itemPtr item, const gchar * id)
 {
-	g_free (item->sourceId);
-	item->sourceId = g_strdup (id);
+	item_strfree (item, item->sourceId);
+	item->sourceId = item_strdup (item, id);
+}
+
+void
+item_metadata_append (itemPtr item, const gchar *strid, const gchar *data)
+{
+	item->metadata = metadata_list_append_arena (item->metadata, item->arena, strid, data);
+}
+
+void
+item_metadata_set (itemPtr item, const gchar *strid, const gchar *data)
+{
+	metadata_list_set_arena (&item->metadata, item->arena, strid, data);
 }
 
 const gchar *	item_get_id(itemPtr item) { return item->sourceId; }
 const gchar *	item_get_title(itemPtr item) {return item->title; }
-const gchar *	item_get_description(itemPtr item) { return item->description; }
 const gchar *	item_get_source(itemPtr item) { return item->source; }
 
+const gchar *
+item_get_description (itemPtr item)
+{
+	/* Descriptions of stored items are loaded on first use */
+	if (!item->description && item->id)
+		item->description = db_item_load_description (item->id);
+
+	return item->description;
+}
+
 static GRegex *whitespace_strip_re = NULL;
 
 gchar *
@@ -140,7 +206,7 @@ item_get_teaser (itemPtr item)
 		g_assert (NULL != whitespace_strip_re);
 	}
 
-	input = unxmlize (g_strdup (item->description));
+	input = unxmlize (g_strdup (item_get_description (item)));
 	tmpDesc = g_regex_replace_literal (whitespace_strip_re, input, -1, 0, " ", 0, NULL);
 
 	if (strlen (tmpDesc) > 200) {
@@ -193,10 +259,10 @@ item_make_link (itemPtr item)
 void
 item_unload (itemPtr item) 
 {
-	g_free (item->title);
-	g_free (item->source);
-	g_free (item->sourceId);
-	g_free (item->description);
+	item_strfree (item, item->title);
+	item_strfree (item, item->source);
+	item_strfree (item, item->sourceId);
+	item_strfree (item, item->description);
 	g_free (item->commentFeedId);
 	g_free (item->nodeId);
 	g_free (item->parentNodeId);
@@ -205,6 +271,13 @@ item_unload (itemPtr item)
 	metadata_list_free (item->metadata);
 
 	g_free (item);
+	g_atomic_int_add (&loadedItems, -1);
+}
+
+guint
+item_get_loaded_count (void)
+{
+	return g_atomic_int_get (&loadedItems);
 }
 
 const gchar *
@@ -53,7 +53,7 @@ typedef struct item {
 	gchar		*source;		/*<< URL to the post online */
 	gchar		*sourceId;		/*<< "Unique" syndication item identifier, for example <guid> in RSS */
 	gboolean	validGuid;		/*<< TRUE if id of this item is a GUID and can be used for duplicate detection */
-	gchar		*description;		/*<< XHTML string containing the item's description */
+	gchar		*description;		/*<< XHTML string containing the item's description, loaded on demand by item_get_description() */
 	
 	GSList		*metadata;		/*<< Metadata of this item */
 	GHashTable	*tmpdata;		/*<< Temporary data hash used during stateful parsing */
@@ -73,6 +73,8 @@ typedef struct item {
 	/* remote states used during sync of remote accounts */
 	gboolean	remoteReadStatus;	/*<< TRUE if the remote copy of the item has been read */
 	gboolean	remoteFlagStatus;	/*<< TRUE if the remote copy of the item has been flagged */
+
+	GStringChunk	*arena;			/*<< String arena of a parsed item (or NULL), holds title, source, id, description and new metadata values */
 } *itemPtr;
 
 /**
@@ -83,6 +85,26 @@ typedef struct item {
  */
 itemPtr 	item_new(void);
 
+/**
+ * item_new_in_arena: (skip)
+ * @arena:	string arena of the parser
+ *
+ * Allocates a new item structure whose strings are stored in the
+ * given arena. Such items are cheap to drop, but must be passed to
+ * item_promote() before they are kept beyond the lifetime of the arena.
+ *
+ * Returns: (transfer full): the new structure
+ */
+itemPtr 	item_new_in_arena(GStringChunk *arena);
+
+/**
+ * item_promote: (skip)
+ * @item:	the item
+ *
+ * Copies all strings of an item out of its arena.
+ */
+void		item_promote(itemPtr item);
+
 /**
  * item_load: (skip)
  * @id:	item id to load
@@ -127,6 +149,13 @@ const gchar * item_get_base_url(itemPtr item);
  */
 void	item_unload(itemPtr item);
 
+/**
+ * item_get_loaded_count: (skip)
+ *
+ * Returns: the number of items currently held in memory
+ */
+guint	item_get_loaded_count (void);
+
 /* methods to access properties */
 /* Returns the id of item. */
 const gchar *	item_get_id(itemPtr item);
@@ -177,6 +206,11 @@ void		item_set_source(itemPtr item, const gchar * source);
 /* Sets the item id */
 void		item_set_id(itemPtr item, const gchar * id);
 
+/* Appends an item metadata value, see metadata_list_append() */
+void		item_metadata_append(itemPtr item, const gchar *strid, const gchar *data);
+/* Sets an item metadata value, see metadata_list_set() */
+void		item_metadata_set(itemPtr item, const gchar *strid, const gchar *data);
+
 /**
  * item_to_xml: (skip)
  * @item:		the item to save to cache
@@ -24,7 +24,8 @@
 
 struct ItemLoaderPrivate {
 	fetchCallbackPtr	fetchCallback;		/**< the function to call after each item fetch */
-	gpointer		fetchCallbackData;	/**< user data for the fetch callback */
+	startCallbackPtr	startCallback;		/**< the function starting an asynchronous loader */
+	gpointer		fetchCallbackData;	/**< user data for the fetch/start callback */
 
 	nodePtr		node;			/**< the node we are loading items for */
 
@@ -124,7 +125,22 @@ item_loader_fetch (gpointer user_data)
 void
 item_loader_start (ItemLoader *il) 
 {
-	il->priv->idleId = g_idle_add (item_loader_fetch, il);
+	if (il->priv->startCallback)
+		(*il->priv->startCallback)(il, il->priv->fetchCallbackData);
+	else
+		il->priv->idleId = g_idle_add (item_loader_fetch, il);
+}
+
+void
+item_loader_add_items (ItemLoader *il, GSList *items)
+{
+	g_signal_emit_by_name (il, "item-batch-fetched", items);
+}
+
+void
+item_loader_finish (ItemLoader *il)
+{
+	g_signal_emit_by_name (il, "finished");
 }
 
 ItemLoader *
@@ -139,3 +155,16 @@ item_loader_new (fetchCallbackPtr fetchCallback, nodePtr node, gpointer fetchCal
 
 	return il;
 }
+
+ItemLoader *
+item_loader_new_async (startCallbackPtr startCallback, nodePtr node, gpointer startCallbackData)
+{
+	ItemLoader *il;
+
+	il = ITEM_LOADER (g_object_new (ITEM_LOADER_TYPE, NULL));
+	il->priv->node = node;
+	il->priv->startCallback = startCallback;
+	il->priv->fetchCallbackData = startCallbackData;
+
+	return il;
+}
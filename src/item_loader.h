@@ -76,6 +76,45 @@ typedef gboolean (*fetchCallbackPtr)(gpointer user_data, GSList **items);
  */
 ItemLoader * item_loader_new (fetchCallbackPtr fetchCallback, nodePtr node, gpointer user_data);
 
+/**
+ * Definition of the start callback of asynchronous item loaders.
+ * The callback starts loading in the background and passes all
+ * results back in the main loop using item_loader_add_items()
+ * and item_loader_finish().
+ *
+ * @param il		the item loader
+ * @param user_data	ItemLoader type specific data
+ */
+typedef void (*startCallbackPtr)(ItemLoader *il, gpointer user_data);
+
+/**
+ * Set up a new asynchronous item loader.
+ *
+ * @param startCallback	the function starting the background loading
+ * @param node		the node we are loading items for
+ * @param user_data	ItemLoader type specific data
+ *
+ * @returns the new ItemLoader instance
+ */
+ItemLoader * item_loader_new_async (startCallbackPtr startCallback, nodePtr node, gpointer user_data);
+
+/**
+ * Passes a batch of items fetched by an asynchronous item loader.
+ * To be called from the main loop only.
+ *
+ * @param il		the item loader
+ * @param items		the items (to be free'd by the signal handler)
+ */
+void item_loader_add_items (ItemLoader *il, GSList *items);
+
+/**
+ * Signals that an asynchronous item loader has finished.
+ * To be called from the main loop only.
+ *
+ * @param il		the item loader
+ */
+void item_loader_finish (ItemLoader *il);
+
 /**
  * Returns the node an item loader is loading items for.
  *
@@ -86,7 +125,8 @@ ItemLoader * item_loader_new (fetchCallbackPtr fetchCallback, nodePtr node, gpoi
 nodePtr item_loader_get_node (ItemLoader *il);
 
 /**
- * Starts the item loader to load items with idle priority.
+ * Starts the item loader to load items with idle priority
+ * or in the background for asynchronous item loaders.
  *
  * @param il	the item loader
  */
@@ -44,6 +44,12 @@ item_set_flag_state (itemPtr item, gboolean newState)
 	node_source_item_set_flag (node_from_id (item->nodeId), item, newState);
 }
 
+static void
+item_state_flag_committed (gpointer user_data)
+{
+	vfolder_foreach (node_update_counters);
+}
+
 void
 item_flag_state_changed (itemPtr item, gboolean newState)
 {
@@ -51,10 +57,10 @@ item_flag_state_changed (itemPtr item, gboolean newState)
 	item->flagStatus = newState;
 
 	/* 2. save state to DB */
-	db_item_state_update (item);
+	db_item_state_update (item, RULE_DEPENDS_FLAG);
 
-	/* 3. update vfolder counters */
-	vfolder_foreach (node_update_counters);
+	/* 3. update vfolder counters once the state is written */
+	db_sync (item_state_flag_committed, NULL);
 
 	/* 4. update item list GUI state */
 	itemlist_update_item (item);
@@ -77,35 +83,33 @@ item_set_read_state (itemPtr item, gboolean newState)
 	node_source_item_mark_read (node_from_id (item->nodeId), item, newState);
 }
 
-void
-item_read_state_changed (itemPtr item, gboolean newState)
-{
-	nodePtr node;
+typedef struct readStateChange {
+	gulong		id;
+	gchar		*nodeId;
+	gchar		*sourceId;	/**< set if duplicates are to be updated */
+	gboolean	newState;
+} *readStateChangePtr;
 
-	debug_start_measurement (DEBUG_GUI);
-
-	/* 1. set values in memory */	
-	item->readStatus = newState;
-	item->updateStatus = FALSE;
-
-	/* 2. apply to DB */
-	db_item_state_update (item);
+/* Updates counters and duplicates after the read state is written */
+static void
+item_state_read_committed (gpointer user_data)
+{
+	readStateChangePtr	change = (readStateChangePtr)user_data;
+	nodePtr			node;
 
 	/* 3. propagate to vfolders */
 	vfolder_foreach (node_update_counters);
-	
-	/* 4. update item list GUI state */
-	itemlist_update_item (item);
 
 	/* 5. updated feed list unread counters */
-	node = node_from_id (item->nodeId);
-	node_update_counters (node);
+	node = node_from_id (change->nodeId);
+	if (node)
+		node_update_counters (node);
 
 	/* 6. duplicate state propagation */
-	if (item->validGuid) {
+	if (change->sourceId) {
 		GSList *duplicates, *iter;
 
-		duplicates = iter = db_item_get_duplicates (item->sourceId);
+		duplicates = iter = db_item_get_duplicates (change->sourceId);
 		while (iter) {
 			itemPtr duplicate = item_load (GPOINTER_TO_UINT (iter->data));
 
@@ -114,8 +118,8 @@ item_read_state_changed (itemPtr item, gboolean newState)
 			   associated node in the feed list. This should be 
 			   fixed by having the feed list in the DB too, so
 			   we can clean up correctly after crashes. */
-			if (duplicate && duplicate->id != item->id && node_from_id (duplicate->nodeId)) {
-				item_set_read_state (duplicate, newState);
+			if (duplicate && duplicate->id != change->id && node_from_id (duplicate->nodeId)) {
+				item_set_read_state (duplicate, change->newState);
 			}
 			if (duplicate) item_unload (duplicate);
 			iter = g_slist_next (iter);
@@ -123,6 +127,37 @@ item_read_state_changed (itemPtr item, gboolean newState)
 		g_slist_free (duplicates);
 	}
 
+	g_free (change->nodeId);
+	g_free (change->sourceId);
+	g_free (change);
+}
+
+void
+item_read_state_changed (itemPtr item, gboolean newState)
+{
+	readStateChangePtr	change;
+
+	debug_start_measurement (DEBUG_GUI);
+
+	/* 1. set values in memory */	
+	item->readStatus = newState;
+	item->updateStatus = FALSE;
+
+	/* 2. apply to DB */
+	db_item_state_update (item, RULE_DEPENDS_READ);
+
+	/* 3., 5. and 6. once the state is written */
+	change = g_new0 (struct readStateChange, 1);
+	change->id = item->id;
+	change->nodeId = g_strdup (item->nodeId);
+	if (item->validGuid)
+		change->sourceId = g_strdup (item->sourceId);
+	change->newState = newState;
+	db_sync (item_state_read_committed, change);
+	
+	/* 4. update item list GUI state */
+	itemlist_update_item (item);
+
 	debug_end_measurement (DEBUG_GUI, "set read status");
 }
 
@@ -138,11 +173,11 @@ void
 itemset_mark_read (nodePtr node)
 {
 	itemSetPtr	itemSet;
+	guint		i;
 
 	itemSet = node_get_itemset (node);
-	GList *iter = itemSet->ids;
-	while (iter) {
-		gulong id = GPOINTER_TO_UINT (iter->data);
+	for (i = 0; i < itemSet->ids->len; i++) {
+		gulong id = g_array_index (itemSet->ids, guint, i);
 		itemPtr item = item_load (id);
 		if (item) {
 			if (!item->readStatus) {
@@ -170,7 +205,6 @@ itemset_mark_read (nodePtr node)
 			}
 			item_unload (item);
 		}
-		iter = g_list_next (iter);
 	}
 
 	// FIXME: why not call itemset_free (itemSet); here? Crashes!
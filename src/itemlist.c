@@ -34,6 +34,7 @@
 #include "itemlist.h"
 #include "itemset.h"
 #include "metadata.h"
+#include "metrics.h"
 #include "node.h"
 #include "rule.h"
 #include "vfolder.h"
@@ -279,6 +280,7 @@ itemlist_load (nodePtr node)
 	itemSetPtr	itemSet;
 	gint		folder_display_mode;
 	gboolean	folder_display_hide_read;
+	gint64		loadStart = g_get_monotonic_time ();
 
 	debug_enter ("itemlist_load");
 
@@ -303,7 +305,7 @@ itemlist_load (nodePtr node)
 	
 		conf_get_bool_value (FOLDER_DISPLAY_HIDE_READ, &folder_display_hide_read);
 		if (folder_display_hide_read) {
-			itemlist->priv->filter = g_new0(struct itemSet, 1);
+			itemlist->priv->filter = itemset_new (NULL);
 			itemlist->priv->filter->anyMatch = TRUE;
 			itemset_add_rule (itemlist->priv->filter, "unread", "", TRUE);
 		}
@@ -331,6 +333,8 @@ itemlist_load (nodePtr node)
 
 	itemlist->priv->loading--;
 
+	metrics_record (METRIC_ITEMLIST_LOAD, g_get_monotonic_time () - loadStart);
+
 	debug_exit("itemlist_load");
 }
 
@@ -30,23 +30,109 @@
 #include "itemlist.h"
 #include "itemset.h"
 #include "metadata.h"
+#include "metrics.h"
 #include "node.h"
 #include "rule.h"
 #include "vfolder.h"
 #include "fl_sources/node_source.h"
 
+itemSetPtr
+itemset_new (const gchar *nodeId)
+{
+	itemSetPtr	itemSet;
+
+	itemSet = g_new0 (struct itemSet, 1);
+	itemSet->nodeId = (gchar *)nodeId;
+	itemSet->ids = g_array_new (FALSE, FALSE, sizeof (guint));
+
+	return itemSet;
+}
+
+static gint
+itemset_id_cmp (gconstpointer a, gconstpointer b)
+{
+	guint	id1 = *(const guint *)a;
+	guint	id2 = *(const guint *)b;
+
+	return (id1 > id2) - (id1 < id2);
+}
+
+/* Returns the index of the first id not less than the given one */
+static guint
+itemset_find_id (itemSetPtr itemSet, guint id)
+{
+	guint	*ids = (guint *)itemSet->ids->data;
+	guint	low = 0, high = itemSet->ids->len;
+
+	while (low < high) {
+		guint mid = low + (high - low) / 2;
+		if (ids[mid] < id)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+void
+itemset_add_id (itemSetPtr itemSet, guint id)
+{
+	guint	pos = itemset_find_id (itemSet, id);
+
+	if ((pos < itemSet->ids->len) && (g_array_index (itemSet->ids, guint, pos) == id))
+		return;
+
+	g_array_insert_val (itemSet->ids, pos, id);
+}
+
+void
+itemset_add_ids (itemSetPtr itemSet, const guint *ids, guint count)
+{
+	GArray	*sorted, *merged;
+	guint	*old, *new, i = 0, j = 0, last = 0;
+
+	if (!count)
+		return;
+
+	sorted = g_array_sized_new (FALSE, FALSE, sizeof (guint), count);
+	g_array_append_vals (sorted, ids, count);
+	g_array_sort (sorted, itemset_id_cmp);
+
+	/* merge both sorted arrays dropping duplicates */
+	merged = g_array_sized_new (FALSE, FALSE, sizeof (guint), itemSet->ids->len + count);
+	old = (guint *)itemSet->ids->data;
+	new = (guint *)sorted->data;
+	while (i < itemSet->ids->len || j < sorted->len) {
+		guint id;
+
+		if (j == sorted->len || (i < itemSet->ids->len && old[i] < new[j]))
+			id = old[i++];
+		else
+			id = new[j++];
+
+		if (merged->len && id == last)
+			continue;
+		g_array_append_val (merged, id);
+		last = id;
+	}
+
+	g_array_free (sorted, TRUE);
+	g_array_free (itemSet->ids, TRUE);
+	itemSet->ids = merged;
+}
+
 void
 itemset_foreach (itemSetPtr itemSet, itemActionFunc callback)
 {
-	GList	*iter = itemSet->ids;
+	guint	i;
 	
-	while(iter) {
-		itemPtr item = item_load (GPOINTER_TO_UINT (iter->data));
+	for (i = 0; i < itemSet->ids->len; i++) {
+		itemPtr item = item_load (g_array_index (itemSet->ids, guint, i));
 		if (item) {
 			(*callback) (item);
 			item_unload (item);
 		}
-		iter = g_list_next (iter);
 	}
 }
 
@@ -157,6 +243,9 @@ itemset_generic_merge_check (GList *items, itemPtr newItem, gint maxChecks, gboo
 		/* if the item was found but has other contents -> update contents */
 		if (!equal) {
 			if (allowUpdates) {
+				/* the description and metadata are handed over to the old item */
+				item_promote (newItem);
+
 				/* no item_set_new_status() - we don't treat changed items as new items! */
 				item_set_title (oldItem, item_get_title (newItem));
 				
@@ -220,6 +309,10 @@ itemset_merge_item (itemSetPtr itemSet, GList *items, itemPtr item, gint maxChec
 	if (merge) {
 		g_assert (!item->nodeId);
 		g_assert (!item->id);
+
+		/* the item survives merging, move it out of the parser arena */
+		item_promote (item);
+
 		item->nodeId = g_strdup (itemSet->nodeId);
 		if (!item->parentNodeId)
 			item->parentNodeId = g_strdup (itemSet->nodeId);
@@ -228,7 +321,7 @@ itemset_merge_item (itemSetPtr itemSet, GList *items, itemPtr item, gint maxChec
 		db_item_update (item);
 		
 		/* step 2: add to itemset */
-		itemSet->ids = g_list_prepend (itemSet->ids, GUINT_TO_POINTER (item->id));
+		itemset_add_id (itemSet, item->id);
 
 		/* step 3: enrich item description */
 		if (node && IS_FEED (node) && ((feedPtr)node->data)->html5Extract)
@@ -308,8 +401,12 @@ itemset_merge_items (itemSetPtr itemSet, GList *list, gboolean allowUpdates, gbo
 {
 	GList	*iter, *droppedItems = NULL, *items = NULL;
 	guint	i, max, length, toBeDropped, newCount = 0, flagCount = 0;
+	gint64	mergeStart = g_get_monotonic_time ();
 
 	debug_start_measurement (DEBUG_UPDATE);
+	debug_span_begin ("itemset merge");
+	debug_span_arg_str ("node", itemSet->nodeId);
+	debug_span_arg_int ("items", g_list_length (list));
 	
 	debug2 (DEBUG_UPDATE, "old item set %p of (node id=%s):", itemSet, itemSet->nodeId);
 	
@@ -323,17 +420,16 @@ itemset_merge_items (itemSetPtr itemSet, GList *list, gboolean allowUpdates, gbo
 	max = itemset_get_max_item_count (itemSet);
 
 	/* Preload all items for flag counting and later merging comparison */
-	iter = itemSet->ids;
-	while (iter) {
-		itemPtr item = item_load (GPOINTER_TO_UINT (iter->data));
+	for (i = 0; i < itemSet->ids->len; i++) {
+		itemPtr item = item_load (g_array_index (itemSet->ids, guint, i));
 		if (item) {
-			items = g_list_append (items, item);
+			items = g_list_prepend (items, item);
 			if (item->flagStatus)
 				flagCount++;
 		}
-		iter = g_list_next (iter);
 	}
-	debug1(DEBUG_UPDATE, "current cache size: %d", g_list_length(itemSet->ids));
+	items = g_list_reverse (items);
+	debug1(DEBUG_UPDATE, "current cache size: %u", itemSet->ids->len);
 	debug1(DEBUG_UPDATE, "current cache limit: %d", max);
 	debug1(DEBUG_UPDATE, "downloaded feed size: %d", g_list_length(list));
 	debug1(DEBUG_UPDATE, "flag count: %d", flagCount);
@@ -441,6 +537,9 @@ itemset_merge_items (itemSetPtr itemSet, GList *list, gboolean allowUpdates, gbo
 	g_list_free (items);
 	
 	debug_end_measurement (DEBUG_UPDATE, "merge itemset");
+	metrics_record (METRIC_ITEMSET_MERGE, g_get_monotonic_time () - mergeStart);
+	debug_span_arg_int ("new", newCount);
+	debug_span_end ();
 	
 	return newCount;
 }
@@ -467,6 +566,18 @@ itemset_check_item (itemSetPtr itemSet, itemPtr item)
 	return result;
 }
 
+guint
+itemset_get_rule_depends (itemSetPtr itemSet)
+{
+	guint	depends = 0;
+	GSList	*iter;
+
+	for (iter = itemSet->rules; iter; iter = g_slist_next (iter))
+		depends |= ((rulePtr) iter->data)->ruleInfo->depends;
+
+	return depends;
+}
+
 void
 itemset_add_rule (itemSetPtr itemSet,
                   const gchar *ruleId,
@@ -496,6 +607,7 @@ itemset_free (itemSetPtr itemSet)
 		rule = g_slist_next (rule);
 	}
 	g_slist_free (itemSet->rules);
-	g_list_free (itemSet->ids);
+	if (itemSet->ids)
+		g_array_free (itemSet->ids, TRUE);
 	g_free (itemSet);
 }
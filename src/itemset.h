@@ -35,10 +35,40 @@ typedef struct itemSet {
 	GSList		*rules;		/*<< list of rules each item matches */
 	gboolean	anyMatch;	/*<< TRUE means only one of the rules must match for item inclusion */
 	
-	GList		*ids;		/*<< the list of item ids */
+	GArray		*ids;		/*<< sorted array of guint item ids */
 	gchar		*nodeId;	/*<< the feed list node id this item set belongs to */
 } *itemSetPtr;
 
+/**
+ * itemset_new: (skip)
+ * @nodeId:	the feed list node id (or NULL)
+ *
+ * Creates a new empty item set.
+ *
+ * Returns: (transfer full): the new item set
+ */
+itemSetPtr itemset_new (const gchar *nodeId);
+
+/**
+ * itemset_add_id: (skip)
+ * @itemSet:	the item set
+ * @id:		the item id
+ *
+ * Inserts a single item id into the sorted id array.
+ */
+void itemset_add_id (itemSetPtr itemSet, guint id);
+
+/**
+ * itemset_add_ids: (skip)
+ * @itemSet:	the item set
+ * @ids:	array of item ids in any order
+ * @count:	number of ids
+ *
+ * Adds many item ids at once, which costs a single sort
+ * and merge instead of one insertion per id.
+ */
+void itemset_add_ids (itemSetPtr itemSet, const guint *ids, guint count);
+
 /* item set iterating interface */
 
 typedef void 	(*itemActionFunc)	(itemPtr item);
@@ -77,6 +107,16 @@ guint itemset_merge_items(itemSetPtr itemSet, GList *items, gboolean allowUpdate
  */
 gboolean itemset_check_item (itemSetPtr itemSet, itemPtr item);
 
+/**
+ * itemset_get_rule_depends: (skip)
+ * @itemSet:	the itemSet
+ *
+ * Determines which item properties the rules of the item set check.
+ *
+ * Returns: the combined ruleDepends flags of all rules
+ */
+guint itemset_get_rule_depends (itemSetPtr itemSet);
+
 /**
  * itemset_add_rule: (skip)
  * @itemSet:	the item set
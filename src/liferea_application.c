@@ -31,6 +31,10 @@
 #endif
 
 #include <string.h>
+#ifdef G_OS_UNIX
+#include <glib-unix.h>
+#include <signal.h>
+#endif
 
 #include "conf.h"
 #include "common.h"
@@ -38,6 +42,7 @@
 #include "dbus.h"
 #include "debug.h"
 #include "feedlist.h"
+#include "itemlist.h"
 #include "social.h"
 #include "update.h"
 #include "xml.h"
@@ -49,6 +54,7 @@ struct _LifereaApplication {
 	GtkApplication	parent;
 	gchar		*initialStateOption;
 	gint		pluginsDisabled;
+	gint		profileStartup;
 	LifereaDBus	*dbus;
 	gulong		debug_flags;
 };
@@ -59,6 +65,10 @@ struct _LifereaApplicationClass {
 
 G_DEFINE_TYPE (LifereaApplication, liferea_application, GTK_TYPE_APPLICATION)
 
+/* option values shared with the headless mode (see engine_entries) */
+static gboolean headlessOption = FALSE;
+static gchar *traceFileOption = NULL;
+
 
 static void
 liferea_application_finalize (GObject *gobject)
@@ -103,6 +113,14 @@ on_app_open (GApplication *application,
 	}
 }
 
+static gboolean
+on_app_startup_finished (gpointer user_data)
+{
+	debug_startup_profile_finish ();
+
+	return FALSE;
+}
+
 /* GApplication "activate" callback emitted on the primary instance.  */
 static void
 on_app_activate (GtkApplication *gtk_app, gpointer user_data)
@@ -121,6 +139,7 @@ on_app_activate (GtkApplication *gtk_app, gpointer user_data)
 		gtk_window_present (GTK_WINDOW (list->data));
 	} else {
 		liferea_shell_create (gtk_app, app->initialStateOption, app->pluginsDisabled);
+		g_idle_add (on_app_startup_finished, NULL);
 	}
 
 	css_filename = g_build_filename (PACKAGE_DATA_DIR, PACKAGE, "liferea.css", NULL);
@@ -146,6 +165,17 @@ on_app_activate (GtkApplication *gtk_app, gpointer user_data)
 	g_free (css_filename);
 }
 
+#ifdef G_OS_UNIX
+/* Writes the trace recorded so far on SIGUSR1 */
+static gboolean
+on_trace_dump_signal (gpointer user_data)
+{
+	debug_trace_dump ();
+
+	return TRUE;
+}
+#endif
+
 /* Callback to the startup signal emitted only by the primary instance upon registration. */
 static void
 on_app_startup (GApplication *gapp, gpointer user_data)
@@ -154,20 +184,34 @@ on_app_startup (GApplication *gapp, gpointer user_data)
 
 	set_debug_level (app->debug_flags);
 
+	if (app->profileStartup)
+		debug_startup_profile_enable ();
+
+	if (traceFileOption) {
+		debug_trace_enable (traceFileOption);
+#ifdef G_OS_UNIX
+		g_unix_signal_add (SIGUSR1, on_trace_dump_signal, NULL);
+#endif
+	}
+
 	/* Configuration necessary for network options, so it
 	   has to be initialized before update_init() */
 	conf_init ();
+	debug_startup_phase ("configuration");
 
 	/* We need to do the network initialization here to allow
 	   network-manager to be setup before gtk_init() */
 	update_init ();
+	debug_startup_phase ("network setup");
 
 	/* order is important! */
 	db_init ();			/* initialize sqlite */
 	xml_init ();			/* initialize libxml2 */
 	social_init ();			/* initialize social bookmarking */
+	debug_startup_phase ("libxml2 and social bookmarking setup");
 
 	app->dbus = liferea_dbus_new ();
+	debug_startup_phase ("DBUS setup");
 }
 
 /* Callback to the "shutdown" signal emitted only on the primary instance; */
@@ -193,6 +237,8 @@ on_app_shutdown (GApplication *app, gpointer user_data)
 	conf_deinit ();
 
 	debug_exit ("liferea_shutdown");
+
+	debug_trace_dump ();
 }
 
 static void
@@ -242,6 +288,31 @@ debug_entries_parse_callback (const gchar *option_name,
 	return TRUE;
 }
 
+static GOptionEntry debug_entries[] = {
+	{ "debug-all", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of all types"), NULL },
+	{ "debug-cache", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages for the cache handling"), NULL },
+	{ "debug-conf", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages for the configuration handling"), NULL },
+	{ "debug-db", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of the database handling"), NULL },
+	{ "debug-gui", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of all GUI functions"), NULL },
+	{ "debug-html", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Enables HTML rendering debugging. Each time Liferea renders HTML output it will also dump the generated HTML into ~/.cache/liferea/output.xhtml"), NULL },
+	{ "debug-net", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of all network activity"), NULL },
+	{ "debug-parsing", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of all parsing functions"), NULL },
+	{ "debug-performance", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages when a function takes too long to process"), NULL },
+	{ "debug-trace", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages when entering/leaving functions"), NULL },
+	{ "debug-update", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of the feed update processing"), NULL },
+	{ "debug-vfolder", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of the search folder matching"), NULL },
+	{ "debug-verbose", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print verbose debugging messages"), NULL },
+	{ NULL, 0, 0, 0, NULL, NULL, NULL }
+};
+
+/* Options understood by both the GApplication and the headless mode */
+static GOptionEntry engine_entries[] = {
+	{ "trace-file", 0, 0, G_OPTION_ARG_FILENAME, &traceFileOption, N_("Record trace spans and write them as Chrome trace events to FILE on exit or on SIGUSR1"), N_("FILE") },
+	/* for the GApplication only listed here, main() runs liferea_application_run_headless() */
+	{ "headless", 0, 0, G_OPTION_ARG_NONE, &headlessOption, N_("Run only the feed update engine without any window, to be controlled via DBUS"), NULL },
+	{ NULL, 0, 0, 0, NULL, NULL, NULL }
+};
+
 static gint
 on_handle_local_options (GApplication *app, GVariantDict *options, gpointer user_data)
 {
@@ -283,23 +354,7 @@ liferea_application_init (LifereaApplication *self)
 		{ "version", 'v', G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, NULL, N_("Show version information and exit"), NULL },
 		{ "add-feed", 'a', 0, G_OPTION_ARG_STRING, NULL, N_("Add a new subscription"), N_("uri") },
 		{ "disable-plugins", 'p', 0, G_OPTION_FLAG_NONE, &self->pluginsDisabled, N_("Start with all plugins disabled"), NULL },
-		{ NULL, 0, 0, 0, NULL, NULL, NULL }
-	};
-
-	GOptionEntry debug_entries[] = {
-		{ "debug-all", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of all types"), NULL },
-		{ "debug-cache", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages for the cache handling"), NULL },
-		{ "debug-conf", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages for the configuration handling"), NULL },
-		{ "debug-db", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of the database handling"), NULL },
-		{ "debug-gui", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of all GUI functions"), NULL },
-		{ "debug-html", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Enables HTML rendering debugging. Each time Liferea renders HTML output it will also dump the generated HTML into ~/.cache/liferea/output.xhtml"), NULL },
-		{ "debug-net", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of all network activity"), NULL },
-		{ "debug-parsing", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of all parsing functions"), NULL },
-		{ "debug-performance", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages when a function takes too long to process"), NULL },
-		{ "debug-trace", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages when entering/leaving functions"), NULL },
-		{ "debug-update", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of the feed update processing"), NULL },
-		{ "debug-vfolder", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print debugging messages of the search folder matching"), NULL },
-		{ "debug-verbose", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, debug_entries_parse_callback, N_("Print verbose debugging messages"), NULL },
+		{ "profile-startup", 0, 0, G_OPTION_FLAG_NONE, &self->profileStartup, N_("Print a timeline of the startup phases"), NULL },
 		{ NULL, 0, 0, 0, NULL, NULL, NULL }
 	};
 
@@ -312,6 +367,7 @@ liferea_application_init (LifereaApplication *self)
 	g_option_group_add_entries (debug, debug_entries);
 
 	g_application_add_main_option_entries (G_APPLICATION (self), entries);
+	g_application_add_main_option_entries (G_APPLICATION (self), engine_entries);
 	g_application_add_option_group (G_APPLICATION (self), debug);
 	g_application_add_option_group (G_APPLICATION (self), g_irepository_get_option_group ());
 
@@ -331,3 +387,85 @@ liferea_application_new(void)
 		"application-id", "net.sourceforge.liferea",
 		NULL);
 }
+
+/* Headless mode: the update engine without GTK, controlled over DBUS */
+
+static GMainLoop *headlessLoop = NULL;
+
+void
+liferea_application_quit_headless (void)
+{
+	if (headlessLoop)
+		g_main_loop_quit (headlessLoop);
+}
+
+gint
+liferea_application_run_headless (int argc, char *argv[])
+{
+	GOptionContext	*context;
+	GOptionGroup	*debug;
+	GError		*error = NULL;
+	LifereaDBus	*dbus;
+	ItemList	*itemlist;
+	FeedList	*feedlist;
+	gulong		debug_flags = 0;
+
+	context = g_option_context_new (NULL);
+	g_option_context_add_main_entries (context, engine_entries, GETTEXT_PACKAGE);
+	debug = g_option_group_new ("debug",
+				    _("Print debugging messages for the given topic"),
+				    _("Print debugging messages for the given topic"),
+				    &debug_flags,
+				    NULL);
+	g_option_group_set_translation_domain (debug, GETTEXT_PACKAGE);
+	g_option_group_add_entries (debug, debug_entries);
+	g_option_context_add_group (context, debug);
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		g_option_context_free (context);
+		return 1;
+	}
+	g_option_context_free (context);
+
+	set_debug_level (debug_flags);
+
+	if (traceFileOption) {
+		debug_trace_enable (traceFileOption);
+#ifdef G_OS_UNIX
+		g_unix_signal_add (SIGUSR1, on_trace_dump_signal, NULL);
+#endif
+	}
+
+	/* Same order as in on_app_startup(), but without the
+	   shell: no GTK, WebKit or display is needed. All data
+	   is read from and written to the XDG user directories,
+	   so a temporary cache can be used by setting them. */
+	conf_init ();
+	update_init ();
+	db_init ();
+	xml_init ();
+
+	dbus = liferea_dbus_new ();
+	itemlist = itemlist_create ();
+	feedlist = feedlist_create ();
+	debug0 (DEBUG_UPDATE, "running headless");
+
+	headlessLoop = g_main_loop_new (NULL, FALSE);
+	g_main_loop_run (headlessLoop);
+	g_main_loop_unref (headlessLoop);
+	headlessLoop = NULL;
+
+	/* order is important ! */
+	update_deinit ();
+	g_object_unref (feedlist);
+	g_object_unref (itemlist);
+	g_object_unref (dbus);
+	db_deinit ();
+	conf_deinit ();
+
+	debug_trace_dump ();
+	g_clear_pointer (&traceFileOption, g_free);
+
+	return 0;
+}
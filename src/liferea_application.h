@@ -39,4 +39,22 @@ GType liferea_application_get_type ();
 
 LifereaApplication * liferea_application_new();
 
+/**
+ * Runs the feed update engine without user interface until
+ * liferea_application_quit_headless() is called. Loads the
+ * feed list, runs the update scheduler and stores results
+ * in the DB like the GUI does. Control is via DBUS only.
+ *
+ * @param argc		command line argument count
+ * @param argv		command line arguments (including --headless)
+ *
+ * @returns the exit status
+ */
+gint liferea_application_run_headless (int argc, char *argv[]);
+
+/**
+ * Stops a headless instance started with liferea_application_run_headless().
+ */
+void liferea_application_quit_headless (void);
+
 #endif
@@ -37,7 +37,10 @@ static LifereaApplication *liferea_app = NULL;
 gboolean
 liferea_shutdown_source_func (gpointer userdata)
 {
-	g_application_quit (G_APPLICATION (liferea_app));
+	if (liferea_app)
+		g_application_quit (G_APPLICATION (liferea_app));
+	else
+		liferea_application_quit_headless ();
 	return FALSE;
 }
 
@@ -55,7 +58,7 @@ signal_handler (int sig)
 int
 main (int argc, char *argv[])
 {
-	gint status;
+	gint status, i;
 
 	signal (SIGTERM, signal_handler);
 	signal (SIGINT, signal_handler);
@@ -69,6 +72,14 @@ main (int argc, char *argv[])
 	textdomain (GETTEXT_PACKAGE);
 #endif
 
+	/* Headless mode must bypass GtkApplication which needs a display */
+	for (i = 1; i < argc; i++) {
+		if (g_str_equal (argv[i], "--headless")) {
+			g_set_prgname ("liferea");
+			return liferea_application_run_headless (argc, argv);
+		}
+	}
+
 	liferea_app = liferea_application_new ();
 	g_set_prgname ("liferea");
 	g_set_application_name (_("Liferea"));
@@ -36,8 +36,9 @@
 static GHashTable *metadataTypes = NULL;	/**< hash table with all registered meta data types */
 
 struct pair {
-	gchar		*strid;		/** metadata type id */
+	const gchar	*strid;		/** metadata type id (interned) */
 	GSList		*data;		/** list of metadata values */
+	GStringChunk	*arena;		/** string arena holding the values (or NULL) */
 };
 
 /* register metadata types to check validity on adding */
@@ -158,11 +159,50 @@ metadata_value_cmp (gconstpointer a, gconstpointer b)
 	return 1;
 }
 
+/* Stores a value as required by the pair, takes ownership of owned
+   which if given is a heap copy of value. */
+static gchar *
+metadata_value_store (struct pair *p, const gchar *value, gchar *owned)
+{
+	gchar	*result;
+
+	if (!p->arena || !value)
+		return owned?owned:g_strdup (value);
+
+	result = g_string_chunk_insert (p->arena, value);
+	g_free (owned);
+	return result;
+}
+
+static void
+metadata_values_free (struct pair *p)
+{
+	if (!p->arena)
+		g_slist_free_full (p->data, g_free);
+	else
+		g_slist_free (p->data);
+	p->data = NULL;
+}
+
+static struct pair *
+metadata_pair_new (const gchar *strid, GStringChunk *arena)
+{
+	struct pair	*p;
+
+	p = g_new (struct pair, 1);
+	p->strid = g_intern_string (strid);
+	p->data = NULL;
+	p->arena = arena;
+
+	return p;
+}
+
 GSList *
-metadata_list_append (GSList *metadata, const gchar *strid, const gchar *data)
+metadata_list_append_arena (GSList *metadata, GStringChunk *arena, const gchar *strid, const gchar *data)
 {
 	GSList		*iter = metadata;
-	gchar		*tmp, *checked_data = NULL;
+	gchar		*checked_data = NULL, *tmp;
+	const gchar	*value;
 	struct pair 	*p;
 	
 	if (!data)
@@ -172,7 +212,7 @@ metadata_list_append (GSList *metadata, const gchar *strid, const gchar *data)
 	switch (metadata_get_type (strid)) {
 		case METADATA_TYPE_TEXT:
 			/* No check because renderer will process further */
-			checked_data = g_strdup (data);
+			value = data;
 			break;
 		case METADATA_TYPE_URL:
 			/* Simple sanity check to see if it doesn't break XML */
@@ -183,22 +223,22 @@ metadata_list_append (GSList *metadata, const gchar *strid, const gchar *data)
 			}
 			
 			/* finally strip whitespace */
-			checked_data = g_strchomp (checked_data);
+			value = checked_data = g_strchomp (checked_data);
 			break;
 		default:
 			g_warning ("Unknown metadata type: %s (id=%d), please report this Liferea bug! Treating as HTML.", strid, metadata_get_type (strid));
 		case METADATA_TYPE_HTML:
-			/* Needs to check for proper XHTML */
+			/* Needs to check for proper XHTML and to remove DHTML */
 			if (xhtml_is_well_formed (data)) {
-				tmp = g_strdup (data);
+				checked_data = xhtml_strip_dhtml (data);
 			} else {
 				debug1 (DEBUG_PARSING, "not well formed HTML: %s", data);
 				tmp = g_markup_escape_text (data, -1);
 				debug1 (DEBUG_PARSING, "escaped as: %s", tmp);
+				checked_data = xhtml_strip_dhtml (tmp);
+				g_free (tmp);
 			}
-			/* And needs to remove DHTML */
-			checked_data = xhtml_strip_dhtml (tmp);
-			g_free (tmp);
+			value = checked_data;
 			break;
 	}
 	
@@ -206,23 +246,28 @@ metadata_list_append (GSList *metadata, const gchar *strid, const gchar *data)
 		p = (struct pair*)iter->data; 
 		if (g_str_equal (p->strid, strid)) {
 			/* Avoid duplicate values */
-			if (NULL == g_slist_find_custom (p->data, checked_data, metadata_value_cmp))
-				p->data = g_slist_append (p->data, checked_data);
+			if (NULL == g_slist_find_custom (p->data, value, metadata_value_cmp))
+				p->data = g_slist_append (p->data, metadata_value_store (p, value, checked_data));
                         else
                                 g_free (checked_data);
 			return metadata;
 		}
 		iter = iter->next;
 	}
-	p = g_new (struct pair, 1);
-	p->strid = g_strdup (strid);
-	p->data = g_slist_append (NULL, checked_data);
+	p = metadata_pair_new (strid, arena);
+	p->data = g_slist_append (NULL, metadata_value_store (p, value, checked_data));
 	metadata = g_slist_append (metadata, p);
 	return metadata;
 }
 
+GSList *
+metadata_list_append (GSList *metadata, const gchar *strid, const gchar *data)
+{
+	return metadata_list_append_arena (metadata, NULL, strid, data);
+}
+
 void
-metadata_list_set (GSList **metadata, const gchar *strid, const gchar *data)
+metadata_list_set_arena (GSList **metadata, GStringChunk *arena, const gchar *strid, const gchar *data)
 {
 	GSList	*iter = *metadata;
 	struct pair *p;
@@ -230,18 +275,39 @@ metadata_list_set (GSList **metadata, const gchar *strid, const gchar *data)
 	while (iter) {
 		p = (struct pair*)iter->data; 
 		if (g_str_equal (p->strid, strid)) {
-                        g_slist_free_full (p->data, g_free);
-                        p->data = g_slist_append (NULL, g_strdup (data));
+			metadata_values_free (p);
+			p->data = g_slist_append (NULL, metadata_value_store (p, data, NULL));
 			return;
 		}
 		iter = iter->next;
 	}
-	p = g_new (struct pair, 1);
-	p->strid = g_strdup (strid);
-	p->data = g_slist_append (NULL, g_strdup (data));
+	p = metadata_pair_new (strid, arena);
+	p->data = g_slist_append (NULL, metadata_value_store (p, data, NULL));
 	*metadata = g_slist_append (*metadata, p);
 }
 
+void
+metadata_list_set (GSList **metadata, const gchar *strid, const gchar *data)
+{
+	metadata_list_set_arena (metadata, NULL, strid, data);
+}
+
+void
+metadata_list_promote (GSList *metadata)
+{
+	GSList	*iter, *values;
+
+	for (iter = metadata; iter; iter = iter->next) {
+		struct pair *p = (struct pair*)iter->data;
+		if (!p->arena)
+			continue;
+
+		for (values = p->data; values; values = values->next)
+			values->data = g_strdup (values->data);
+		p->arena = NULL;
+	}
+}
+
 void
 metadata_list_foreach (GSList *metadata, metadataForeachFunc func, gpointer user_data)
 {
@@ -311,8 +377,7 @@ metadata_list_free (GSList *metadata)
 	
 	while (iter) {
 		struct pair *p = (struct pair*)iter->data;
-                g_slist_free_full (p->data, g_free);
-		g_free (p->strid);
+		metadata_values_free (p);
 		g_free (p);
 		iter = iter->next;
 	}
@@ -93,6 +93,40 @@ GSList * metadata_list_append(GSList *metadata, const gchar *strid, const gchar
  */
 void metadata_list_set(GSList **metadata, const gchar *strid, const gchar *data);
 
+/**
+ * Like metadata_list_append(), but copies the values of a new type
+ * into the given string arena instead of allocating each of them.
+ * Values added later to the same type always end up where the
+ * existing values are.
+ *
+ * @param metadata	the metadata list
+ * @param arena		the string arena (or NULL)
+ * @param strid		the metadata type identifier
+ * @param data		data to add
+ *
+ * @returns the changed meta data list
+ */
+GSList * metadata_list_append_arena (GSList *metadata, GStringChunk *arena, const gchar *strid, const gchar *data);
+
+/**
+ * Like metadata_list_set(), but copies the value of a new type
+ * into the given string arena.
+ *
+ * @param metadata	the metadata list
+ * @param arena		the string arena (or NULL)
+ * @param strid		the metadata type identifier
+ * @param data		data to add
+ */
+void metadata_list_set_arena (GSList **metadata, GStringChunk *arena, const gchar *strid, const gchar *data);
+
+/**
+ * Copies all values stored in a string arena out of it, so that
+ * the list stays valid after the arena is freed.
+ *
+ * @param metadata	the metadata list
+ */
+void metadata_list_promote (GSList *metadata);
+
 /**
  * Returns the first value of a given type from a specified metadata list.
  * Do use this function only for single instance types.
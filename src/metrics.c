@@ -0,0 +1,105 @@
+/**
+ * @file metrics.c   runtime counters and duration histograms
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "metrics.h"
+
+typedef struct histogram {
+	guint64	count;
+	guint64	sum;
+	guint64	max;
+	guint64	buckets[METRIC_BUCKETS];
+} histogram;
+
+/* Names as returned by GetStats, in the order of the enums */
+static const gchar *counterNames[METRIC_COUNTER_MAX] = {
+	"update.jobs",
+	"update.bytes",
+	"db.statements"
+};
+
+static const gchar *histogramNames[METRIC_HISTOGRAM_MAX] = {
+	"feed.parse",
+	"itemset.merge",
+	"db.statement",
+	"itemlist.load"
+};
+
+/* Metrics are recorded from the DB writer and worker threads too,
+   so everything is protected by a single lock. Recording is just
+   a few additions, so the lock is never held for long. */
+static GMutex	lock;
+static guint64	counters[METRIC_COUNTER_MAX];
+static histogram histograms[METRIC_HISTOGRAM_MAX];
+
+void
+metrics_count (metricCounter counter, guint64 value)
+{
+	g_mutex_lock (&lock);
+	counters[counter] += value;
+	g_mutex_unlock (&lock);
+}
+
+void
+metrics_record (metricHistogram id, guint64 usec)
+{
+	histogram	*h = &histograms[id];
+	guint		bucket = 0;
+
+	while (bucket < METRIC_BUCKETS - 1 && usec >= (G_GUINT64_CONSTANT (1) << bucket))
+		bucket++;
+
+	g_mutex_lock (&lock);
+	h->count++;
+	h->sum += usec;
+	if (usec > h->max)
+		h->max = usec;
+	h->buckets[bucket]++;
+	g_mutex_unlock (&lock);
+}
+
+void
+metrics_add_counters (GVariantBuilder *builder)
+{
+	guint	i;
+
+	g_mutex_lock (&lock);
+	for (i = 0; i < METRIC_COUNTER_MAX; i++)
+		g_variant_builder_add (builder, "{st}", counterNames[i], counters[i]);
+	g_mutex_unlock (&lock);
+}
+
+void
+metrics_add_histograms (GVariantBuilder *builder)
+{
+	guint	i, j;
+
+	g_mutex_lock (&lock);
+	for (i = 0; i < METRIC_HISTOGRAM_MAX; i++) {
+		histogram	*h = &histograms[i];
+		GVariantBuilder	buckets;
+
+		g_variant_builder_init (&buckets, G_VARIANT_TYPE ("at"));
+		for (j = 0; j < METRIC_BUCKETS; j++)
+			g_variant_builder_add (&buckets, "t", h->buckets[j]);
+
+		g_variant_builder_add (builder, "{s(tttat)}", histogramNames[i], h->count, h->sum, h->max, &buckets);
+	}
+	g_mutex_unlock (&lock);
+}
@@ -0,0 +1,78 @@
+/**
+ * @file metrics.h   runtime counters and duration histograms
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _METRICS_H
+#define _METRICS_H
+
+#include <glib.h>
+
+/** counters, always enabled and summed up since program start */
+typedef enum {
+	METRIC_UPDATE_JOBS,		/**< finished update jobs */
+	METRIC_UPDATE_BYTES,		/**< bytes downloaded by update jobs */
+	METRIC_DB_STATEMENTS,		/**< executed DB statements */
+	METRIC_COUNTER_MAX
+} metricCounter;
+
+/** duration histograms (in microseconds) */
+typedef enum {
+	METRIC_FEED_PARSE,		/**< parsing a downloaded feed */
+	METRIC_ITEMSET_MERGE,		/**< merging parsed items into a feed */
+	METRIC_DB_STATEMENT,		/**< executing a DB statement */
+	METRIC_ITEMLIST_LOAD,		/**< loading a node into the item list */
+	METRIC_HISTOGRAM_MAX
+} metricHistogram;
+
+/** Histogram bucket n counts durations below 2^n microseconds, the last one all longer durations */
+#define METRIC_BUCKETS	24
+
+/**
+ * Adds to a counter. Thread-safe.
+ *
+ * @param counter	the counter
+ * @param value		the amount to add
+ */
+void metrics_count (metricCounter counter, guint64 value);
+
+/**
+ * Records a duration into a histogram. Thread-safe.
+ *
+ * @param histogram	the histogram
+ * @param usec		the duration in microseconds
+ */
+void metrics_record (metricHistogram histogram, guint64 usec);
+
+/**
+ * Adds all counters to the given builder of type "a{st}".
+ *
+ * @param builder	the variant builder
+ */
+void metrics_add_counters (GVariantBuilder *builder);
+
+/**
+ * Adds all histograms to the given builder of type "a{s(tttat)}".
+ * Each histogram is a tuple of count, sum, maximum and the
+ * METRIC_BUCKETS bucket counts.
+ *
+ * @param builder	the variant builder
+ */
+void metrics_add_histograms (GVariantBuilder *builder);
+
+#endif
@@ -87,6 +87,10 @@ network_process_callback (SoupSession *session, SoupMessage *msg, gpointer user_
 	job->result->size = (size_t)msg->response_body->length;
 	debug1 (DEBUG_NET, "%d bytes downloaded", job->result->size);
 
+	/* With content decoding the body is larger than the transfer */
+	if (soup_message_headers_get_content_length (msg->response_headers) > 0)
+		job->result->timings->rawBytes = soup_message_headers_get_content_length (msg->response_headers);
+
 	job->result->contentType = g_strdup (soup_message_headers_get_content_type (msg->response_headers, NULL));
 
 	/* Update last-modified date */
@@ -188,6 +188,7 @@ node_free (nodePtr node)
 	g_hash_table_remove (nodes, node->id);
 	
 	update_job_cancel_by_owner (node);
+	favicon_download_cancel (node->id);
 
 	if (node->subscription)
 		subscription_free (node->subscription);
@@ -49,6 +49,9 @@
 
 #define ATOM10_NS BAD_CAST"http://www.w3.org/2005/Atom"
 
+/* for feed_parser_ctxt_ns_id(), Atom 1.0 has id 0 */
+static const gchar *atom10Namespaces[] = { (const gchar *)ATOM10_NS, NULL };
+
 /* to store the ATOMNsHandler structs for all supported RDF namespace handlers */
 GHashTable	*atom10_nstable = NULL;
 GHashTable	*ns_atom10_ns_uri_table = NULL;
@@ -291,7 +294,7 @@ atom10_parse_link (xmlNodePtr cur, feedParserCtxtPtr ctxt, struct atom10ParserSt
 			if (!type || g_str_equal (type, BAD_CAST"application/atom+xml")) {
 				gchar *commentUri = (gchar *)common_build_url ((gchar *)url, subscription_get_homepage (ctxt->subscription));
 				if (ctxt->item)
-					metadata_list_set (&ctxt->item->metadata, "commentFeedUri", commentUri);
+					item_metadata_set (ctxt->item, "commentFeedUri", commentUri);
 				g_free (commentUri);
 			}
 		} else if (g_str_equal (relation, "enclosure")) {
@@ -303,13 +306,13 @@ atom10_parse_link (xmlNodePtr cur, feedParserCtxtPtr ctxt, struct atom10ParserSt
 				g_free (lengthStr);
 				
 				gchar *encStr = enclosure_values_to_string (url, type, length, FALSE /* not yet downloaded */);
-				ctxt->item->metadata = metadata_list_append (ctxt->item->metadata, "enclosure", encStr);
+				item_metadata_append (ctxt->item, "enclosure", encStr);
 				ctxt->item->hasEnclosure = TRUE;
 				g_free (encStr);
 			}
 		} else if (g_str_equal (relation, "related") || g_str_equal (relation, "via")) {	
 			if (ctxt->item)
-				ctxt->item->metadata = metadata_list_append (ctxt->item->metadata, relation, url);
+				item_metadata_append (ctxt->item, relation, url);
 		} else {
 			/* g_warning ("Unhandled Atom link with unexpected relation \"%s\"\n", relation); */
 		}
@@ -334,7 +337,7 @@ atom10_parse_entry_author (xmlNodePtr cur, feedParserCtxtPtr ctxt, struct atom10
 	
 	author = atom10_parse_person_construct (cur);
 	if (author) {
-		ctxt->item->metadata = metadata_list_append (ctxt->item->metadata, "author", author);
+		item_metadata_append (ctxt->item, "author", author);
 		g_free (author);
 	}
 }
@@ -356,7 +359,7 @@ atom10_parse_entry_category (xmlNodePtr cur, feedParserCtxtPtr ctxt, struct atom
 		if (!g_str_equal (category, "reading-list") &&
 		    !g_str_equal (category, "read") &&
 		    !strstr(category, "user/-/label/"))
-			ctxt->item->metadata = metadata_list_append (ctxt->item->metadata, "category", escaped);
+			item_metadata_append (ctxt->item, "category", escaped);
 
 		g_free (escaped);
 		xmlFree (category);
@@ -382,7 +385,7 @@ atom10_parse_entry_contributor (xmlNodePtr cur, feedParserCtxtPtr ctxt, struct a
 	
 	contributor = atom10_parse_person_construct (cur);
 	if (contributor) {
-		ctxt->item->metadata = metadata_list_append (ctxt->item->metadata, "contributor", contributor);
+		item_metadata_append (ctxt->item, "contributor", contributor);
 		g_free (contributor);
 	}
 }
@@ -422,7 +425,7 @@ atom10_parse_entry_published (xmlNodePtr cur, feedParserCtxtPtr ctxt, struct ato
 	datestr = (gchar *)xmlNodeListGetString (cur->doc, cur->xmlChildrenNode, 1);
 	if (datestr) {
 		ctxt->item->time = date_parse_ISO8601 (datestr);
-		ctxt->item->metadata = metadata_list_append (ctxt->item->metadata, "pubDate", datestr);
+		item_metadata_append (ctxt->item, "pubDate", datestr);
 		g_free (datestr);
 	}
 }
@@ -434,7 +437,7 @@ atom10_parse_entry_rights (xmlNodePtr cur, feedParserCtxtPtr ctxt, struct atom10
 
 	rights = atom10_parse_text_construct (cur, FALSE);
 	if (rights) {
-		ctxt->item->metadata = metadata_list_append (ctxt->item->metadata, "copyright", rights);
+		item_metadata_append (ctxt->item, "copyright", rights);
 		g_free (rights);
 	}
 }
@@ -475,7 +478,7 @@ atom10_parse_entry_updated (xmlNodePtr cur, feedParserCtxtPtr ctxt, struct atom1
 	/* if pubDate is already set, don't overwrite it */
 	if (datestr && !metadata_list_get(ctxt->item->metadata, "pubDate")) {
 		ctxt->item->time = date_parse_ISO8601 (datestr);
-		ctxt->item->metadata = metadata_list_append (ctxt->item->metadata, "contentUpdateDate", datestr);
+		item_metadata_append (ctxt->item, "contentUpdateDate", datestr);
 	}
 
 	g_free (datestr);
@@ -488,27 +491,22 @@ atom10_parse_entry (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 {
 	NsHandler		*nsh;
 	parseItemTagFunc	pf;
-	atom10ElementParserFunc func;
-	static GHashTable	*entryElementHash = NULL;
-	
-	if (!entryElementHash) {
-		entryElementHash = g_hash_table_new (g_str_hash, g_str_equal);
-		
-		g_hash_table_insert (entryElementHash, "author", &atom10_parse_entry_author);
-		g_hash_table_insert (entryElementHash, "category", &atom10_parse_entry_category);
-		g_hash_table_insert (entryElementHash, "content", &atom10_parse_entry_content);
-		g_hash_table_insert (entryElementHash, "contributor", &atom10_parse_entry_contributor);
-		g_hash_table_insert (entryElementHash, "id", &atom10_parse_entry_id);
-		g_hash_table_insert (entryElementHash, "link", &atom10_parse_entry_link);
-		g_hash_table_insert (entryElementHash, "published", &atom10_parse_entry_published);
-		g_hash_table_insert (entryElementHash, "rights", &atom10_parse_entry_rights);
-		/* FIXME: Parse "source" */
-		g_hash_table_insert (entryElementHash, "summary", &atom10_parse_entry_summary);
-		g_hash_table_insert (entryElementHash, "title", &atom10_parse_entry_title);
-		g_hash_table_insert (entryElementHash, "updated", &atom10_parse_entry_updated);
-	}	
-
-	ctxt->item = item_new ();
+	gint			id;
+	static const gchar	*entryElements[] = {
+		"author", "category", "content", "contributor", "id", "link",
+		"published", "rights", "summary", "title", "updated", NULL
+	};
+	/* FIXME: Parse "source" */
+	static const atom10ElementParserFunc entryParsers[] = {
+		atom10_parse_entry_author, atom10_parse_entry_category,
+		atom10_parse_entry_content, atom10_parse_entry_contributor,
+		atom10_parse_entry_id, atom10_parse_entry_link,
+		atom10_parse_entry_published, atom10_parse_entry_rights,
+		atom10_parse_entry_summary, atom10_parse_entry_title,
+		atom10_parse_entry_updated
+	};
+
+	ctxt->item = item_new_in_arena (ctxt->arena);
 	
 	cur = cur->xmlChildrenNode;
 	while (cur) {
@@ -518,9 +516,8 @@ atom10_parse_entry (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 			continue;
 		}
 		
-		if ((cur->ns->href   && (nsh = (NsHandler *)g_hash_table_lookup (ns_atom10_ns_uri_table, (gpointer)cur->ns->href))) ||
-		    (cur->ns->prefix && (nsh = (NsHandler *)g_hash_table_lookup (atom10_nstable, (gpointer)cur->ns->prefix)))) {
-			
+		nsh = feed_parser_ctxt_ns_handler (ctxt, cur, ns_atom10_ns_uri_table, atom10_nstable);
+		if (nsh) {
 			pf = nsh->parseItemTag;
 			if (pf)
 				(*pf) (ctxt, cur);
@@ -537,15 +534,15 @@ atom10_parse_entry (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 		}
 		
 		
-		if (xmlStrcmp(cur->ns->href, ATOM10_NS)) {
+		if (0 != feed_parser_ctxt_ns_id (ctxt, atom10Namespaces, cur)) {
 			debug1(DEBUG_PARSING, "unknown namespace %s found!", cur->ns->href);
 			cur = cur->next;
 			continue;
 		}
 		/* At this point, the namespace must be the Atom 1.0 namespace */
-		func = g_hash_table_lookup (entryElementHash, cur->name);
-		if (func) {
-			(*func) (cur, ctxt, NULL);
+		id = feed_parser_ctxt_element_id (ctxt, entryElements, cur);
+		if (id >= 0) {
+			(*entryParsers[id]) (cur, ctxt, NULL);
 		} else {
 			debug1 (DEBUG_PARSING, "unknown entry element \"%s\" found", cur->name);
 		}
@@ -757,25 +754,28 @@ atom10_parse_feed (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 {
 	NsHandler		*nsh;
 	parseChannelTagFunc	pf;
-	atom10ElementParserFunc func;
-	static GHashTable	*feedElementHash = NULL;
-	
-	if(!feedElementHash) {
-		feedElementHash = g_hash_table_new (g_str_hash, g_str_equal);
-		
-		g_hash_table_insert (feedElementHash, "author", &atom10_parse_feed_author);
-		g_hash_table_insert (feedElementHash, "category", &atom10_parse_feed_category);
-		g_hash_table_insert (feedElementHash, "contributor", &atom10_parse_feed_contributor);
-		g_hash_table_insert (feedElementHash, "generator", &atom10_parse_feed_generator);
-		g_hash_table_insert (feedElementHash, "icon", &atom10_parse_feed_icon);
-		g_hash_table_insert (feedElementHash, "id", &atom10_parse_feed_id);
-		g_hash_table_insert (feedElementHash, "link", &atom10_parse_feed_link);
-		g_hash_table_insert (feedElementHash, "logo", &atom10_parse_feed_logo);
-		g_hash_table_insert (feedElementHash, "rights", &atom10_parse_feed_rights);
-		g_hash_table_insert (feedElementHash, "subtitle", &atom10_parse_feed_subtitle);
-		g_hash_table_insert (feedElementHash, "title", &atom10_parse_feed_title);
-		g_hash_table_insert (feedElementHash, "updated", &atom10_parse_feed_updated);
-	}	
+	gint			id;
+	static const gchar	*feedElements[] = {
+		"author", "category", "contributor", "generator", "icon", "id",
+		"link", "logo", "rights", "subtitle", "title", "updated", "entry",
+		NULL
+	};
+	/* element parsers by id, "entry" is handled below */
+	static const atom10ElementParserFunc feedParsers[] = {
+		(atom10ElementParserFunc)atom10_parse_feed_author,
+		(atom10ElementParserFunc)atom10_parse_feed_category,
+		(atom10ElementParserFunc)atom10_parse_feed_contributor,
+		(atom10ElementParserFunc)atom10_parse_feed_generator,
+		(atom10ElementParserFunc)atom10_parse_feed_icon,
+		(atom10ElementParserFunc)atom10_parse_feed_id,
+		(atom10ElementParserFunc)atom10_parse_feed_link,
+		(atom10ElementParserFunc)atom10_parse_feed_logo,
+		(atom10ElementParserFunc)atom10_parse_feed_rights,
+		(atom10ElementParserFunc)atom10_parse_feed_subtitle,
+		(atom10ElementParserFunc)atom10_parse_feed_title,
+		(atom10ElementParserFunc)atom10_parse_feed_updated,
+		NULL
+	};
 
 	while (TRUE) {
 		if (xmlStrcmp (cur->name, BAD_CAST"feed")) {
@@ -794,14 +794,7 @@ atom10_parse_feed (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 			/* check if supported namespace should handle the current tag 
 			   by trying to determine a namespace handler */
 			   
-			nsh = NULL;
-			
-			if (cur->ns->href)
-				nsh = (NsHandler *)g_hash_table_lookup (ns_atom10_ns_uri_table, (gpointer)cur->ns->href);
-			
-			if (cur->ns->prefix && !nsh)
-				nsh = (NsHandler *)g_hash_table_lookup (atom10_nstable, (gpointer)cur->ns->prefix);
-				
+			nsh = feed_parser_ctxt_ns_handler (ctxt, cur, ns_atom10_ns_uri_table, atom10_nstable);
 			if(nsh) {
 				pf = nsh->parseChannelTag;
 				if(pf)
@@ -818,17 +811,17 @@ atom10_parse_feed (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 				continue;
 			}
 
-			if (xmlStrcmp (cur->ns->href, ATOM10_NS)) {
+			if (0 != feed_parser_ctxt_ns_id (ctxt, atom10Namespaces, cur)) {
 				debug1 (DEBUG_PARSING, "unknown namespace %s found in atom feed!", cur->ns->href);
 				cur = cur->next;
 				continue;
 			}
 			/* At this point, the namespace must be the Atom 1.0 namespace */
 			
-			func = g_hash_table_lookup (feedElementHash, cur->name);
-			if (func) {
-				(*func) (cur, ctxt, NULL);
-			} else if (xmlStrEqual (cur->name, BAD_CAST"entry")) {
+			id = feed_parser_ctxt_element_id (ctxt, feedElements, cur);
+			if (id >= 0 && feedParsers[id]) {
+				(*feedParsers[id]) (cur, ctxt, NULL);
+			} else if (id >= 0) {
 				ctxt->item = atom10_parse_entry (ctxt, cur);
 				if (ctxt->item)
 					ctxt->items = g_list_insert_sorted (ctxt->items, ctxt->item, atom10_item_sort_by_date);
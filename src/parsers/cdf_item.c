@@ -46,7 +46,7 @@ itemPtr parseCDFItem(feedParserCtxtPtr ctxt, xmlNodePtr cur, CDFChannelPtr cp) {
 		g_hash_table_insert(CDFToMetadataMapping, "category", "category");
 	}
 		
-	ctxt->item = item_new();
+	ctxt->item = item_new_in_arena (ctxt->arena);
 	
 	/* save the item link */
 	if(!(tmp = (gchar *)xmlGetProp(cur, BAD_CAST"href")))
@@ -68,7 +68,7 @@ itemPtr parseCDFItem(feedParserCtxtPtr ctxt, xmlNodePtr cur, CDFChannelPtr cp) {
 		if(NULL != (tmp = g_ascii_strdown((gchar *)cur->name, -1))) {
 			if(NULL != (tmp2 = g_hash_table_lookup(CDFToMetadataMapping, tmp))) {
 				if(NULL != (tmp3 = (gchar *)xmlNodeListGetString(cur->doc, cur->xmlChildrenNode, TRUE))) {
-					ctxt->item->metadata = metadata_list_append(ctxt->item->metadata, tmp2, tmp3);
+					item_metadata_append (ctxt->item, tmp2, tmp3);
 					g_free(tmp3);
 				}
 			}
@@ -80,7 +80,7 @@ itemPtr parseCDFItem(feedParserCtxtPtr ctxt, xmlNodePtr cur, CDFChannelPtr cp) {
 			if(!(tmp = (gchar *)xmlGetProp(cur, BAD_CAST"href")))
 				tmp = (gchar *)xmlGetProp(cur, BAD_CAST"HREF");
 			if(tmp) {
-				ctxt->item->metadata = metadata_list_append(ctxt->item->metadata, "imageUrl", tmp);
+				item_metadata_append (ctxt->item, "imageUrl", tmp);
 				g_free(tmp);
 			}
 			
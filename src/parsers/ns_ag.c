@@ -64,11 +64,11 @@ parse_item_tag (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 		else
 			tmp = g_strdup (source);
 	
-		metadata_list_set (&(ctxt->item->metadata), "agSource", tmp);
+		item_metadata_set (ctxt->item, "agSource", tmp);
 	} else if (!xmlStrcmp (BAD_CAST "timestamp", cur->name)) {
 		if (NULL != (tmp = (gchar *)xmlNodeListGetString (cur->doc, cur->xmlChildrenNode, 1))) {
 			date = date_format (date_parse_ISO8601 (tmp), _("%b %d %H:%M"));
-			metadata_list_set (&(ctxt->item->metadata), "agTimestamp", date);
+			item_metadata_set (ctxt->item, "agTimestamp", date);
 			g_free (date);
 			g_free (tmp);
 		}
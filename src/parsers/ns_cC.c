@@ -85,7 +85,7 @@ static void
 parse_item_tag (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 {
 	gchar * tag = parse_tag (cur);
-	metadata_list_set (&(ctxt->item->metadata), "license", tag);
+	item_metadata_set (ctxt->item, "license", tag);
 	g_free (tag);
 }
 
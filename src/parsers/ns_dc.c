@@ -183,7 +183,7 @@ parse_tag (feedParserCtxtPtr ctxt, xmlNodePtr cur, gboolean isFeedTag)
 							ctxt->subscription->metadata = metadata_list_append (ctxt->subscription->metadata, mapping, value);
 					} else {
 						if (NULL != (mapping = mapToItemMetadata[i]))
-							ctxt->item->metadata = metadata_list_append (ctxt->item->metadata, mapping, value);
+							item_metadata_append (ctxt->item, mapping, value);
 					}
 				} 
 				g_free (value);
@@ -39,7 +39,7 @@ ns_georss_parse_item_tag (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 		point = (gchar *)xmlNodeListGetString (cur->doc, cur->xmlChildrenNode, 1);
 
 	if (point) {
-		metadata_list_set (&(ctxt->item->metadata), "point", point);
+		item_metadata_set (ctxt->item, "point", point);
 		g_free (point);
 	}
 }
@@ -42,7 +42,7 @@ ns_itunes_parse_item_tag (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 	if (!xmlStrcmp(cur->name, BAD_CAST"author")) {
 		tmp = (gchar *)xmlNodeListGetString (cur->doc, cur->xmlChildrenNode, 1);
 		if (tmp) {
-			ctxt->item->metadata = metadata_list_append (ctxt->item->metadata, "author", tmp);
+			item_metadata_append (ctxt->item, "author", tmp);
 			g_free (tmp);
 		}
 	}
@@ -66,7 +66,7 @@ ns_itunes_parse_item_tag (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 			while (g_unichar_isspace (*keyword)) {
 				keyword = g_utf8_next_char (keyword);
 			}
-			ctxt->item->metadata = metadata_list_append (ctxt->item->metadata, "category", keyword);
+			item_metadata_append (ctxt->item, "category", keyword);
 			keyword = tmp;
 		}
 		g_free (allocated);
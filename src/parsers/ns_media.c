@@ -83,12 +83,12 @@ parse_item_tag (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 		/* gravatars are often supplied as media:content with medium='image'
 		   so we treat do not treat such occurences as enclosures */
 		if (medium && !strcmp (medium, "image") && strstr (tmp, "www.gravatar.com")) {
-			metadata_list_set (&(ctxt->item->metadata), "gravatar", tmp);
+			item_metadata_set (ctxt->item, "gravatar", tmp);
 		} else {
 			/* Never add enclosures for images already contained in the description */
 			if (!(ctxt->item->description && strstr (ctxt->item->description, tmp))) {
 				gchar *encl_string = enclosure_values_to_string (tmp, type, length, FALSE /* not yet downloaded */);
-				ctxt->item->metadata = metadata_list_append (ctxt->item->metadata, "enclosure", encl_string);
+				item_metadata_append (ctxt->item, "enclosure", encl_string);
 				g_free (encl_string);
 
 				ctxt->item->hasEnclosure = TRUE;
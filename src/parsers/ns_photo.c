@@ -56,7 +56,7 @@ parse_item_tag (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 		/* we do nothing */
 	} else {
 		tmp = g_strdup_printf ("%s,%s", thumbnail, imgsrc?imgsrc:"");
-		metadata_list_set (&(ctxt->item->metadata), "photo", tmp);
+		item_metadata_set (ctxt->item, "photo", tmp);
 		g_free (tmp);
 	}
 }
@@ -65,7 +65,7 @@ parse_item_tag (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 		department = g_hash_table_lookup (ctxt->item->tmpdata, "slash:department");
 		tmp = g_strdup_printf ("%s,%s", section ? section : "",
 		                                department ? department : "" );
-		metadata_list_set (&(ctxt->item->metadata), "slash", tmp);
+		item_metadata_set (ctxt->item, "slash", tmp);
 		g_free (tmp);
 	}
 }
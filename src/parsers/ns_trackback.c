@@ -48,7 +48,7 @@ parse_item_tag (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 		tmp = (gchar *)xmlNodeListGetString (cur->doc, cur->xmlChildrenNode, 1);
 
 	if (tmp) {
-		ctxt->item->metadata = metadata_list_append (ctxt->item->metadata, "related", tmp);
+		item_metadata_append (ctxt->item, "related", tmp);
 		g_free (tmp);
 	}
 }
@@ -43,7 +43,7 @@ parse_item_tag (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 		uri = (gchar *)xmlNodeListGetString (cur->doc, cur->xmlChildrenNode, 1);
 
 	if (uri) {
-		metadata_list_set (&(ctxt->item->metadata), "commentFeedUri", uri);
+		item_metadata_set (ctxt->item, "commentFeedUri", uri);
 		g_free (uri);
 	}
 }
@@ -41,7 +41,7 @@ itemPtr parseEntry(feedParserCtxtPtr ctxt, xmlNodePtr cur) {
 	
 	g_assert(NULL != cur);
 		
-	ctxt->item = item_new();
+	ctxt->item = item_new_in_arena (ctxt->arena);
 	
 	cur = cur->xmlChildrenNode;
 	while(cur) {
@@ -91,12 +91,12 @@ itemPtr parseEntry(feedParserCtxtPtr ctxt, xmlNodePtr cur) {
 		} else if(!xmlStrcmp(cur->name, BAD_CAST"author")) {
 			/* parse feed author */
 			tmp =  parseAuthor(cur);
-			ctxt->item->metadata = metadata_list_append(ctxt->item->metadata, "author", tmp);
+			item_metadata_append (ctxt->item, "author", tmp);
 			g_free(tmp);
 		} else if(!xmlStrcmp(cur->name, BAD_CAST"contributor")) {
 			/* parse feed contributors */
 			tmp = parseAuthor(cur);
-			ctxt->item->metadata = metadata_list_append(ctxt->item->metadata, "contributor", tmp);
+			item_metadata_append (ctxt->item, "contributor", tmp);
 			g_free(tmp);
 		} else if(!xmlStrcmp(cur->name, BAD_CAST"id")) {
 			if(NULL != (tmp = (gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, 1))) {
@@ -126,7 +126,7 @@ itemPtr parseEntry(feedParserCtxtPtr ctxt, xmlNodePtr cur) {
 			}
 		} else if(!xmlStrcmp(cur->name, BAD_CAST"copyright")) {
  			if(NULL != (tmp = (gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, 1))) {
-				ctxt->item->metadata = metadata_list_append(ctxt->item->metadata, "copyright", tmp);
+				item_metadata_append (ctxt->item, "copyright", tmp);
 				g_free(tmp);
 			}
 		}
@@ -52,7 +52,20 @@
 #define TEXT_INPUT_SUBMIT	"\" /><input class=\"rssformsubmit\" type=\"submit\" value=\""
 #define TEXT_INPUT_FORM_END	"\" /></form>"
 
-GHashTable *RssToMetadataMapping = NULL;
+/* element names by RSS_ELEMENT_* id, shared with rss_item.c */
+const gchar *rssElementNames[] = {
+	"copyright", "category", "webMaster", "language", "managingEditor",
+	"lastBuildDate", "generator", "publisher", "author", "comments",
+	"pubDate", "ttl", "title", "link", "description", "enclosure", "guid",
+	"source", "image", "textinput", "textInput", "items", "item",
+	NULL
+};
+
+/* metadata keys for the element ids below RSS_ELEMENT_METADATA_MAX */
+const gchar *rssElementMetadata[RSS_ELEMENT_METADATA_MAX] = {
+	"copyright", "category", "webmaster", "language", "managingEditor",
+	"contentUpdateDate", "feedgenerator", "webmaster", "author", "commentsUri"
+};
 
 /* to store the NsHandler structs for all supported RDF namespace handlers */
 GHashTable	*rss_nstable = NULL;	/* duplicate storage: for quick finding... */
@@ -61,9 +74,10 @@ GHashTable	*ns_rss_ns_uri_table = NULL;
 /* This function parses the metadata for the channel. This does not
    parse the items. The items are parsed elsewhere. */
 static void parseChannel(feedParserCtxtPtr ctxt, xmlNodePtr cur) {
-	gchar			*tmp, *tmp2, *tmp3;
+	gchar			*tmp, *tmp3;
 	NsHandler		*nsh;
 	parseChannelTagFunc	pf;
+	gint			id;
 	
 	g_assert(NULL != cur);
 			
@@ -76,8 +90,7 @@ static void parseChannel(feedParserCtxtPtr ctxt, xmlNodePtr cur) {
 		
 		/* check namespace of this tag */
 		if(cur->ns) {
-			if((cur->ns->href && (nsh = (NsHandler *)g_hash_table_lookup(ns_rss_ns_uri_table, (gpointer)cur->ns->href))) ||
-			   (cur->ns->prefix && (nsh = (NsHandler *)g_hash_table_lookup(rss_nstable, (gpointer)cur->ns->prefix)))) {
+			if(NULL != (nsh = feed_parser_ctxt_ns_handler(ctxt, cur, ns_rss_ns_uri_table, rss_nstable))) {
 				if(NULL != (pf = nsh->parseChannelTag))
 					(*pf)(ctxt, cur);
 				cur = cur->next;
@@ -87,46 +100,53 @@ static void parseChannel(feedParserCtxtPtr ctxt, xmlNodePtr cur) {
 			}
 		} /* explicitly no following else !!! */
 			
+		id = feed_parser_ctxt_element_id(ctxt, rssElementNames, cur);
+
 		/* Check for metadata tags */
-		if(NULL != (tmp2 = g_hash_table_lookup(RssToMetadataMapping, cur->name))) {
+		if(id >= 0 && id < RSS_ELEMENT_METADATA_MAX) {
 			if(NULL != (tmp3 = (gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, TRUE))) {
-				ctxt->subscription->metadata = metadata_list_append(ctxt->subscription->metadata, tmp2, tmp3);
+				ctxt->subscription->metadata = metadata_list_append(ctxt->subscription->metadata, rssElementMetadata[id], tmp3);
 				g_free(tmp3);
 			}
-		}	
-		/* check for specific tags */
-		else if(!xmlStrcmp(cur->name, BAD_CAST"pubDate")) {
- 			if(NULL != (tmp = (gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, 1))) {
-				ctxt->subscription->metadata = metadata_list_append(ctxt->subscription->metadata, "pubDate", tmp);
-				ctxt->feed->time = date_parse_RFC822 (tmp);
-				g_free(tmp);
-			}
-		} 
-		else if(!xmlStrcmp(cur->name, BAD_CAST"ttl")) {
- 			if(NULL != (tmp = (gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, TRUE))) {
-				subscription_set_default_update_interval(ctxt->subscription, atoi(tmp));
-				g_free(tmp);
-			}
-		}
-		else if(!xmlStrcmp(cur->name, BAD_CAST"title")) {
- 			if(NULL != (tmp = unhtmlize((gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, TRUE)))) {
-				if(ctxt->title)
-					g_free(ctxt->title);
-				ctxt->title = tmp;
-			}
-		}
-		else if(!xmlStrcmp(cur->name, BAD_CAST"link")) {
- 			if(NULL != (tmp = unhtmlize((gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, TRUE)))) {
-				subscription_set_homepage (ctxt->subscription, tmp);
-				g_free(tmp);
-			}
+			cur = cur->next;
+			continue;
 		}
-		else if (!xmlStrcmp (cur->name, BAD_CAST"description")) {
- 			tmp = xhtml_extract (cur, 0, NULL);
-			if (tmp) {
-				metadata_list_set (&ctxt->subscription->metadata, "description", tmp);
-				g_free (tmp);
-			}
+
+		/* check for specific tags */
+		switch(id) {
+			case RSS_ELEMENT_PUBDATE:
+ 				if(NULL != (tmp = (gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, 1))) {
+					ctxt->subscription->metadata = metadata_list_append(ctxt->subscription->metadata, "pubDate", tmp);
+					ctxt->feed->time = date_parse_RFC822 (tmp);
+					g_free(tmp);
+				}
+				break;
+			case RSS_ELEMENT_TTL:
+ 				if(NULL != (tmp = (gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, TRUE))) {
+					subscription_set_default_update_interval(ctxt->subscription, atoi(tmp));
+					g_free(tmp);
+				}
+				break;
+			case RSS_ELEMENT_TITLE:
+ 				if(NULL != (tmp = unhtmlize((gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, TRUE)))) {
+					if(ctxt->title)
+						g_free(ctxt->title);
+					ctxt->title = tmp;
+				}
+				break;
+			case RSS_ELEMENT_LINK:
+ 				if(NULL != (tmp = unhtmlize((gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, TRUE)))) {
+					subscription_set_homepage (ctxt->subscription, tmp);
+					g_free(tmp);
+				}
+				break;
+			case RSS_ELEMENT_DESCRIPTION:
+ 				tmp = xhtml_extract (cur, 0, NULL);
+				if (tmp) {
+					metadata_list_set (&ctxt->subscription->metadata, "description", tmp);
+					g_free (tmp);
+				}
+				break;
 		}
 		
 		cur = cur->next;
@@ -261,43 +281,47 @@ static void rss_parse(feedParserCtxtPtr ctxt, xmlNodePtr cur) {
 				continue;
 			}
 
-			/* save link to channel image */
-			if((!xmlStrcmp(cur->name, BAD_CAST"image"))) {
-				if(NULL != (tmp = parseImage(cur))) {
-					metadata_list_set (&ctxt->subscription->metadata, "imageUrl", tmp);
-					g_free(tmp);
-				}
-				
-			} else if((!xmlStrcmp(cur->name, BAD_CAST"textinput")) ||
-			          (!xmlStrcmp(cur->name, BAD_CAST"textInput"))) {
-				/* no matter if we parse Userland or Netscape, there should be
-				   only one text[iI]nput per channel and parsing the rdf:ressource
-				   one should not harm */
-				if(NULL != (tmp = parseTextInput(cur))) {
-					ctxt->subscription->metadata = metadata_list_append(ctxt->subscription->metadata, "textInput", tmp);
-					g_free(tmp);
-				}
-				
-			} else if((!xmlStrcmp(cur->name, BAD_CAST"items"))) { /* RSS 1.1 */
-				xmlNodePtr itemNode = cur->xmlChildrenNode;
-				while(itemNode) {
-					if ((!xmlStrcmp(itemNode->name, BAD_CAST"item"))) {
-						if(NULL != (ctxt->item = parseRSSItem(ctxt, itemNode))) {
-							if(0 == ctxt->item->time)
-								ctxt->item->time = ctxt->feed->time;
-							ctxt->items = g_list_append(ctxt->items, ctxt->item);
+			switch(feed_parser_ctxt_element_id(ctxt, rssElementNames, cur)) {
+				/* save link to channel image */
+				case RSS_ELEMENT_IMAGE:
+					if(NULL != (tmp = parseImage(cur))) {
+						metadata_list_set (&ctxt->subscription->metadata, "imageUrl", tmp);
+						g_free(tmp);
+					}
+					break;
+				case RSS_ELEMENT_TEXTINPUT:
+				case RSS_ELEMENT_TEXTINPUT_NETSCAPE:
+					/* no matter if we parse Userland or Netscape, there should be
+					   only one text[iI]nput per channel and parsing the rdf:ressource
+					   one should not harm */
+					if(NULL != (tmp = parseTextInput(cur))) {
+						ctxt->subscription->metadata = metadata_list_append(ctxt->subscription->metadata, "textInput", tmp);
+						g_free(tmp);
+					}
+					break;
+				case RSS_ELEMENT_ITEMS: { /* RSS 1.1 */
+					xmlNodePtr itemNode = cur->xmlChildrenNode;
+					while(itemNode) {
+						if (itemNode->type == XML_ELEMENT_NODE &&
+						    RSS_ELEMENT_ITEM == feed_parser_ctxt_element_id(ctxt, rssElementNames, itemNode)) {
+							if(NULL != (ctxt->item = parseRSSItem(ctxt, itemNode))) {
+								if(0 == ctxt->item->time)
+									ctxt->item->time = ctxt->feed->time;
+								ctxt->items = g_list_append(ctxt->items, ctxt->item);
+							}
 						}
+						itemNode = itemNode->next;
 					}
-					itemNode = itemNode->next;
+					break;
 				}
-			} else if((!xmlStrcmp(cur->name, BAD_CAST"item"))) { /* RSS 1.0, 2.0 */
-				/* collect channel items */
-				if(NULL != (ctxt->item = parseRSSItem(ctxt, cur))) {
-					if(0 == ctxt->item->time)
-						ctxt->item->time = ctxt->feed->time;
-					ctxt->items = g_list_append(ctxt->items, ctxt->item);
-				}
-				
+				case RSS_ELEMENT_ITEM: /* RSS 1.0, 2.0 */
+					/* collect channel items */
+					if(NULL != (ctxt->item = parseRSSItem(ctxt, cur))) {
+						if(0 == ctxt->item->time)
+							ctxt->item->time = ctxt->feed->time;
+						ctxt->items = g_list_append(ctxt->items, ctxt->item);
+					}
+					break;
 			}
 			cur = cur->next;
 		}
@@ -338,23 +362,9 @@ rss_init_feed_handler (void)
 	
 	fhp = g_new0 (struct feedHandler, 1);
 
-	/* Note: the tag mapping definitions and namespace registration
+	/* Note: the element names and namespace registration
 	   infos are shared with rss_item.c */
 	
-	if (!RssToMetadataMapping) {
-		RssToMetadataMapping = g_hash_table_new (g_str_hash, g_str_equal);
-		g_hash_table_insert (RssToMetadataMapping, "copyright", "copyright");
-		g_hash_table_insert (RssToMetadataMapping, "category", "category");
-		g_hash_table_insert (RssToMetadataMapping, "webMaster", "webmaster");
-		g_hash_table_insert (RssToMetadataMapping, "language", "language");
-		g_hash_table_insert (RssToMetadataMapping, "managingEditor", "managingEditor");
-		g_hash_table_insert (RssToMetadataMapping, "lastBuildDate", "contentUpdateDate");
-		g_hash_table_insert (RssToMetadataMapping, "generator", "feedgenerator");
-		g_hash_table_insert (RssToMetadataMapping, "publisher", "webmaster");
-		g_hash_table_insert (RssToMetadataMapping, "author", "author");
-		g_hash_table_insert (RssToMetadataMapping, "comments", "commentsUri");
-	}
-	
 	if (!rss_nstable) {
 		rss_nstable = g_hash_table_new (g_str_hash, g_str_equal);
 		ns_rss_ns_uri_table = g_hash_table_new (g_str_hash, g_str_equal);
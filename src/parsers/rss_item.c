@@ -30,7 +30,8 @@
 
 #define RDF_NS	BAD_CAST"http://www.w3.org/1999/02/22-rdf-syntax-ns#"
 
-extern GHashTable *RssToMetadataMapping;
+extern const gchar *rssElementNames[];
+extern const gchar *rssElementMetadata[];
 
 /* uses the same namespace handler as rss_channel */
 extern GHashTable	*rss_nstable;
@@ -43,10 +44,11 @@ parseRSSItem (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 	gchar			*tmp, *tmp2, *tmp3;
 	NsHandler		*nsh;
 	parseItemTagFunc	pf;
+	gint			id;
 	
 	g_assert(NULL != cur);
 
-	ctxt->item = item_new ();
+	ctxt->item = item_new_in_arena (ctxt->arena);
 	ctxt->item->tmpdata = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
 	
 	/* try to get an item about id */
@@ -66,8 +68,8 @@ parseRSSItem (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 		
 		/* check namespace of this tag */
 		if (cur->ns) {
-			if((cur->ns->href && (nsh = (NsHandler *)g_hash_table_lookup(ns_rss_ns_uri_table, (gpointer)cur->ns->href))) ||
-			   (cur->ns->prefix && (nsh = (NsHandler *)g_hash_table_lookup(rss_nstable, (gpointer)cur->ns->prefix)))) {
+			nsh = feed_parser_ctxt_ns_handler (ctxt, cur, ns_rss_ns_uri_table, rss_nstable);
+			if (nsh) {
 				pf = nsh->parseItemTag;
 				if (pf)
 					(*pf)(ctxt, cur);
@@ -78,105 +80,111 @@ parseRSSItem (feedParserCtxtPtr ctxt, xmlNodePtr cur)
 			}
 		} /* explicitly no following else!!! */
 		
+		id = feed_parser_ctxt_element_id (ctxt, rssElementNames, cur);
+
 		/* check for metadata tags */
-		tmp2 = g_hash_table_lookup(RssToMetadataMapping, cur->name);
-		if (tmp2) {
+		if (id >= 0 && id < RSS_ELEMENT_METADATA_MAX) {
 			tmp3 = (gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, TRUE);
 			if (tmp3) {
-				ctxt->item->metadata = metadata_list_append(ctxt->item->metadata, tmp2, tmp3);
+				item_metadata_append (ctxt->item, rssElementMetadata[id], tmp3);
 				g_free(tmp3);
 			}
+			cur = cur->next;
+			continue;
 		}
+
 		/* check for specific tags */
-		else if(!xmlStrcmp(cur->name, BAD_CAST"pubDate")) {
- 			tmp = (gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, 1);
-			if (tmp) {
-				ctxt->item->time = date_parse_RFC822 (tmp);
-				g_free(tmp);
-			}
-		} 
-		else if(!xmlStrcmp(cur->name, BAD_CAST"enclosure")) {
-			/* RSS 0.93 allows multiple enclosures */
-			tmp = xml_get_attribute (cur, "url");
-			if (tmp) {
-				const gchar *feedURL = subscription_get_homepage (ctxt->subscription);
-				
-				gchar *type = xml_get_attribute (cur, "type");
-				gchar *lengthStr = xml_get_attribute (cur, "length");
-				gchar *enclStr = NULL;
-				gssize length = 0;
-				if (lengthStr)
-					length = atol (lengthStr);
-				
-				if((strstr(tmp, "://") == NULL) && feedURL && (feedURL[0] != '|') &&
-				   (strstr(feedURL, "://") != NULL)) {
-					/* add base URL if necessary and possible */
-					 tmp2 = g_strdup_printf("%s/%s", feedURL, tmp);
-					 g_free(tmp);
-					 tmp = tmp2;
+		switch (id) {
+			case RSS_ELEMENT_PUBDATE:
+ 				tmp = (gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, 1);
+				if (tmp) {
+					ctxt->item->time = date_parse_RFC822 (tmp);
+					g_free(tmp);
 				}
-		
-				enclStr = enclosure_values_to_string (tmp, type, length, FALSE);
-				ctxt->item->metadata = metadata_list_append(ctxt->item->metadata, "enclosure", enclStr);
-				ctxt->item->hasEnclosure = TRUE;
-
-				g_free (enclStr);
-				g_free (tmp);
-				g_free (type);
-				g_free (lengthStr);
-			}
-		} 
-		else if(!xmlStrcmp(cur->name, BAD_CAST"guid")) {
-			if(!item_get_id(ctxt->item)) {
-				tmp = (gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, 1);
+				break;
+			case RSS_ELEMENT_ENCLOSURE:
+				/* RSS 0.93 allows multiple enclosures */
+				tmp = xml_get_attribute (cur, "url");
 				if (tmp) {
-					if (strlen (tmp) > 0) {
-						item_set_id(ctxt->item, tmp);
-						ctxt->item->validGuid = TRUE;
-						tmp2 = xml_get_attribute (cur, "isPermaLink");
-						if(!item_get_source(ctxt->item) && (tmp2 == NULL || g_str_equal (tmp2, "true")))
-							item_set_source(ctxt->item, tmp); /* Per the RSS 2.0 spec. */
-						if(tmp2)
-							xmlFree(tmp2);
+					const gchar *feedURL = subscription_get_homepage (ctxt->subscription);
+					
+					gchar *type = xml_get_attribute (cur, "type");
+					gchar *lengthStr = xml_get_attribute (cur, "length");
+					gchar *enclStr = NULL;
+					gssize length = 0;
+					if (lengthStr)
+						length = atol (lengthStr);
+					
+					if((strstr(tmp, "://") == NULL) && feedURL && (feedURL[0] != '|') &&
+					   (strstr(feedURL, "://") != NULL)) {
+						/* add base URL if necessary and possible */
+						 tmp2 = g_strdup_printf("%s/%s", feedURL, tmp);
+						 g_free(tmp);
+						 tmp = tmp2;
 					}
-					xmlFree(tmp);
+			
+					enclStr = enclosure_values_to_string (tmp, type, length, FALSE);
+					item_metadata_append (ctxt->item, "enclosure", enclStr);
+					ctxt->item->hasEnclosure = TRUE;
+
+					g_free (enclStr);
+					g_free (tmp);
+					g_free (type);
+					g_free (lengthStr);
 				}
-			}
-		}
-		else if(!xmlStrcmp(cur->name, BAD_CAST"title")) {
- 			tmp = unhtmlize((gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, TRUE));
-			if (tmp) {
-				item_set_title(ctxt->item, tmp);
-				g_free(tmp);
-			}
-		}
-		else if(!xmlStrcmp(cur->name, BAD_CAST"link")) {
- 			tmp = unhtmlize((gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, TRUE));
-			if (tmp) {
-				item_set_source(ctxt->item, tmp);
-				g_free(tmp);
-			}
-		}
-		else if(!xmlStrcmp(cur->name, BAD_CAST"description")) {
- 			tmp = xhtml_extract (cur, 0, NULL);
-			if (tmp) {
-				/* don't overwrite content:encoded descriptions... */
-				if(!item_get_description(ctxt->item))
-					item_set_description(ctxt->item, tmp);
-				g_free(tmp);
-			}
-		}
-		else if(!xmlStrcmp(cur->name, BAD_CAST"source")) {
-			tmp = xml_get_attribute (cur, "url");
-			if (tmp) {
-				metadata_list_set (&(ctxt->item->metadata), "realSourceUrl", g_strchomp (tmp));
-				g_free (tmp);
-			}
-			tmp = unhtmlize ((gchar *)xmlNodeListGetString (ctxt->doc, cur->xmlChildrenNode, 1));
-			if (tmp) {
-				metadata_list_set (&(ctxt->item->metadata), "realSourceTitle", g_strchomp (tmp));
-				g_free(tmp);
-			}
+				break;
+			case RSS_ELEMENT_GUID:
+				if(!item_get_id(ctxt->item)) {
+					tmp = (gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, 1);
+					if (tmp) {
+						if (strlen (tmp) > 0) {
+							item_set_id(ctxt->item, tmp);
+							ctxt->item->validGuid = TRUE;
+							tmp2 = xml_get_attribute (cur, "isPermaLink");
+							if(!item_get_source(ctxt->item) && (tmp2 == NULL || g_str_equal (tmp2, "true")))
+								item_set_source(ctxt->item, tmp); /* Per the RSS 2.0 spec. */
+							if(tmp2)
+								xmlFree(tmp2);
+						}
+						xmlFree(tmp);
+					}
+				}
+				break;
+			case RSS_ELEMENT_TITLE:
+ 				tmp = unhtmlize((gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, TRUE));
+				if (tmp) {
+					item_set_title(ctxt->item, tmp);
+					g_free(tmp);
+				}
+				break;
+			case RSS_ELEMENT_LINK:
+ 				tmp = unhtmlize((gchar *)xmlNodeListGetString(ctxt->doc, cur->xmlChildrenNode, TRUE));
+				if (tmp) {
+					item_set_source(ctxt->item, tmp);
+					g_free(tmp);
+				}
+				break;
+			case RSS_ELEMENT_DESCRIPTION:
+ 				tmp = xhtml_extract (cur, 0, NULL);
+				if (tmp) {
+					/* don't overwrite content:encoded descriptions... */
+					if(!item_get_description(ctxt->item))
+						item_set_description(ctxt->item, tmp);
+					g_free(tmp);
+				}
+				break;
+			case RSS_ELEMENT_SOURCE:
+				tmp = xml_get_attribute (cur, "url");
+				if (tmp) {
+					item_metadata_set (ctxt->item, "realSourceUrl", g_strchomp (tmp));
+					g_free (tmp);
+				}
+				tmp = unhtmlize ((gchar *)xmlNodeListGetString (ctxt->doc, cur->xmlChildrenNode, 1));
+				if (tmp) {
+					item_metadata_set (ctxt->item, "realSourceTitle", g_strchomp (tmp));
+					g_free(tmp);
+				}
+				break;
 		}
 		
 		cur = cur->next;
@@ -24,6 +24,37 @@
 #include "item.h"
 #include "feed_parser.h"
 
+/** ids of the RSS channel and item elements in rssElementNames */
+enum {
+	/* elements mapped to metadata as listed in rssElementMetadata */
+	RSS_ELEMENT_COPYRIGHT,
+	RSS_ELEMENT_CATEGORY,
+	RSS_ELEMENT_WEBMASTER,
+	RSS_ELEMENT_LANGUAGE,
+	RSS_ELEMENT_MANAGING_EDITOR,
+	RSS_ELEMENT_LAST_BUILD_DATE,
+	RSS_ELEMENT_GENERATOR,
+	RSS_ELEMENT_PUBLISHER,
+	RSS_ELEMENT_AUTHOR,
+	RSS_ELEMENT_COMMENTS,
+	RSS_ELEMENT_METADATA_MAX,
+
+	/* elements with specific handling */
+	RSS_ELEMENT_PUBDATE = RSS_ELEMENT_METADATA_MAX,
+	RSS_ELEMENT_TTL,
+	RSS_ELEMENT_TITLE,
+	RSS_ELEMENT_LINK,
+	RSS_ELEMENT_DESCRIPTION,
+	RSS_ELEMENT_ENCLOSURE,
+	RSS_ELEMENT_GUID,
+	RSS_ELEMENT_SOURCE,
+	RSS_ELEMENT_IMAGE,
+	RSS_ELEMENT_TEXTINPUT,
+	RSS_ELEMENT_TEXTINPUT_NETSCAPE,
+	RSS_ELEMENT_ITEMS,
+	RSS_ELEMENT_ITEM
+};
+
 itemPtr parseRSSItem(feedParserCtxtPtr ctxt, xmlNodePtr cur);
 
 #endif
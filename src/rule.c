@@ -24,6 +24,7 @@
 
 #include "common.h"
 #include "debug.h"
+#include "feedlist.h"
 #include "metadata.h"
 
 #define ITEM_MATCH_RULE_ID		"exact"
@@ -70,9 +71,33 @@ rule_new (const gchar *ruleId,
 	return NULL;
 }
 
+static void
+rule_copy_feed_titles (GHashTable *feedTitles, nodePtr node)
+{
+	GSList	*iter;
+
+	if (node->title)
+		g_hash_table_insert (feedTitles, g_strdup (node->id), g_strdup (node->title));
+
+	for (iter = node->children; iter; iter = g_slist_next (iter))
+		rule_copy_feed_titles (feedTitles, (nodePtr)iter->data);
+}
+
+void
+rule_copy_feed_state (rulePtr rule)
+{
+	if (!(rule->ruleInfo->depends & RULE_DEPENDS_FEED) || rule->feedTitles)
+		return;
+
+	rule->feedTitles = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	rule_copy_feed_titles (rule->feedTitles, feedlist_get_root ());
+}
+
 void 
 rule_free (rulePtr rule)
 {
+	if (rule->feedTitles)
+		g_hash_table_destroy (rule->feedTitles);
 	g_free (rule->value);
 	g_free (rule);
 }
@@ -88,7 +113,9 @@ rule_check_item_title (rulePtr rule, itemPtr item)
 static gboolean
 rule_check_item_description (rulePtr rule, itemPtr item)
 {
-	return (NULL != item->description && NULL != g_strstr_len (item->description, -1, rule->value));
+	const gchar *description = item_get_description (item);
+
+	return (NULL != description && NULL != g_strstr_len (description, -1, rule->value));
 }
 
 static gboolean
@@ -133,12 +160,19 @@ rule_check_item_category (rulePtr rule, itemPtr item)
 static gboolean
 rule_check_feed_title (rulePtr rule, itemPtr item)
 {
-	nodePtr feedNode = node_from_id (item->parentNodeId);
-
-	if (!feedNode)
-		return FALSE;
+	const gchar	*title = NULL;
+
+	/* The feed list must not be accessed on worker threads */
+	if (rule->feedTitles) {
+		if (item->parentNodeId)
+			title = g_hash_table_lookup (rule->feedTitles, item->parentNodeId);
+	} else {
+		nodePtr feedNode = node_from_id (item->parentNodeId);
+		if (feedNode)
+			title = feedNode->title;
+	}
 
-	return (NULL != feedNode->title && NULL != g_strstr_len (feedNode->title, -1, rule->value));
+	return (NULL != title && NULL != g_strstr_len (title, -1, rule->value));
 }
 
 /* rule initialization */
@@ -149,7 +183,8 @@ rule_info_add (ruleCheckFunc checkFunc,
           gchar *title,
           gchar *positive,
           gchar *negative,
-          gboolean needsParameter)
+          gboolean needsParameter,
+          guint depends)
 {
 	ruleInfoPtr	ruleInfo;
 
@@ -159,6 +194,7 @@ rule_info_add (ruleCheckFunc checkFunc,
 	ruleInfo->positive = positive;
 	ruleInfo->negative = negative;
 	ruleInfo->needsParameter = needsParameter;	
+	ruleInfo->depends = depends;
 	ruleInfo->checkFunc = checkFunc;
 	ruleFunctions = g_slist_append (ruleFunctions, ruleInfo);
 }
@@ -168,17 +204,17 @@ rule_init (void)
 {
 	debug_enter ("rule_init");
 
-	/*        SQL condition builder function	in-memory check function	feedlist.opml rule id           rule menu label         positive menu option    negative menu option    has param */ 
-	/*        ========================================================================================================================================================================================*/
+	/*        SQL condition builder function	in-memory check function	feedlist.opml rule id           rule menu label         positive menu option    negative menu option    has param	depends on */ 
+	/*        ========================================================================================================================================================================================================*/
 	
-	rule_info_add (rule_check_item_all,		ITEM_MATCH_RULE_ID,		_("Item"),		_("does contain"),	_("does not contain"),	TRUE);
-	rule_info_add (rule_check_item_title,		ITEM_TITLE_MATCH_RULE_ID,	_("Item title"),	_("does contain"),	_("does not contain"),	TRUE);
-	rule_info_add (rule_check_item_description,	ITEM_DESC_MATCH_RULE_ID,	_("Item body"),		_("does contain"),	_("does not contain"),	TRUE);
-	rule_info_add (rule_check_item_is_unread,	"unread",			_("Read status"),	_("is unread"),		_("is read"),		FALSE);
-	rule_info_add (rule_check_item_is_flagged,	"flagged",			_("Flag status"),	_("is flagged"),	_("is unflagged"),	FALSE);
-	rule_info_add (rule_check_item_has_enc,		"enclosure",			_("Podcast"),		_("included"),		_("not included"),	FALSE);
-	rule_info_add (rule_check_item_category,	"category",			_("Category"),		_("is set"),		_("is not set"),	TRUE);
-	rule_info_add (rule_check_feed_title,		FEED_TITLE_MATCH_RULE_ID,	_("Feed title"),	_("does contain"),	_("does not contain"),	TRUE);
+	rule_info_add (rule_check_item_all,		ITEM_MATCH_RULE_ID,		_("Item"),		_("does contain"),	_("does not contain"),	TRUE,	RULE_DEPENDS_CONTENT);
+	rule_info_add (rule_check_item_title,		ITEM_TITLE_MATCH_RULE_ID,	_("Item title"),	_("does contain"),	_("does not contain"),	TRUE,	RULE_DEPENDS_CONTENT);
+	rule_info_add (rule_check_item_description,	ITEM_DESC_MATCH_RULE_ID,	_("Item body"),		_("does contain"),	_("does not contain"),	TRUE,	RULE_DEPENDS_CONTENT);
+	rule_info_add (rule_check_item_is_unread,	"unread",			_("Read status"),	_("is unread"),		_("is read"),		FALSE,	RULE_DEPENDS_READ);
+	rule_info_add (rule_check_item_is_flagged,	"flagged",			_("Flag status"),	_("is flagged"),	_("is unflagged"),	FALSE,	RULE_DEPENDS_FLAG);
+	rule_info_add (rule_check_item_has_enc,		"enclosure",			_("Podcast"),		_("included"),		_("not included"),	FALSE,	RULE_DEPENDS_CONTENT);
+	rule_info_add (rule_check_item_category,	"category",			_("Category"),		_("is set"),		_("is not set"),	TRUE,	RULE_DEPENDS_CONTENT);
+	rule_info_add (rule_check_feed_title,		FEED_TITLE_MATCH_RULE_ID,	_("Feed title"),	_("does contain"),	_("does not contain"),	TRUE,	RULE_DEPENDS_FEED);
 
 	debug_exit ("rule_init");
 }
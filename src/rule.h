@@ -25,6 +25,16 @@
 
 #include "item.h"
 
+/** item properties a rule check depends on */
+typedef enum {
+	RULE_DEPENDS_CONTENT	= 1 << 0,	/**< title, body, categories and enclosures */
+	RULE_DEPENDS_READ	= 1 << 1,	/**< read status */
+	RULE_DEPENDS_FLAG	= 1 << 2,	/**< flag status */
+	RULE_DEPENDS_FEED	= 1 << 3	/**< properties of the parent feed */
+} ruleDepends;
+
+#define RULE_DEPENDS_ALL	(RULE_DEPENDS_CONTENT | RULE_DEPENDS_READ | RULE_DEPENDS_FLAG | RULE_DEPENDS_FEED)
+
 /** rule info structure */
 typedef struct ruleInfo {
 	const gchar	*ruleId;	/**< rule id for cache file storage */
@@ -32,6 +42,7 @@ typedef struct ruleInfo {
 	gchar		*positive;	/**< text for positive logic selection */
 	gchar		*negative;	/**< text for negative logic selection */
 	gboolean	needsParameter;	/**< some rules may require no parameter... */
+	guint		depends;	/**< ruleDepends flags of the item properties checked */
 	
 	gpointer	checkFunc;	/**< the item check function */
 } *ruleInfoPtr;
@@ -41,6 +52,7 @@ typedef struct rule {
 	gchar		*value;		/* the value of the rule, e.g. a search text */
 	ruleInfoPtr	ruleInfo;	/* info structure about rule check function */
 	gboolean	additive;	/* is the rule positive logic */
+	GHashTable	*feedTitles;	/* copy of the feed titles (node id -> title) for checks on worker threads, or NULL */
 } *rulePtr;
 
 /** function type used to check items */
@@ -66,6 +78,15 @@ GSList * rule_get_available_rules (void);
  */
 rulePtr rule_new (const gchar *ruleId, const gchar *value, gboolean additive);
 
+/**
+ * Copies the feed list state the given rule depends on into the rule,
+ * so that it can be checked on other threads than the main thread.
+ * To be called on the main thread.
+ *
+ * @param rule	rule to prepare
+ */
+void rule_copy_feed_state (rulePtr rule);
+
 /** 
  * Free's the given rule structure 
  *
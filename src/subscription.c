@@ -55,6 +55,7 @@ subscription_new (const gchar *source,
 		subscription->updateOptions = g_new0 (struct updateOptions, 1);
 		
 	subscription->updateState = g_new0 (struct updateState, 1);	
+	subscription->timings = g_queue_new ();
 	subscription->updateInterval = -1;
 	subscription->defaultInterval = -1;
 	
@@ -193,6 +194,82 @@ subscription_update_error_status (subscriptionPtr subscription,
 		subscription->updateError = g_strdup (_("There was a problem while reading this subscription. Please check the URL and console output."));
 }
 
+typedef struct timingsSync {
+	gchar			*nodeId;
+	updateTimingsPtr	timings;
+	gint64			start;
+} *timingsSyncPtr;
+
+static void
+subscription_timings_committed (gpointer user_data)
+{
+	timingsSyncPtr	sync = (timingsSyncPtr)user_data;
+	nodePtr		node = node_from_id (sync->nodeId);
+
+	/* The subscription might be gone or have dropped the sample */
+	if (node && node->subscription && g_queue_find (node->subscription->timings, sync->timings))
+		sync->timings->dbWrite = g_get_monotonic_time () - sync->start;
+
+	g_free (sync->nodeId);
+	g_free (sync);
+}
+
+static void
+subscription_add_timings (subscriptionPtr subscription, updateTimingsPtr timings)
+{
+	updateTimingsPtr	copy;
+	timingsSyncPtr		sync;
+
+	copy = g_new (struct updateTimings, 1);
+	*copy = *timings;
+	g_queue_push_head (subscription->timings, copy);
+	while (g_queue_get_length (subscription->timings) > SUBSCRIPTION_TIMINGS_MAX)
+		g_free (g_queue_pop_tail (subscription->timings));
+
+	/* The DB write time is measured until the writer has
+	   committed everything the update processing queued */
+	sync = g_new0 (struct timingsSync, 1);
+	sync->nodeId = g_strdup (subscription->node->id);
+	sync->timings = copy;
+	sync->start = g_get_monotonic_time ();
+	db_sync (subscription_timings_committed, sync);
+}
+
+guint
+subscription_get_average_timings (subscriptionPtr subscription, updateTimingsPtr average)
+{
+	GList	*iter;
+	guint	count = 0;
+
+	memset (average, 0, sizeof (struct updateTimings));
+	for (iter = g_queue_peek_head_link (subscription->timings); iter; iter = g_list_next (iter)) {
+		updateTimingsPtr timings = (updateTimingsPtr)iter->data;
+
+		average->queueWait += timings->queueWait;
+		average->download += timings->download;
+		average->filter += timings->filter;
+		average->parse += timings->parse;
+		average->merge += timings->merge;
+		average->dbWrite += timings->dbWrite;
+		average->rawBytes += timings->rawBytes;
+		average->decodedBytes += timings->decodedBytes;
+		count++;
+	}
+
+	if (count) {
+		average->queueWait /= count;
+		average->download /= count;
+		average->filter /= count;
+		average->parse /= count;
+		average->merge /= count;
+		average->dbWrite /= count;
+		average->rawBytes /= count;
+		average->decodedBytes /= count;
+	}
+
+	return count;
+}
+
 static void
 subscription_process_update_result (const struct updateResult * const result, gpointer user_data, guint32 flags)
 {
@@ -200,6 +277,12 @@ subscription_process_update_result (const struct updateResult * const result, gp
 	nodePtr		node = subscription->node;
 	gboolean	processing = FALSE;
 	GTimeVal	now;
+	struct updateTimings timings = *result->timings;
+
+	debug_span_begin ("subscription update result");
+	debug_span_arg_str ("node", node->id);
+	debug_span_arg_int ("status", result->httpstatus);
+	debug_span_arg_int ("bytes", result->size);
 
 	/* 1. preprocessing */
 
@@ -230,7 +313,7 @@ subscription_process_update_result (const struct updateResult * const result, gp
 
 	/* 2. call subscription type specific processing */
 	if (processing)
-		SUBSCRIPTION_TYPE (subscription)->process_update_result (subscription, result, flags);
+		SUBSCRIPTION_TYPE (subscription)->process_update_result (subscription, result, &timings, flags);
 
 	/* 3. call favicon updating after subscription processing
 	      to ensure we have valid baseUrl for feed nodes... */
@@ -251,10 +334,14 @@ subscription_process_update_result (const struct updateResult * const result, gp
 	db_subscription_update (subscription);
 	db_node_update (subscription->node);
 
+	subscription_add_timings (subscription, &timings);
+
 	if (processing && subscription->node->newCount > 0) {
 		feedlist_new_items (node->newCount);
 		feedlist_node_was_updated (node);
 	}
+
+	debug_span_end ();
 }
 
 void
@@ -593,6 +680,7 @@ subscription_free (subscriptionPtr subscription)
 	update_options_free (subscription->updateOptions);
 	update_state_free (subscription->updateState);
 	metadata_list_free (subscription->metadata);
+	g_queue_free_full (subscription->timings, g_free);
 	
 	g_free (subscription);
 }
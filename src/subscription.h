@@ -65,8 +65,13 @@ typedef struct subscription {
 
 	gchar		*filtercmd;		/**< feed filter command */
 	gchar		*filterError;		/**< textual description of filter errors */
+
+	GQueue		*timings;		/**< timings of the last updates (updateTimingsPtr), newest first */
 } *subscriptionPtr;
 
+/** Number of update timings kept per subscription */
+#define SUBSCRIPTION_TIMINGS_MAX	10
+
 /**
  * Create a new subscription structure.
  *
@@ -239,6 +244,17 @@ void subscription_set_filter(subscriptionPtr subscription, const gchar * filter)
  */
 void subscription_set_auth_info (subscriptionPtr subscription, const gchar *username, const gchar *password);
 
+/**
+ * Calculates the average step durations and sizes over the
+ * timings of the last updates of the given subscription.
+ *
+ * @param subscription	the subscription
+ * @param average	returns the average timings
+ *
+ * @returns the number of updates averaged (0 if there are none)
+ */
+guint subscription_get_average_timings (subscriptionPtr subscription, updateTimingsPtr average);
+
 /**
  * Frees the given subscription structure.
  *
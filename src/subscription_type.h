@@ -57,9 +57,10 @@ typedef struct subscriptionType {
 	 *
 	 * @param subscription	the subscription that was updated
 	 * @param result	the update result
+	 * @param timings	the timings of the update, to add the processing steps to
 	 * @param flags		the update flags
 	 */
-	void (*process_update_result)(subscriptionPtr subscription, const struct updateResult * const result, updateFlags flags);
+	void (*process_update_result)(subscriptionPtr subscription, const struct updateResult * const result, updateTimingsPtr timings, updateFlags flags);
 
 } *subscriptionTypePtr;
 
@@ -0,0 +1,173 @@
+/**
+ * @file db.c  Test cases for the DB statement query plans
+ * 
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. 
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "db.h"
+
+/* Statements that are expected to scan a table: the statement name
+   and the table it may scan */
+static const gchar *tc_allowed_scans[][2] = {
+	{ "subscriptionLoadStmt",			"subscription" },	/* loads all subscriptions */
+	{ "nodeIdListStmt",				"node" },		/* lists all nodes */
+	{ "descriptionRawStatsStmt",			"item_content" },	/* statistics */
+	{ "descriptionCompressedStatsStmt",		"item_content" },	/* statistics */
+	{ NULL, NULL }
+};
+
+/* Statements that must use a specific index */
+static const gchar *tc_expected_indices[][2] = {
+	{ "itemsetLoadStmt",		"COVERING INDEX items_idx" },	/* items_idx7 or items_idx8 */
+	{ "itemsetReadCountStmt",	"items_idx9" },
+	{ "itemFindBySourceIdStmt",	"items_idx7" },
+	{ "duplicatesFindStmt",		"items_idx" },
+	{ "searchFolderItemNodesStmt",	"search_folder_items_idx" },
+	{ NULL, NULL }
+};
+
+typedef struct tcResult {
+	GString		*errors;
+	GHashTable	*plans;		/* statement name -> concatenated plan */
+} tcResult;
+
+static gboolean
+tc_scan_allowed (const gchar *name, const gchar *table)
+{
+	guint	i;
+
+	for (i = 0; tc_allowed_scans[i][0]; i++) {
+		if (g_str_equal (tc_allowed_scans[i][0], name) &&
+		    g_str_equal (tc_allowed_scans[i][1], table))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void
+tc_check_plan (const gchar *name, const gchar *sql, const gchar *plan, gpointer user_data)
+{
+	tcResult	*result = (tcResult *)user_data;
+	gchar		*tmp;
+
+	tmp = g_hash_table_lookup (result->plans, name);
+	tmp = g_strdup_printf ("%s%s\n", tmp?tmp:"", plan);
+	g_hash_table_insert (result->plans, g_strdup (name), tmp);
+
+	/* Depending on the SQLite version a full scan is reported as
+	   "SCAN TABLE <table>" or "SCAN <table>" */
+	if (g_str_has_prefix (plan, "SCAN ")) {
+		gchar	**words = g_strsplit (plan + strlen ("SCAN "), " ", 0);
+		gchar	*table = words[0];
+
+		if (g_str_equal (table, "TABLE") && words[1])
+			table = words[1];
+
+		if (!tc_scan_allowed (name, table))
+			g_string_append_printf (result->errors, "%s scans %s: %s (SQL: %s)\n", name, table, plan, sql);
+
+		g_strfreev (words);
+	}
+
+	if (strstr (plan, "TEMP B-TREE"))
+		g_string_append_printf (result->errors, "%s needs a temporary B-tree: %s (SQL: %s)\n", name, plan, sql);
+}
+
+static void
+tc_query_plans (void)
+{
+	tcResult	result;
+	guint		i;
+
+	result.errors = g_string_new (NULL);
+	result.plans = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+	db_foreach_query_plan (tc_check_plan, &result);
+
+	for (i = 0; tc_expected_indices[i][0]; i++) {
+		const gchar *plan = g_hash_table_lookup (result.plans, tc_expected_indices[i][0]);
+
+		if (!plan)
+			g_string_append_printf (result.errors, "no query plan for %s\n", tc_expected_indices[i][0]);
+		else if (!strstr (plan, tc_expected_indices[i][1]))
+			g_string_append_printf (result.errors, "%s does not use %s: %s", tc_expected_indices[i][0], tc_expected_indices[i][1], plan);
+	}
+
+	if (result.errors->len)
+		g_test_message ("%s", result.errors->str);
+	g_assert_cmpuint (result.errors->len, ==, 0);
+
+	g_hash_table_destroy (result.plans);
+	g_string_free (result.errors, TRUE);
+}
+
+/* Removes the DB and everything else created in the temporary directory */
+static void
+tc_remove_dir (const gchar *path)
+{
+	GDir		*dir;
+	const gchar	*name;
+
+	dir = g_dir_open (path, 0, NULL);
+	if (dir) {
+		while ((name = g_dir_read_name (dir))) {
+			gchar *filename = g_build_filename (path, name, NULL);
+
+			if (g_file_test (filename, G_FILE_TEST_IS_DIR))
+				tc_remove_dir (filename);
+			else
+				g_unlink (filename);
+			g_free (filename);
+		}
+		g_dir_close (dir);
+	}
+	g_rmdir (path);
+}
+
+int
+main (int argc, char *argv[])
+{
+	gchar	*tmpdir;
+	gint	res;
+
+	g_test_init (&argc, &argv, NULL);
+
+	/* Create a fresh DB in a temporary directory */
+	tmpdir = g_strdup_printf ("%s/liferea-test-%d", g_get_tmp_dir (), getpid ());
+	g_assert (0 == g_mkdir_with_parents (tmpdir, 0700));
+	g_setenv ("XDG_CACHE_HOME", tmpdir, TRUE);
+	g_setenv ("XDG_CONFIG_HOME", tmpdir, TRUE);
+	g_setenv ("XDG_DATA_HOME", tmpdir, TRUE);
+
+	db_init ();
+
+	g_test_add_func ("/db/query_plans", &tc_query_plans);
+
+	res = g_test_run ();
+
+	db_deinit ();
+	tc_remove_dir (tmpdir);
+	g_free (tmpdir);
+
+	return res;
+}
@@ -0,0 +1,327 @@
+/**
+ * @file dbus.c  Test cases for the DBUS interface and the headless mode
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <signal.h>
+#include <string.h>
+
+#include "dbus.h"
+#include "metrics.h"
+
+static void
+tc_name_appeared (GDBusConnection *connection, const gchar *name, const gchar *owner, gpointer user_data)
+{
+	g_main_loop_quit ((GMainLoop *)user_data);
+}
+
+static void
+tc_stats_received (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	GVariant	**result = (GVariant **)user_data;
+	GError		*error = NULL;
+
+	*result = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), res, &error);
+	g_assert_no_error (error);
+}
+
+static void
+tc_get_stats (void)
+{
+	GTestDBus	*bus;
+	GDBusConnection	*connection;
+	GMainLoop	*loop;
+	LifereaDBus	*dbus;
+	GVariant	*result = NULL, *counters, *histograms, *buckets;
+	guint64		value, count, sum, max;
+	guint		watch;
+
+	/* Run against a private session bus */
+	bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+	g_test_dbus_up (bus);
+
+	metrics_count (METRIC_UPDATE_BYTES, 1000);
+	metrics_count (METRIC_UPDATE_BYTES, 24);
+	metrics_record (METRIC_FEED_PARSE, 0);		/* bucket 0 */
+	metrics_record (METRIC_FEED_PARSE, 3);		/* bucket 2 */
+	metrics_record (METRIC_FEED_PARSE, 1000);	/* bucket 10 */
+
+	loop = g_main_loop_new (NULL, FALSE);
+	dbus = liferea_dbus_new ();
+	watch = g_bus_watch_name (G_BUS_TYPE_SESSION, LF_DBUS_SERVICE, G_BUS_NAME_WATCHER_FLAGS_NONE,
+	                          tc_name_appeared, NULL, loop, NULL);
+	g_main_loop_run (loop);
+	g_bus_unwatch_name (watch);
+
+	/* The call must be async as this process also serves it */
+	connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, NULL);
+	g_dbus_connection_call (connection, LF_DBUS_SERVICE, LF_DBUS_PATH, LF_DBUS_SERVICE,
+	                        "GetStats", NULL, G_VARIANT_TYPE ("(a{st}a{s(tttat)})"),
+	                        G_DBUS_CALL_FLAGS_NONE, -1, NULL, tc_stats_received, &result);
+	while (!result)
+		g_main_context_iteration (NULL, TRUE);
+
+	g_variant_get (result, "(@a{st}@a{s(tttat)})", &counters, &histograms);
+
+	g_assert (g_variant_lookup (counters, "update.bytes", "t", &value));
+	g_assert_cmpuint (value, ==, 1024);
+	g_assert (g_variant_lookup (counters, "update.jobs_queued", "t", &value));
+	g_assert_cmpuint (value, ==, 0);
+	g_assert (g_variant_lookup (counters, "db.statements", "t", &value));
+
+	g_assert (g_variant_lookup (histograms, "feed.parse", "(ttt@at)", &count, &sum, &max, &buckets));
+	g_assert_cmpuint (count, ==, 3);
+	g_assert_cmpuint (sum, ==, 1003);
+	g_assert_cmpuint (max, ==, 1000);
+	g_assert_cmpuint (g_variant_n_children (buckets), ==, METRIC_BUCKETS);
+	g_variant_get_child (buckets, 0, "t", &value);
+	g_assert_cmpuint (value, ==, 1);
+	g_variant_get_child (buckets, 2, "t", &value);
+	g_assert_cmpuint (value, ==, 1);
+	g_variant_get_child (buckets, 10, "t", &value);
+	g_assert_cmpuint (value, ==, 1);
+	g_variant_unref (buckets);
+
+	g_assert (g_variant_lookup (histograms, "itemlist.load", "(ttt@at)", &count, &sum, &max, &buckets));
+	g_assert_cmpuint (count, ==, 0);
+
+	g_variant_unref (buckets);
+	g_variant_unref (counters);
+	g_variant_unref (histograms);
+	g_variant_unref (result);
+	g_object_unref (connection);
+	g_object_unref (dbus);
+	g_main_loop_unref (loop);
+
+	g_test_dbus_down (bus);
+	g_object_unref (bus);
+}
+
+/* headless mode test: a liferea --headless process with a temporary
+   cache subscribes via DBUS to a feed served by this process */
+
+static const gchar *tc_feed =
+	"<?xml version=\"1.0\"?>\n"
+	"<rss version=\"2.0\"><channel>"
+	"<title>Headless Test</title><link>http://localhost/</link><description>test</description>"
+	"<item><title>First</title><guid>headless-test-1</guid><description>one</description></item>"
+	"<item><title>Second</title><guid>headless-test-2</guid><description>two</description></item>"
+	"</channel></rss>\n";
+
+static gboolean
+tc_http_incoming (GSocketService *service, GSocketConnection *connection, GObject *source, gpointer user_data)
+{
+	GDataInputStream	*in;
+	GOutputStream		*out;
+	gchar			*line, *response;
+	guint			*requests = (guint *)user_data;
+
+	/* skip the request headers */
+	in = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM (connection)));
+	g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (in), FALSE);
+	while ((line = g_data_input_stream_read_line (in, NULL, NULL, NULL))) {
+		gboolean end = (*line == '\0' || g_str_equal (line, "\r"));
+
+		g_free (line);
+		if (end)
+			break;
+	}
+	g_object_unref (in);
+
+	response = g_strdup_printf ("HTTP/1.1 200 OK\r\n"
+	                            "Content-Type: application/rss+xml\r\n"
+	                            "Content-Length: %u\r\n"
+	                            "Connection: close\r\n"
+	                            "\r\n%s", (guint)strlen (tc_feed), tc_feed);
+	out = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+	g_output_stream_write_all (out, response, strlen (response), NULL, NULL, NULL);
+	g_io_stream_close (G_IO_STREAM (connection), NULL, NULL);
+	g_free (response);
+
+	(*requests)++;
+
+	return TRUE;
+}
+
+static void
+tc_remove_dir (const gchar *path)
+{
+	GDir		*dir;
+	const gchar	*name;
+
+	if ((dir = g_dir_open (path, 0, NULL))) {
+		while ((name = g_dir_read_name (dir))) {
+			gchar *child = g_build_filename (path, name, NULL);
+
+			if (g_file_test (child, G_FILE_TEST_IS_DIR) && !g_file_test (child, G_FILE_TEST_IS_SYMLINK))
+				tc_remove_dir (child);
+			else
+				g_unlink (child);
+			g_free (child);
+		}
+		g_dir_close (dir);
+	}
+	g_rmdir (path);
+}
+
+static gint
+tc_get_unread_items (GDBusConnection *connection)
+{
+	GVariant	*result;
+	gint		count = -1;
+
+	result = g_dbus_connection_call_sync (connection, LF_DBUS_SERVICE, LF_DBUS_PATH, LF_DBUS_SERVICE,
+	                                      "GetUnreadItems", NULL, G_VARIANT_TYPE ("(i)"),
+	                                      G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+	if (result) {
+		g_variant_get (result, "(i)", &count);
+		g_variant_unref (result);
+	}
+
+	return count;
+}
+
+static void
+tc_headless_update (void)
+{
+	GSettingsSchema		*schema;
+	GTestDBus		*bus;
+	GDBusConnection		*connection;
+	GSocketService		*service;
+	GSubprocessLauncher	*launcher;
+	GSubprocess		*liferea;
+	GMainLoop		*loop;
+	GVariant		*result;
+	GError			*error = NULL;
+	gchar			*binary, *tmpdir, *dir, *feedlist, *url;
+	const gchar		*schemas[] = { "net.sf.liferea", "org.gnome.desktop.interface", NULL };
+	gboolean		subscribed;
+	guint			requests = 0, watch, port, i;
+	gint			unread = -1;
+	gint64			deadline;
+
+	binary = g_test_build_filename (G_TEST_BUILT, "..", "liferea", NULL);
+	if (!g_file_test (binary, G_FILE_TEST_IS_EXECUTABLE)) {
+		g_test_skip ("liferea binary not built");
+		g_free (binary);
+		return;
+	}
+
+	/* conf_init() aborts without them */
+	for (i = 0; schemas[i]; i++) {
+		schema = g_settings_schema_source_lookup (g_settings_schema_source_get_default (), schemas[i], TRUE);
+		if (!schema) {
+			g_test_skip ("GSettings schemas not installed");
+			g_free (binary);
+			return;
+		}
+		g_settings_schema_unref (schema);
+	}
+
+	/* Serve the test feed on a random local port */
+	service = g_socket_service_new ();
+	port = g_socket_listener_add_any_inet_port (G_SOCKET_LISTENER (service), NULL, &error);
+	g_assert_no_error (error);
+	g_signal_connect (service, "incoming", G_CALLBACK (tc_http_incoming), &requests);
+	g_socket_service_start (service);
+	url = g_strdup_printf ("http://127.0.0.1:%u/feed.rss", port);
+
+	/* Start with an empty feed list in a temporary cache */
+	tmpdir = g_dir_make_tmp ("liferea-headless-XXXXXX", &error);
+	g_assert_no_error (error);
+	dir = g_build_filename (tmpdir, "config", "liferea", NULL);
+	g_assert_cmpint (g_mkdir_with_parents (dir, 0700), ==, 0);
+	feedlist = g_build_filename (dir, "feedlist.opml", NULL);
+	g_file_set_contents (feedlist, "<?xml version=\"1.0\"?>\n<opml version=\"1.0\"><head/><body/></opml>\n", -1, &error);
+	g_assert_no_error (error);
+	g_free (feedlist);
+	g_free (dir);
+
+	bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+	g_test_dbus_up (bus);
+
+	launcher = g_subprocess_launcher_new (G_SUBPROCESS_FLAGS_NONE);
+	g_subprocess_launcher_setenv (launcher, "GSETTINGS_BACKEND", "memory", TRUE);
+	g_subprocess_launcher_setenv (launcher, "XDG_CONFIG_HOME", dir = g_build_filename (tmpdir, "config", NULL), TRUE);
+	g_free (dir);
+	g_subprocess_launcher_setenv (launcher, "XDG_CACHE_HOME", dir = g_build_filename (tmpdir, "cache", NULL), TRUE);
+	g_free (dir);
+	g_subprocess_launcher_setenv (launcher, "XDG_DATA_HOME", dir = g_build_filename (tmpdir, "data", NULL), TRUE);
+	g_free (dir);
+	liferea = g_subprocess_launcher_spawn (launcher, &error, binary, "--headless", NULL);
+	g_assert_no_error (error);
+
+	loop = g_main_loop_new (NULL, FALSE);
+	watch = g_bus_watch_name (G_BUS_TYPE_SESSION, LF_DBUS_SERVICE, G_BUS_NAME_WATCHER_FLAGS_NONE,
+	                          tc_name_appeared, NULL, loop, NULL);
+	g_main_loop_run (loop);
+	g_bus_unwatch_name (watch);
+
+	connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, NULL);
+	result = g_dbus_connection_call_sync (connection, LF_DBUS_SERVICE, LF_DBUS_PATH, LF_DBUS_SERVICE,
+	                                      "Subscribe", g_variant_new ("(s)", url), G_VARIANT_TYPE ("(b)"),
+	                                      G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+	g_assert_no_error (error);
+	g_variant_get (result, "(b)", &subscribed);
+	g_assert (subscribed);
+	g_variant_unref (result);
+
+	/* Serve the download and wait for both items to be merged */
+	deadline = g_get_monotonic_time () + 30 * G_USEC_PER_SEC;
+	while ((unread = tc_get_unread_items (connection)) < 2 && g_get_monotonic_time () < deadline) {
+		while (g_main_context_iteration (NULL, FALSE));
+		g_usleep (G_USEC_PER_SEC / 10);
+	}
+
+	g_assert_cmpuint (requests, >=, 1);
+	g_assert_cmpint (unread, ==, 2);
+
+	/* SIGTERM triggers the regular shutdown */
+	g_subprocess_send_signal (liferea, SIGTERM);
+	g_subprocess_wait_check (liferea, NULL, &error);
+	g_assert_no_error (error);
+
+	g_object_unref (liferea);
+	g_object_unref (launcher);
+	g_object_unref (connection);
+	g_main_loop_unref (loop);
+
+	g_test_dbus_down (bus);
+	g_object_unref (bus);
+
+	g_socket_service_stop (service);
+	g_object_unref (service);
+
+	tc_remove_dir (tmpdir);
+	g_free (tmpdir);
+	g_free (url);
+	g_free (binary);
+}
+
+int
+main (int argc, char *argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/dbus/get_stats", &tc_get_stats);
+	g_test_add_func ("/dbus/headless_update", &tc_headless_update);
+
+	return g_test_run ();
+}
@@ -0,0 +1,171 @@
+/**
+ * @file filter.c  Test cases for the filter coprocess protocol
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include "filter.h"
+
+/* Script filters speaking the coprocess protocol */
+static const gchar *script_upper =
+	"while read len; do\n"
+	"	echo \"$len\"\n"
+	"	head -c \"$len\" | tr a-z A-Z\n"
+	"done\n";
+
+static const gchar *script_once =
+	"read len\n"
+	"echo \"$len\"\n"
+	"head -c \"$len\" | tr a-z A-Z\n";
+
+static const gchar *script_hang =
+	"read len\n"
+	"sleep 10\n";
+
+static const gchar *script_garbage =
+	"read len\n"
+	"echo \"no length\"\n"
+	"sleep 10\n";
+
+static gchar *tmpdir = NULL;
+static GSList *scripts = NULL;
+
+static gchar *
+tc_create_filter (const gchar *name, const gchar *script)
+{
+	gchar	*filename, *cmd;
+
+	filename = g_build_filename (tmpdir, name, NULL);
+	g_assert (g_file_set_contents (filename, script, -1, NULL));
+	cmd = g_strdup_printf ("sh %s", filename);
+	scripts = g_slist_prepend (scripts, filename);
+
+	return cmd;
+}
+
+static void
+tc_run (const gchar *cmd, const gchar *data, const gchar *expected)
+{
+	gchar	*result, *error = NULL;
+	gsize	len;
+
+	result = filter_coprocess_run (cmd, data, strlen (data), &len, 5000, &error);
+	g_assert_null (error);
+	g_assert_cmpstr (result, ==, expected);
+	g_assert_cmpuint (len, ==, strlen (expected));
+	g_free (result);
+}
+
+static void
+tc_prefix (void)
+{
+	g_assert_cmpstr (filter_get_coprocess_cmd ("coprocess:sh filter.sh"), ==, "sh filter.sh");
+	g_assert_null (filter_get_coprocess_cmd ("sh filter.sh"));
+	g_assert_null (filter_get_coprocess_cmd ("filter.xsl"));
+}
+
+static void
+tc_documents (void)
+{
+	gchar	*cmd = tc_create_filter ("upper.sh", script_upper);
+
+	/* several documents through the same process, including empty
+	   ones and ones larger than the pipe buffer */
+	GString	*large = g_string_new (NULL);
+	gchar	*expected;
+	guint	i;
+
+	for (i = 0; i < 20000; i++)
+		g_string_append (large, "<item>text</item>\n");
+	expected = g_ascii_strup (large->str, -1);
+
+	tc_run (cmd, "<rss>first</rss>", "<RSS>FIRST</RSS>");
+	tc_run (cmd, "", "");
+	tc_run (cmd, large->str, expected);
+	tc_run (cmd, "<rss>last</rss>", "<RSS>LAST</RSS>");
+
+	g_free (expected);
+	g_string_free (large, TRUE);
+	g_free (cmd);
+}
+
+static void
+tc_restart (void)
+{
+	gchar	*cmd = tc_create_filter ("once.sh", script_once);
+
+	/* the filter exits after each document and must be restarted */
+	tc_run (cmd, "one", "ONE");
+	tc_run (cmd, "two", "TWO");
+	tc_run (cmd, "three", "THREE");
+	g_free (cmd);
+}
+
+static void
+tc_failures (void)
+{
+	gchar	*cmd, *result, *error = NULL;
+	gsize	len;
+
+	cmd = tc_create_filter ("hang.sh", script_hang);
+	result = filter_coprocess_run (cmd, "data", 4, &len, 200, &error);
+	g_assert_null (result);
+	g_assert_nonnull (error);
+	g_free (error);
+	g_free (cmd);
+
+	error = NULL;
+	cmd = tc_create_filter ("garbage.sh", script_garbage);
+	result = filter_coprocess_run (cmd, "data", 4, &len, 5000, &error);
+	g_assert_null (result);
+	g_assert_nonnull (error);
+	g_free (error);
+	g_free (cmd);
+}
+
+int
+main (int argc, char *argv[])
+{
+	GSList	*iter;
+	gint	result;
+
+	g_test_init (&argc, &argv, NULL);
+
+	tmpdir = g_dir_make_tmp ("liferea-filter-XXXXXX", NULL);
+	g_assert (tmpdir);
+
+	g_test_add_func ("/filter/prefix", &tc_prefix);
+	g_test_add_func ("/filter/documents", &tc_documents);
+	g_test_add_func ("/filter/restart", &tc_restart);
+	g_test_add_func ("/filter/failures", &tc_failures);
+
+	result = g_test_run ();
+
+	filter_deinit ();
+
+	for (iter = scripts; iter; iter = g_slist_next (iter))
+		g_unlink ((gchar *)iter->data);
+	g_slist_free_full (scripts, g_free);
+	g_rmdir (tmpdir);
+	g_free (tmpdir);
+
+	return result;
+}
@@ -0,0 +1,574 @@
+/**
+ * @file parser_bench.c  Feed parser throughput and allocation benchmark
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "feed_parser.h"
+#include "item.h"
+#include "node.h"
+#include "subscription.h"
+#include "xml.h"
+
+/* Runs a synthetic corpus through feed_parse() and reports items per
+   second and heap allocations per item. With --baseline=FILE each case
+   fails when it is slower or allocates more than recorded in FILE,
+   --update-baseline writes the current results to FILE instead. */
+
+/* Every case parses about this many items in total */
+#define BENCH_ITEMS_PER_CASE	20000
+
+/* Allocation counts hardly vary between runs */
+#define BENCH_ALLOC_TOLERANCE	0.05
+
+/* Counting all heap allocations by wrapping the glibc allocator.
+   GLib and (as set up by xml_init()) libxml2 both allocate with it. */
+#ifdef __GLIBC__
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static guint64 allocations = 0;
+
+void *
+malloc (size_t size)
+{
+	allocations++;
+	return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+	allocations++;
+	return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+	allocations++;
+	return __libc_realloc (ptr, size);
+}
+#define BENCH_COUNTS_ALLOCATIONS	TRUE
+#else
+static guint64 allocations = 0;
+#define BENCH_COUNTS_ALLOCATIONS	FALSE
+#endif
+
+typedef void (*benchGenerator) (GString *buffer, guint items);
+
+typedef struct benchCase {
+	const gchar	*name;
+	benchGenerator	generate;
+	guint		maxItems;	/* largest item count used for this format */
+} benchCase;
+
+typedef struct benchRun {
+	const benchCase	*format;
+	guint		items;
+	gchar		*key;		/* "<format>/<items>" */
+} benchRun;
+
+static gchar		*baselineFile = NULL;
+static gboolean		updateBaseline = FALSE;
+static gdouble		tolerance = 20.0;
+static GKeyFile		*baseline = NULL;
+static GKeyFile		*results = NULL;
+
+/* corpus generation */
+
+static const gchar *bench_words[] = {
+	"liferea", "feed", "update", "kernel", "release", "security", "desktop",
+	"performance", "parser", "namespace", "community", "weekly", "news", NULL
+};
+
+static void
+bench_append_text (GString *buffer, guint seed, guint words)
+{
+	guint	i;
+
+	for (i = 0; i < words; i++) {
+		if (i)
+			g_string_append_c (buffer, ' ');
+		g_string_append (buffer, bench_words[(seed + i * 7) % (G_N_ELEMENTS (bench_words) - 1)]);
+	}
+}
+
+/* An HTML body as typically found in content:encoded, escaped for
+   use in element content or raw for use in CDATA sections */
+static void
+bench_append_html (GString *buffer, guint seed, guint paragraphs, gboolean escaped)
+{
+	const gchar	*lt = escaped?"&lt;":"<";
+	const gchar	*gt = escaped?"&gt;":">";
+	guint		i;
+
+	for (i = 0; i < paragraphs; i++) {
+		g_string_append_printf (buffer, "%sp%s%sa href=\"https://example.com/%u/%u\"%s", lt, gt, lt, seed, i, gt);
+		bench_append_text (buffer, seed + i, 3);
+		g_string_append_printf (buffer, "%s/a%s ", lt, gt);
+		bench_append_text (buffer, seed * 3 + i, 40);
+		g_string_append_printf (buffer, " %simg src=\"https://example.com/img/%u.png\" alt=\"image\"/%s", lt, i, gt);
+		g_string_append_printf (buffer, "%sem%s", lt, gt);
+		bench_append_text (buffer, seed + 5, 4);
+		g_string_append_printf (buffer, "%s/em%s%s/p%s\n", lt, gt, lt, gt);
+	}
+}
+
+static void
+bench_rss2_header (GString *buffer, const gchar *namespaces)
+{
+	g_string_append_printf (buffer,
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<rss version=\"2.0\"%s>\n<channel>\n"
+		"<title>Benchmark Channel</title>\n"
+		"<link>https://example.com/</link>\n"
+		"<description>A synthetic feed</description>\n"
+		"<language>en</language>\n"
+		"<lastBuildDate>Mon, 05 Oct 2026 18:04:58 +0200</lastBuildDate>\n"
+		"<ttl>60</ttl>\n",
+		namespaces);
+}
+
+static void
+bench_rss2_item_common (GString *buffer, guint i)
+{
+	g_string_append (buffer, "<title>");
+	bench_append_text (buffer, i, 6);
+	g_string_append_printf (buffer, " %u</title>\n"
+		"<link>https://example.com/posts/%u.html</link>\n"
+		"<guid isPermaLink=\"false\">urn:bench:%u</guid>\n"
+		"<pubDate>Mon, 05 Oct 2026 %02u:%02u:00 +0200</pubDate>\n"
+		"<category>news</category><category>bench</category>\n",
+		i, i, i, i % 24, i % 60);
+}
+
+static void
+bench_gen_rss2_plain (GString *buffer, guint items)
+{
+	guint	i;
+
+	bench_rss2_header (buffer, "");
+	for (i = 0; i < items; i++) {
+		g_string_append (buffer, "<item>\n");
+		bench_rss2_item_common (buffer, i);
+		g_string_append (buffer, "<description>");
+		bench_append_text (buffer, i, 30);
+		g_string_append (buffer, "</description>\n</item>\n");
+	}
+	g_string_append (buffer, "</channel>\n</rss>\n");
+}
+
+static void
+bench_gen_rss2_namespaces (GString *buffer, guint items)
+{
+	guint	i;
+
+	bench_rss2_header (buffer,
+		" xmlns:dc=\"http://purl.org/dc/elements/1.1/\""
+		" xmlns:content=\"http://purl.org/rss/1.0/modules/content/\""
+		" xmlns:slash=\"http://purl.org/rss/1.0/modules/slash/\""
+		" xmlns:wfw=\"http://wellformedweb.org/CommentAPI/\""
+		" xmlns:media=\"http://search.yahoo.com/mrss/\""
+		" xmlns:itunes=\"http://www.itunes.com/dtds/podcast-1.0.dtd\""
+		" xmlns:georss=\"http://www.georss.org/georss\""
+		" xmlns:trackback=\"http://madskills.com/public/xml/rss/module/trackback/\"");
+	for (i = 0; i < items; i++) {
+		g_string_append (buffer, "<item>\n");
+		bench_rss2_item_common (buffer, i);
+		g_string_append_printf (buffer,
+			"<dc:creator>Author %u</dc:creator>\n"
+			"<dc:subject>bench</dc:subject>\n"
+			"<dc:date>2026-10-05T18:%02u:00+02:00</dc:date>\n"
+			"<slash:comments>%u</slash:comments>\n"
+			"<slash:section>articles</slash:section>\n"
+			"<wfw:commentRss>https://example.com/posts/%u/comments.xml</wfw:commentRss>\n"
+			"<media:content url=\"https://example.com/media/%u.mp4\" type=\"video/mp4\" fileSize=\"1048576\"/>\n"
+			"<media:thumbnail url=\"https://example.com/media/%u.jpg\"/>\n"
+			"<itunes:duration>00:%02u:00</itunes:duration>\n"
+			"<itunes:summary>A podcast episode</itunes:summary>\n"
+			"<georss:point>52.5 13.4</georss:point>\n"
+			"<trackback:ping>https://example.com/trackback/%u</trackback:ping>\n"
+			"<enclosure url=\"https://example.com/media/%u.mp3\" length=\"123456\" type=\"audio/mpeg\"/>\n"
+			"<description>",
+			i, i % 60, i % 50, i, i, i, i % 60, i, i);
+		bench_append_text (buffer, i, 20);
+		g_string_append (buffer, "</description>\n<content:encoded><![CDATA[");
+		bench_append_html (buffer, i, 2, FALSE);
+		g_string_append (buffer, "]]></content:encoded>\n</item>\n");
+	}
+	g_string_append (buffer, "</channel>\n</rss>\n");
+}
+
+static void
+bench_gen_rss2_html (GString *buffer, guint items)
+{
+	guint	i;
+
+	bench_rss2_header (buffer, "");
+	for (i = 0; i < items; i++) {
+		g_string_append (buffer, "<item>\n");
+		bench_rss2_item_common (buffer, i);
+		/* about 20kB of entity escaped HTML */
+		g_string_append (buffer, "<description>");
+		bench_append_html (buffer, i, 50, TRUE);
+		g_string_append (buffer, "</description>\n</item>\n");
+	}
+	g_string_append (buffer, "</channel>\n</rss>\n");
+}
+
+static void
+bench_gen_rdf (GString *buffer, guint items)
+{
+	guint	i;
+
+	g_string_append (buffer,
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\""
+		" xmlns=\"http://purl.org/rss/1.0/\""
+		" xmlns:dc=\"http://purl.org/dc/elements/1.1/\""
+		" xmlns:syn=\"http://purl.org/rss/1.0/modules/syndication/\">\n"
+		"<channel rdf:about=\"https://example.com/\">\n"
+		"<title>Benchmark RDF</title>\n<link>https://example.com/</link>\n"
+		"<description>A synthetic RSS 1.0 feed</description>\n"
+		"<syn:updatePeriod>hourly</syn:updatePeriod>\n"
+		"<syn:updateFrequency>1</syn:updateFrequency>\n"
+		"</channel>\n");
+	for (i = 0; i < items; i++) {
+		g_string_append_printf (buffer, "<item rdf:about=\"https://example.com/posts/%u\">\n<title>", i);
+		bench_append_text (buffer, i, 6);
+		g_string_append_printf (buffer, "</title>\n<link>https://example.com/posts/%u</link>\n"
+			"<dc:date>2026-10-05T18:%02u:00+02:00</dc:date>\n"
+			"<dc:creator>Author %u</dc:creator>\n<description>", i, i % 60, i);
+		bench_append_text (buffer, i, 30);
+		g_string_append (buffer, "</description>\n</item>\n");
+	}
+	g_string_append (buffer, "</rdf:RDF>\n");
+}
+
+static void
+bench_gen_atom10 (GString *buffer, guint items)
+{
+	guint	i;
+
+	g_string_append (buffer,
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<feed xmlns=\"http://www.w3.org/2005/Atom\""
+		" xmlns:media=\"http://search.yahoo.com/mrss/\">\n"
+		"<title>Benchmark Atom</title>\n"
+		"<link rel=\"alternate\" href=\"https://example.com/\"/>\n"
+		"<link rel=\"self\" href=\"https://example.com/atom.xml\"/>\n"
+		"<id>urn:bench:feed</id>\n<updated>2026-10-05T18:04:58Z</updated>\n"
+		"<author><name>Bench</name></author>\n");
+	for (i = 0; i < items; i++) {
+		g_string_append (buffer, "<entry>\n<title type=\"text\">");
+		bench_append_text (buffer, i, 6);
+		g_string_append_printf (buffer, "</title>\n"
+			"<link rel=\"alternate\" type=\"text/html\" href=\"https://example.com/posts/%u\"/>\n"
+			"<link rel=\"replies\" type=\"application/atom+xml\" href=\"https://example.com/posts/%u/comments\"/>\n"
+			"<id>urn:bench:%u</id>\n"
+			"<published>2026-10-05T%02u:%02u:00Z</published>\n"
+			"<updated>2026-10-05T%02u:%02u:00Z</updated>\n"
+			"<author><name>Author %u</name><uri>https://example.com/~%u</uri></author>\n"
+			"<category term=\"news\"/><category term=\"bench\"/>\n"
+			"<media:thumbnail url=\"https://example.com/media/%u.jpg\"/>\n"
+			"<summary type=\"text\">",
+			i, i, i, i % 24, i % 60, i % 24, i % 60, i, i, i);
+		bench_append_text (buffer, i, 20);
+		g_string_append (buffer, "</summary>\n<content type=\"html\">");
+		bench_append_html (buffer, i, 2, TRUE);
+		g_string_append (buffer, "</content>\n</entry>\n");
+	}
+	g_string_append (buffer, "</feed>\n");
+}
+
+static void
+bench_gen_atom03 (GString *buffer, guint items)
+{
+	guint	i;
+
+	g_string_append (buffer,
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<feed version=\"0.3\" xmlns=\"http://purl.org/atom/ns#\">\n"
+		"<title>Benchmark Atom 0.3</title>\n"
+		"<link rel=\"alternate\" type=\"text/html\" href=\"https://example.com/\"/>\n"
+		"<modified>2026-10-05T18:04:58Z</modified>\n");
+	for (i = 0; i < items; i++) {
+		g_string_append (buffer, "<entry>\n<title>");
+		bench_append_text (buffer, i, 6);
+		g_string_append_printf (buffer, "</title>\n"
+			"<link rel=\"alternate\" type=\"text/html\" href=\"https://example.com/posts/%u\"/>\n"
+			"<id>urn:bench:%u</id>\n"
+			"<issued>2026-10-05T%02u:%02u:00Z</issued>\n"
+			"<modified>2026-10-05T%02u:%02u:00Z</modified>\n"
+			"<author><name>Author %u</name></author>\n"
+			"<content type=\"text/html\" mode=\"escaped\">",
+			i, i, i % 24, i % 60, i % 24, i % 60, i);
+		bench_append_html (buffer, i, 2, TRUE);
+		g_string_append (buffer, "</content>\n</entry>\n");
+	}
+	g_string_append (buffer, "</feed>\n");
+}
+
+static void
+bench_gen_cdf (GString *buffer, guint items)
+{
+	guint	i;
+
+	g_string_append (buffer,
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<CHANNEL HREF=\"https://example.com/\">\n"
+		"<TITLE>Benchmark CDF</TITLE>\n"
+		"<ABSTRACT>A synthetic CDF channel</ABSTRACT>\n"
+		"<LOGO HREF=\"https://example.com/logo.gif\" STYLE=\"IMAGE\"/>\n");
+	for (i = 0; i < items; i++) {
+		g_string_append_printf (buffer, "<ITEM HREF=\"https://example.com/posts/%u\" LASTMOD=\"2026-10-05T18:04\">\n<TITLE>", i);
+		bench_append_text (buffer, i, 6);
+		g_string_append (buffer, "</TITLE>\n<ABSTRACT>");
+		bench_append_text (buffer, i, 30);
+		g_string_append (buffer, "</ABSTRACT>\n</ITEM>\n");
+	}
+	g_string_append (buffer, "</CHANNEL>\n");
+}
+
+/* Typical breakage seen in the wild: undefined entities, unescaped
+   ampersands, invalid UTF-8, unclosed elements and a truncated end */
+static void
+bench_gen_malformed (GString *buffer, guint items)
+{
+	guint	i;
+
+	bench_rss2_header (buffer, " xmlns:dc=\"http://purl.org/dc/elements/1.1/\"");
+	for (i = 0; i < items; i++) {
+		g_string_append (buffer, "<item>\n");
+		bench_rss2_item_common (buffer, i);
+		switch (i % 4) {
+			case 0:
+				g_string_append (buffer, "<description>Tom &amp; Jerry &nbsp; &copy; AT&T R&D</description>\n");
+				break;
+			case 1:
+				g_string_append (buffer, "<description>Caf\xe9 na\xefve \xff\xfe bytes</description>\n");
+				break;
+			case 2:
+				g_string_append (buffer, "<description><b>unclosed <i>markup</description>\n<dc:creator>Somebody\n");
+				break;
+			default:
+				g_string_append (buffer, "<description>");
+				bench_append_text (buffer, i, 30);
+				g_string_append (buffer, "</description>\n");
+				break;
+		}
+		g_string_append (buffer, "</item>\n");
+	}
+	/* no closing channel and rss tags */
+}
+
+static const benchCase bench_cases[] = {
+	{ "rss2_plain",		bench_gen_rss2_plain,		10000 },
+	{ "rss2_namespaces",	bench_gen_rss2_namespaces,	10000 },
+	{ "rss2_html",		bench_gen_rss2_html,		1000 },
+	{ "rdf",		bench_gen_rdf,			10000 },
+	{ "atom10",		bench_gen_atom10,		10000 },
+	{ "atom03",		bench_gen_atom03,		1000 },
+	{ "cdf",		bench_gen_cdf,			1000 },
+	{ "malformed",		bench_gen_malformed,		1000 },
+	{ NULL, NULL, 0 }
+};
+
+/* benchmark execution */
+
+static guint
+bench_parse (GString *buffer)
+{
+	struct node		node;
+	subscriptionPtr		subscription;
+	feedParserCtxtPtr	ctxt;
+	GList			*iter;
+	guint			count;
+
+	memset (&node, 0, sizeof (node));
+	node.title = "benchmark";
+
+	subscription = subscription_new (NULL, NULL, NULL);
+	subscription->node = &node;
+	subscription->source = g_strdup ("https://example.com/feed.xml");
+
+	ctxt = feed_create_parser_ctxt ();
+	ctxt->feed = feed_new ();
+	ctxt->subscription = subscription;
+	ctxt->data = buffer->str;
+	ctxt->dataLength = buffer->len;
+
+	feed_parse (ctxt);
+
+	count = g_list_length (ctxt->items);
+	for (iter = ctxt->items; iter; iter = g_list_next (iter))
+		item_unload ((itemPtr)iter->data);
+	g_list_free (ctxt->items);
+
+	if (ctxt->feed->parseErrors)
+		g_string_free (ctxt->feed->parseErrors, TRUE);
+	g_free (ctxt->feed);
+	feed_free_parser_ctxt (ctxt);
+	subscription_free (subscription);
+
+	return count;
+}
+
+static void
+bench_run (gconstpointer user_data)
+{
+	const benchRun	*run = (const benchRun *)user_data;
+	GString		*buffer;
+	GTimer		*timer;
+	guint64		startAllocations;
+	guint		i, repeat, parsed = 0;
+	gdouble		itemsPerSecond, allocationsPerItem;
+
+	buffer = g_string_new (NULL);
+	(*run->format->generate) (buffer, run->items);
+	repeat = MAX (1, BENCH_ITEMS_PER_CASE / run->items);
+
+	/* warm up parser handler tables and caches */
+	bench_parse (buffer);
+
+	timer = g_timer_new ();
+	startAllocations = allocations;
+	for (i = 0; i < repeat; i++)
+		parsed += bench_parse (buffer);
+	g_timer_stop (timer);
+
+	/* malformed input may lose items, but never all of them */
+	g_assert_cmpuint (parsed, >, 0);
+
+	itemsPerSecond = parsed / MAX (g_timer_elapsed (timer, NULL), 1e-6);
+	allocationsPerItem = (gdouble)(allocations - startAllocations) / parsed;
+
+	g_print ("%-24s %6u items %8.1f kB %12.0f items/s", run->key, run->items, buffer->len / 1024.0, itemsPerSecond);
+	if (BENCH_COUNTS_ALLOCATIONS)
+		g_print (" %10.1f allocs/item", allocationsPerItem);
+	g_print ("\n");
+
+	g_key_file_set_double (results, run->key, "items_per_second", itemsPerSecond);
+	if (BENCH_COUNTS_ALLOCATIONS)
+		g_key_file_set_double (results, run->key, "allocations_per_item", allocationsPerItem);
+
+	if (baseline && !updateBaseline && g_key_file_has_group (baseline, run->key)) {
+		gdouble expected;
+
+		expected = g_key_file_get_double (baseline, run->key, "items_per_second", NULL);
+		if (itemsPerSecond < expected * (1.0 - tolerance / 100.0)) {
+			g_test_message ("%s: %.0f items/s is more than %.0f%% below the baseline of %.0f items/s",
+			                run->key, itemsPerSecond, tolerance, expected);
+			g_test_fail ();
+		}
+
+		if (BENCH_COUNTS_ALLOCATIONS && g_key_file_has_key (baseline, run->key, "allocations_per_item", NULL)) {
+			expected = g_key_file_get_double (baseline, run->key, "allocations_per_item", NULL);
+			if (allocationsPerItem > expected * (1.0 + BENCH_ALLOC_TOLERANCE)) {
+				g_test_message ("%s: %.1f allocations per item exceed the baseline of %.1f",
+				                run->key, allocationsPerItem, expected);
+				g_test_fail ();
+			}
+		}
+	}
+
+	g_timer_destroy (timer);
+	g_string_free (buffer, TRUE);
+}
+
+int
+main (int argc, char *argv[])
+{
+	GOptionContext	*context;
+	GError		*error = NULL;
+	GSList		*runs = NULL;
+	guint		i, items;
+	gint		res;
+
+	GOptionEntry entries[] = {
+		{ "baseline", 0, 0, G_OPTION_ARG_FILENAME, &baselineFile, "Compare results to the baseline in FILE", "FILE" },
+		{ "update-baseline", 0, 0, G_OPTION_ARG_NONE, &updateBaseline, "Write the results to the baseline file instead of comparing", NULL },
+		{ "tolerance", 0, 0, G_OPTION_ARG_DOUBLE, &tolerance, "Allowed throughput regression in percent (default 20)", "PERCENT" },
+		{ NULL, 0, 0, 0, NULL, NULL, NULL }
+	};
+
+	/* Have all GLib allocations go through malloc() to count them */
+	g_setenv ("G_SLICE", "always-malloc", TRUE);
+
+	g_test_init (&argc, &argv, NULL);
+
+	context = g_option_context_new (NULL);
+	g_option_context_add_main_entries (context, entries, NULL);
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		return 1;
+	}
+	g_option_context_free (context);
+
+	if (baselineFile && !updateBaseline) {
+		baseline = g_key_file_new ();
+		if (!g_key_file_load_from_file (baseline, baselineFile, G_KEY_FILE_NONE, &error)) {
+			g_print ("No baseline loaded (%s), only reporting results.\n", error->message);
+			g_clear_error (&error);
+			g_key_file_free (baseline);
+			baseline = NULL;
+		}
+	}
+	results = g_key_file_new ();
+
+	xml_init ();
+
+	for (i = 0; bench_cases[i].name; i++) {
+		for (items = 10; items <= bench_cases[i].maxItems; items *= 10) {
+			benchRun	*run = g_new0 (benchRun, 1);
+			gchar		*path;
+
+			run->format = &bench_cases[i];
+			run->items = items;
+			run->key = g_strdup_printf ("%s/%u", bench_cases[i].name, items);
+			runs = g_slist_prepend (runs, run);
+
+			path = g_strdup_printf ("/parser_bench/%s", run->key);
+			g_test_add_data_func (path, run, bench_run);
+			g_free (path);
+		}
+	}
+
+	res = g_test_run ();
+
+	if (updateBaseline) {
+		if (!baselineFile)
+			g_printerr ("--update-baseline needs --baseline=FILE\n");
+		else if (!g_key_file_save_to_file (results, baselineFile, &error)) {
+			g_printerr ("Could not write baseline: %s\n", error->message);
+			g_clear_error (&error);
+			res = 1;
+		}
+	}
+
+	g_key_file_free (results);
+	if (baseline)
+		g_key_file_free (baseline);
+
+	return res;
+}
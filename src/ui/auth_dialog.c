@@ -25,6 +25,7 @@
 #include "common.h"
 #include "debug.h"
 #include "ui/liferea_dialog.h"
+#include "ui/liferea_shell.h"
 
 #define AUTH_DIALOG_GET_PRIVATE(object)(G_TYPE_INSTANCE_GET_PRIVATE ((object), AUTH_DIALOG_TYPE, AuthDialogPrivate))
 
@@ -153,6 +154,11 @@ auth_dialog_new (subscriptionPtr subscription, gint flags)
 		debug0 (DEBUG_UPDATE, "Missing/wrong authentication. Skipping, as a dialog is already active.");
 		return NULL;
 	}
+
+	if (!liferea_shell_get_window ()) {
+		debug1 (DEBUG_UPDATE, "Missing/wrong authentication for \"%s\". No dialog when running headless.", subscription->source);
+		return NULL;
+	}
 	
 	ad = AUTH_DIALOG (g_object_new (AUTH_DIALOG_TYPE, NULL));
 	auth_dialog_load(ad, subscription, flags);
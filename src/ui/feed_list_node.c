@@ -193,6 +193,9 @@ feed_list_node_add (nodePtr node)
 
 	debug2 (DEBUG_GUI, "adding node \"%s\" as child of parent=\"%s\"", node_get_title(node), (NULL != node->parent)?node_get_title(node->parent):"feed list root");
 
+	if (!feedstore)
+		return;	/* no feed list view when running headless */
+
 	g_assert (NULL != node->parent);
 	g_assert (NULL == feed_list_node_to_iter (node->id));
 
@@ -322,6 +322,9 @@ feed_list_view_select (nodePtr node)
 {
 	GtkTreeView		*treeview;
 	GtkTreeModel		*model;
+
+	if (!feedstore)
+		return;	/* running headless */
 	
 	treeview = GTK_TREE_VIEW (liferea_shell_lookup ("feedlist"));
 	model = gtk_tree_view_get_model (treeview);
@@ -28,6 +28,24 @@
 
 static GIcon *icons[MAX_ICONS];	/**<< list of icon assignments */
 
+static const gchar *iconNames[] = {
+	"unread",		/* ICON_UNREAD */
+	"emblem-important",	/* ICON_FLAG */
+	"available",	/* ICON_AVAILABLE */
+	"available_offline",	/* ICON_AVAILABLE_OFFLINE */
+	"dialog-error",		/* ICON_UNAVAILABLE */
+	"default",		/* ICON_DEFAULT */
+	"folder",		/* ICON_FOLDER */
+	"folder-saved-search",	/* ICON_VFOLDER */
+	"newsbin",		/* ICON_NEWSBIN */
+	"empty",		/* ICON_EMPTY */
+	"empty_offline",	/* ICON_EMPTY_OFFLINE */
+	"gtk-connect",		/* ICON_ONLINE */
+	"gtk-disconnect",	/* ICON_OFFLINE */
+	"mail-attachment",	/* ICON_ENCLOSURE */
+	NULL
+};
+
 static gchar *
 icon_find_pixmap_file (const gchar *filename)
 {
@@ -76,33 +94,19 @@ icons_load (void)
 	icon_theme = gtk_icon_theme_get_default ();
 
 	gtk_icon_theme_append_search_path (icon_theme, path);
-
-	static const gchar *iconNames[] = {
-		"unread",		/* ICON_UNREAD */
-		"emblem-important",	/* ICON_FLAG */
-		"available",	/* ICON_AVAILABLE */
-		"available_offline",	/* ICON_AVAILABLE_OFFLINE */
-		"dialog-error",		/* ICON_UNAVAILABLE */
-		"default",		/* ICON_DEFAULT */
-		"folder",		/* ICON_FOLDER */
-		"folder-saved-search",	/* ICON_VFOLDER */
-		"newsbin",		/* ICON_NEWSBIN */
-		"empty",		/* ICON_EMPTY */
-		"empty_offline",	/* ICON_EMPTY_OFFLINE */
-		"gtk-connect",		/* ICON_ONLINE */
-		"gtk-disconnect",	/* ICON_OFFLINE */
-		"mail-attachment",	/* ICON_ENCLOSURE */
-		NULL
-	};
+	g_free (path);
 
 	for (i = 0; i < MAX_ICONS; i++)
-		icons[i] = g_themed_icon_new (iconNames[i]);
+		icon_get (i);
 }
 
 const GIcon *
 icon_get (lifereaIcon icon)
 {
-	g_assert (NULL != *icons);		
+	/* Themed icons need no display, so they are created on
+	   demand to be available when running headless too */
+	if (!icons[icon])
+		icons[icon] = g_themed_icon_new (iconNames[icon]);
 
 	return icons[icon];
 }
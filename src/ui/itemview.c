@@ -150,6 +150,10 @@ itemview_class_init (ItemViewClass *klass)
 void
 itemview_clear (void) 
 {
+	/* There is no item view when running headless */
+	if (!itemview)
+		return;
+
 	if (itemview->priv->itemListView)
 		item_list_view_clear (itemview->priv->itemListView);
 	htmlview_clear ();
@@ -162,6 +166,9 @@ itemview_clear (void)
 void
 itemview_set_mode (itemViewMode mode)
 {
+	if (!itemview)
+		return;
+
 	if (itemview->priv->mode != mode) {
 		/* FIXME: Not being able to call itemview_clear() here is awful! */
 		itemview->priv->mode = mode;
@@ -172,6 +179,9 @@ itemview_set_mode (itemViewMode mode)
 void
 itemview_set_displayed_node (nodePtr node)
 {
+	if (!itemview)
+		return;
+
 	if (node == itemview->priv->node)
 		return;
 		
@@ -187,6 +197,9 @@ itemview_set_displayed_node (nodePtr node)
 void
 itemview_add_item (itemPtr item)
 {
+	if (!itemview)
+		return;
+
 	itemview->priv->hasEnclosures |= item->hasEnclosure;
 
 	if (itemview->priv->itemListView)
@@ -202,6 +215,9 @@ itemview_add_item (itemPtr item)
 void
 itemview_remove_item (itemPtr item)
 {
+	if (!itemview)
+		return;
+
 	if (itemview->priv->itemListView) {
 		/* remove item in 3 pane mode */
 		if (item_list_view_contains_id (itemview->priv->itemListView, item->id))
@@ -218,7 +234,12 @@ itemview_remove_item (itemPtr item)
 void
 itemview_select_item (itemPtr item)
 {
-	ItemViewPrivate *ivp = itemview->priv;
+	ItemViewPrivate *ivp;
+
+	if (!itemview)
+		return;
+
+	ivp = itemview->priv;
 
 	/* Enforce single item mode as we currently know no other way
 	   to select a single item... */
@@ -249,6 +270,9 @@ itemview_select_enclosure (guint position)
 void
 itemview_update_item (itemPtr item)
 {
+	if (!itemview)
+		return;
+
 	/* Always update the GtkTreeView (bail-out done in ui_itemlist_update_item() */
 	if (itemview->priv->itemListView)
 		item_list_view_update_item (itemview->priv->itemListView, item);
@@ -282,6 +306,9 @@ itemview_update_item (itemPtr item)
 void
 itemview_update_all_items (void)
 {
+	if (!itemview)
+		return;
+
 	/* Always update the GtkTreeView (bail-out done in ui_itemlist_update_item() */
 	if (itemview->priv->itemListView)
 		item_list_view_update_all_items (itemview->priv->itemListView);
@@ -293,6 +320,9 @@ itemview_update_all_items (void)
 void
 itemview_update_node_info (nodePtr node)
 {
+	if (!itemview)
+		return;
+
 	/* Bail if we do internal browsing, and no item is shown */
 	if (itemview->priv->browsing)
 		return;
@@ -313,6 +343,9 @@ itemview_update_node_info (nodePtr node)
 void
 itemview_update (void)
 {
+	if (!itemview)
+		return;
+
 	if (itemview->priv->itemListView)
 		item_list_view_update (itemview->priv->itemListView, itemview->priv->hasEnclosures);
 	
@@ -346,7 +379,7 @@ itemview_find_unread_item (gulong startId)
 	/* Note: to select in sorting order we need to do it in the ItemListView
 	   otherwise we would have to sort the item list here... */
 
-	if (!itemview->priv->itemListView)
+	if (!itemview || !itemview->priv->itemListView)
 		/* If there is no itemListView we are in combined view and all
 		 * items are treated as read. */
 		return NULL;
@@ -407,10 +440,14 @@ on_important_status_message (gpointer obj, gchar *url)
 void
 itemview_set_layout (nodeViewType newMode)
 {
-	ItemViewPrivate *ivp = itemview->priv;
+	ItemViewPrivate *ivp;
 	GtkWidget 	*previous_parent = NULL;
 	const gchar	*htmlWidgetName, *ilWidgetName, *encViewVBoxName;
-	
+
+	if (!itemview)
+		return;
+
+	ivp = itemview->priv;
 	if (newMode == ivp->currentLayoutMode)
 		return;
 	ivp->currentLayoutMode = newMode;
@@ -357,12 +357,18 @@ liferea_shell_update_toolbar (void)
 void
 liferea_shell_update_update_menu (gboolean enabled)
 {
+	if (!shell)
+		return;
+
 	gtk_action_set_sensitive (gtk_action_group_get_action (shell->priv->feedActions, "UpdateSelected"),	enabled);
 }
 
 void
 liferea_shell_update_feed_menu (gboolean add, gboolean enabled, gboolean readWrite)
 {
+	if (!shell)
+		return;
+
 	gtk_action_group_set_sensitive (shell->priv->addActions, add);
 	gtk_action_group_set_sensitive (shell->priv->feedActions, enabled);
 	gtk_action_group_set_sensitive (shell->priv->readWriteActions, readWrite);
@@ -377,6 +383,9 @@ liferea_shell_update_item_menu (gboolean enabled)
 void
 liferea_shell_update_allitems_actions (gboolean isNotEmpty, gboolean isRead)
 {
+	if (!shell)
+		return;
+
 	gtk_action_set_sensitive (gtk_action_group_get_action (shell->priv->generalActions, "RemoveAllItems"), isNotEmpty);
 	gtk_action_set_sensitive (gtk_action_group_get_action (shell->priv->feedActions, "MarkFeedAsRead"), isRead);
 }
@@ -384,6 +393,9 @@ liferea_shell_update_allitems_actions (gboolean isNotEmpty, gboolean isRead)
 void
 liferea_shell_update_history_actions (void)
 {
+	if (!shell)
+		return;
+
 	gtk_action_set_sensitive (gtk_action_group_get_action (shell->priv->generalActions, "PrevReadItem"), item_history_has_previous ());
 	gtk_action_set_sensitive (gtk_action_group_get_action (shell->priv->generalActions, "NextReadItem"), item_history_has_next ());
 }
@@ -486,7 +498,7 @@ liferea_shell_set_status_bar (const char *format, ...)
 	va_list		args;
 	gchar		*text;
 	
-	if (shell->priv->statusbarLocked)
+	if (shell && shell->priv->statusbarLocked)
 		return;
 
 	g_return_if_fail (format != NULL);
@@ -495,6 +507,13 @@ liferea_shell_set_status_bar (const char *format, ...)
 	text = g_strdup_vprintf (format, args);
 	va_end (args);
 
+	/* When running headless there is only the debug output */
+	if (!shell) {
+		debug1 (DEBUG_GUI, "status: %s", text);
+		g_free (text);
+		return;
+	}
+
 	g_idle_add ((GSourceFunc)liferea_shell_set_status_bar_default_cb, (gpointer)text);
 }
 
@@ -510,6 +529,12 @@ liferea_shell_set_important_status_bar (const char *format, ...)
 	text = g_strdup_vprintf (format, args);
 	va_end (args);
 
+	if (!shell) {
+		debug1 (DEBUG_GUI, "status: %s", text);
+		g_free (text);
+		return;
+	}
+
 	shell->priv->statusbarLocked = FALSE;
 	if (shell->priv->statusbarLockTimer) {
 		g_source_remove (shell->priv->statusbarLockTimer);
@@ -1375,6 +1400,7 @@ liferea_shell_create (GtkApplication *app, const gchar *overrideWindowState, gin
 	/* 10.) After main window is realized get theme colors and set up feed
  	        list and tray icon */
 	render_init_theme_colors (GTK_WIDGET (shell->priv->window));
+	debug_startup_phase ("main window setup");
 
 	shell->priv->feedlist = feedlist_create ();
 	g_signal_connect (shell->priv->feedlist, "new-items",
@@ -1399,6 +1425,7 @@ liferea_shell_create (GtkApplication *app, const gchar *overrideWindowState, gin
 	/* 14. Rebuild search folders if needed */
 	if (searchFolderRebuild)
 		vfolder_foreach (vfolder_rebuild);
+	debug_startup_phase ("plugin setup");
 
 	debug_exit ("liferea_shell_create");
 }
@@ -1421,7 +1448,12 @@ liferea_shell_destroy (void)
 void
 liferea_shell_present (void)
 {
-	GtkWidget *mainwindow = GTK_WIDGET (shell->priv->window);
+	GtkWidget *mainwindow;
+
+	if (!shell)
+		return;	/* running headless */
+
+	mainwindow = GTK_WIDGET (shell->priv->window);
 	
 	if ((gdk_window_get_state (gtk_widget_get_window (mainwindow)) & GDK_WINDOW_STATE_ICONIFIED) || !gtk_widget_get_visible (mainwindow))
 		liferea_shell_restore_position ();
@@ -1462,6 +1494,9 @@ liferea_shell_toggle_visibility (void)
 GtkWidget *
 liferea_shell_get_window (void)
 {
+	if (!shell)
+		return NULL;
+
 	return GTK_WIDGET (shell->priv->window);
 }
 
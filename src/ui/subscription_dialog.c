@@ -374,6 +374,77 @@ on_feed_prop_update_radio (GtkToggleButton *button,
 	gtk_widget_set_sensitive (priv->refreshIntervalUnit, limited);
 }
 
+enum {
+	TIMINGS_TIME,
+	TIMINGS_QUEUE,
+	TIMINGS_DOWNLOAD,
+	TIMINGS_FILTER,
+	TIMINGS_PARSE,
+	TIMINGS_MERGE,
+	TIMINGS_DB,
+	TIMINGS_TOTAL,
+	TIMINGS_SIZE,
+	TIMINGS_LEN
+};
+
+static gchar *
+subscription_prop_format_msec (guint64 usec)
+{
+	return g_strdup_printf ("%.1f", usec / 1000.0);
+}
+
+static void
+subscription_prop_dialog_load_timings (SubscriptionPropDialog *spd,
+                                       subscriptionPtr subscription)
+{
+	GtkTreeView	*view;
+	GtkListStore	*store;
+	GtkTreeIter	iter;
+	GList		*list;
+	guint		i;
+	const gchar	*titles[TIMINGS_LEN] = {
+		_("Time"), _("Queue"), _("Download"), _("Filter"), _("Parse"),
+		_("Merge"), _("DB"), _("Total"), _("Size")
+	};
+
+	view = GTK_TREE_VIEW (liferea_dialog_lookup (spd->priv->dialog, "updateTimingsView"));
+	store = gtk_list_store_new (TIMINGS_LEN, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+	                            G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+	                            G_TYPE_STRING, G_TYPE_STRING);
+
+	for (list = g_queue_peek_head_link (subscription->timings); list; list = g_list_next (list)) {
+		updateTimingsPtr	timings = (updateTimingsPtr)list->data;
+		GDateTime		*date;
+		gchar			*values[TIMINGS_LEN];
+
+		date = g_date_time_new_from_unix_local (timings->timestamp / G_USEC_PER_SEC);
+		values[TIMINGS_TIME] = g_date_time_format (date, "%X");
+		g_date_time_unref (date);
+		values[TIMINGS_QUEUE] = subscription_prop_format_msec (timings->queueWait);
+		values[TIMINGS_DOWNLOAD] = subscription_prop_format_msec (timings->download);
+		values[TIMINGS_FILTER] = subscription_prop_format_msec (timings->filter);
+		values[TIMINGS_PARSE] = subscription_prop_format_msec (timings->parse);
+		values[TIMINGS_MERGE] = subscription_prop_format_msec (timings->merge);
+		values[TIMINGS_DB] = subscription_prop_format_msec (timings->dbWrite);
+		values[TIMINGS_TOTAL] = subscription_prop_format_msec (update_timings_get_total (timings));
+		/* raw transfer size and size after content decoding */
+		values[TIMINGS_SIZE] = g_strdup_printf ("%" G_GUINT64_FORMAT " / %" G_GUINT64_FORMAT,
+		                                        timings->rawBytes, timings->decodedBytes);
+
+		gtk_list_store_append (store, &iter);
+		for (i = 0; i < TIMINGS_LEN; i++) {
+			gtk_list_store_set (store, &iter, i, values[i], -1);
+			g_free (values[i]);
+		}
+	}
+
+	for (i = 0; i < TIMINGS_LEN; i++)
+		gtk_tree_view_insert_column_with_attributes (view, -1, titles[i], gtk_cell_renderer_text_new (), "text", i, NULL);
+
+	gtk_tree_view_set_model (view, GTK_TREE_MODEL (store));
+	g_object_unref (store);
+}
+
 static void
 subscription_prop_dialog_load (SubscriptionPropDialog *spd, 
                                subscriptionPtr subscription) 
@@ -505,6 +576,9 @@ subscription_prop_dialog_load (SubscriptionPropDialog *spd,
 	gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (liferea_dialog_lookup (spd->priv->dialog, "markAsReadCheck")), feed->markAsRead);
 	gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (liferea_dialog_lookup (spd->priv->dialog, "html5ExtractCheck")), feed->html5Extract);
 
+	/* Statistics */
+	subscription_prop_dialog_load_timings (spd, subscription);
+
 	/* Remove tabs we do not need... */
 	if (SUBSCRIPTION_TYPE(subscription) != feed_get_subscription_type ()) {
 		/* Remove "General", "Source" and "Download" tab */
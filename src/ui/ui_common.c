@@ -89,6 +89,13 @@ ui_show_error_box (const char *format, ...)
 	msg = g_strdup_vprintf (format, args);
 	va_end (args);
 
+	/* Nobody to click away a dialog when running headless */
+	if (!liferea_shell_get_window ()) {
+		g_warning ("%s", msg);
+		g_free (msg);
+		return;
+	}
+
 	dialog = gtk_message_dialog_new (GTK_WINDOW (liferea_shell_get_window ()),
                   GTK_DIALOG_DESTROY_WITH_PARENT,
                   GTK_MESSAGE_ERROR,
@@ -112,6 +119,12 @@ ui_show_info_box (const char *format, ...)
 	msg = g_strdup_vprintf (format, args);
 	va_end (args);
 
+	if (!liferea_shell_get_window ()) {
+		g_message ("%s", msg);
+		g_free (msg);
+		return;
+	}
+
 	dialog = gtk_message_dialog_new (GTK_WINDOW (liferea_shell_get_window ()),
                   GTK_DIALOG_DESTROY_WITH_PARENT,
                   GTK_MESSAGE_INFO,
@@ -33,11 +33,27 @@ enum {
 	UM_LEN
 };
 
+/* slowest feeds list, durations are averages in milliseconds */
+enum {
+	SF_FAVICON,
+	SF_TITLE,
+	SF_TOTAL,
+	SF_QUEUE,
+	SF_DOWNLOAD,
+	SF_FILTER,
+	SF_PARSE,
+	SF_MERGE,
+	SF_DB,
+	SF_LEN
+};
+
 static GtkWidget *umdialog = NULL;
 static GtkTreeStore *um1store = NULL;
 static GtkTreeStore *um2store = NULL;
 static GHashTable *um1hash = NULL;
 static GHashTable *um2hash = NULL;
+static GtkListStore *um3store = NULL;
+static GHashTable *um3hash = NULL;
 
 static void ui_update_remove_request(nodePtr node, GtkTreeStore *store, GHashTable *hash) {
 	GtkTreeIter	*iter;
@@ -94,10 +110,67 @@ ui_update_find_requests (nodePtr node) {
 	ui_update_remove_request (node, um2store, um2hash);
 }
 
+static void
+ui_update_find_timings (nodePtr node)
+{
+	struct updateTimings	average;
+	GtkTreeIter		*iter;
+	gchar			*title;
+
+	if (node->children)
+		node_foreach_child (node, ui_update_find_timings);
+
+	if (!node->subscription)
+		return;
+
+	if (!subscription_get_average_timings (node->subscription, &average))
+		return;
+
+	iter = (GtkTreeIter *)g_hash_table_lookup (um3hash, node->id);
+	if (!iter) {
+		iter = g_new0 (GtkTreeIter, 1);
+		gtk_list_store_append (um3store, iter);
+		g_hash_table_insert (um3hash, g_strdup (node->id), iter);
+	}
+
+	title = g_markup_escape_text (node_get_title (node), -1);
+	gtk_list_store_set (um3store, iter, SF_FAVICON, node_get_icon (node),
+	                                    SF_TITLE, title,
+	                                    SF_TOTAL, (guint)(update_timings_get_total (&average) / 1000),
+	                                    SF_QUEUE, (guint)(average.queueWait / 1000),
+	                                    SF_DOWNLOAD, (guint)(average.download / 1000),
+	                                    SF_FILTER, (guint)(average.filter / 1000),
+	                                    SF_PARSE, (guint)(average.parse / 1000),
+	                                    SF_MERGE, (guint)(average.merge / 1000),
+	                                    SF_DB, (guint)(average.dbWrite / 1000),
+	                                    -1);
+	g_free (title);
+}
+
+void
+ui_update_remove_node (nodePtr node)
+{
+	GtkTreeIter	*iter;
+
+	if (!umdialog)
+		return;
+
+	ui_update_remove_request (node, um1store, um1hash);
+	ui_update_remove_request (node, um2store, um2hash);
+
+	/* the hash table frees key and iter */
+	iter = (GtkTreeIter *)g_hash_table_lookup (um3hash, node->id);
+	if (iter) {
+		gtk_list_store_remove (um3store, iter);
+		g_hash_table_remove (um3hash, node->id);
+	}
+}
+
 static gboolean ui_update_monitor_update(void *data) {
 
 	if(umdialog) {
 		feedlist_foreach(ui_update_find_requests);
+		feedlist_foreach(ui_update_find_timings);
 		return TRUE;
 	} else {
 		return FALSE;
@@ -126,8 +199,10 @@ on_update_monitor_destroyed_cb(GtkWidget *widget, void *data)
 {
 	g_hash_table_destroy(um1hash);
 	g_hash_table_destroy(um2hash);
+	g_hash_table_destroy(um3hash);
 	um1hash = NULL;
 	um2hash = NULL;
+	um3hash = NULL;
 	umdialog = NULL;
 }
 
@@ -141,6 +216,11 @@ void on_menu_show_update_monitor(GtkWidget *widget, gpointer user_data) {
 	GtkCellRenderer		*textRenderer, *iconRenderer;	
 	GtkTreeViewColumn 	*column;
 	GtkTreeView		*view;
+	guint			i;
+	const gchar		*titles[SF_LEN] = {
+		NULL, _("Feed"), _("Total"), _("Queue"), _("Download"),
+		_("Filter"), _("Parse"), _("Merge"), _("DB")
+	};
 
 	if(!umdialog) {
 		umdialog = liferea_dialog_new ("update_monitor");
@@ -175,10 +255,38 @@ void on_menu_show_update_monitor(GtkWidget *widget, gpointer user_data) {
 		gtk_tree_view_column_add_attribute(column, iconRenderer, "gicon", UM_FAVICON);
 		gtk_tree_view_column_add_attribute(column, textRenderer, "markup", UM_REQUEST_TITLE);
 		gtk_tree_view_append_column(view, column);		
+
+		/* Set up sortable slowest feeds view */
+		view = GTK_TREE_VIEW (liferea_dialog_lookup (umdialog, "slowest"));
+		um3store = gtk_list_store_new (SF_LEN, G_TYPE_ICON, G_TYPE_STRING, G_TYPE_UINT, G_TYPE_UINT,
+		                               G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT);
+		gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (um3store), SF_TOTAL, GTK_SORT_DESCENDING);
+		gtk_tree_view_set_model (view, GTK_TREE_MODEL (um3store));
+		g_object_unref (um3store);
+
+		textRenderer = gtk_cell_renderer_text_new ();
+		iconRenderer = gtk_cell_renderer_pixbuf_new ();
+		column = gtk_tree_view_column_new ();
+		gtk_tree_view_column_set_title (column, titles[SF_TITLE]);
+		gtk_tree_view_column_pack_start (column, iconRenderer, FALSE);
+		gtk_tree_view_column_pack_start (column, textRenderer, TRUE);
+		gtk_tree_view_column_add_attribute (column, iconRenderer, "gicon", SF_FAVICON);
+		gtk_tree_view_column_add_attribute (column, textRenderer, "markup", SF_TITLE);
+		gtk_tree_view_column_set_sort_column_id (column, SF_TITLE);
+		gtk_tree_view_column_set_expand (column, TRUE);
+		gtk_tree_view_append_column (view, column);
+
+		for (i = SF_TOTAL; i < SF_LEN; i++) {
+			column = gtk_tree_view_column_new_with_attributes (titles[i], gtk_cell_renderer_text_new (), "text", i, NULL);
+			gtk_tree_view_column_set_sort_column_id (column, i);
+			gtk_tree_view_append_column (view, column);
+		}
 		
 		/* Fill in data */
 		um1hash = g_hash_table_new(g_str_hash, g_str_equal);
 		um2hash = g_hash_table_new(g_str_hash, g_str_equal);
+		um3hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+		feedlist_foreach (ui_update_find_timings);
 	 	(void)g_timeout_add_seconds(1, ui_update_monitor_update, NULL);
 	}
 	
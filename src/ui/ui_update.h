@@ -23,10 +23,20 @@
 
 #include <gtk/gtk.h>
 
+#include "node.h"
+
 void on_close_update_monitor_clicked(GtkButton *button, gpointer user_data);
 
 void on_menu_show_update_monitor(GtkWidget *widget, gpointer user_data);
 
 void on_cancel_all_requests_clicked(GtkButton *button, gpointer user_data);
+
+/**
+ * Drops the rows of a node that is about to be freed from
+ * the update monitor lists.
+ *
+ * @param node		the removed node
+ */
+void ui_update_remove_node (nodePtr node);
  
 #endif
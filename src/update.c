@@ -40,6 +40,8 @@
 #include "auth_activatable.h"
 #include "common.h"
 #include "debug.h"
+#include "filter.h"
+#include "metrics.h"
 #include "net.h"
 #include "plugins_engine.h"
 #include "xml.h"
@@ -58,6 +60,17 @@ static GAsyncQueue *pendingJobs = NULL;
 static guint numberOfActiveJobs = 0;
 #define MAX_ACTIVE_JOBS	5
 
+/** compiled XSLT filter stylesheet, shared by all jobs using it */
+typedef struct updateStylesheet {
+	xsltStylesheetPtr	xslt;
+	time_t			mtime;		/**< modification time of the stylesheet file */
+	guint			refCount;	/**< cache reference plus one per running filter */
+} *updateStylesheetPtr;
+
+/** XSLT filter cache (stylesheet path -> updateStylesheetPtr), filters run in worker threads */
+static GHashTable *stylesheets = NULL;
+static GMutex stylesheetsLock;
+
 /* update state interface */
 
 updateStatePtr
@@ -176,6 +189,7 @@ update_result_new (void)
 	
 	result = g_new0 (struct updateResult, 1);
 	result->updateState = update_state_new ();
+	result->timings = g_new0 (struct updateTimings, 1);
 	
 	return result;
 }
@@ -188,6 +202,10 @@ update_result_free (updateResultPtr result)
 		
 	update_state_free (result->updateState);
 
+	if (result->doc)
+		xmlFreeDoc (result->doc);
+
+	g_free (result->timings);
 	g_free (result->data);
 	g_free (result->source);
 	g_free (result->contentType);
@@ -219,6 +237,13 @@ update_options_free (updateOptionsPtr options)
 	g_free (options);
 }
 
+guint64
+update_timings_get_total (updateTimingsPtr timings)
+{
+	return timings->queueWait + timings->download + timings->filter +
+	       timings->parse + timings->merge + timings->dbWrite;
+}
+
 /* update job handling */
 
 static updateJobPtr
@@ -238,6 +263,8 @@ update_job_new (gpointer owner,
 	job->user_data = user_data;
 	job->flags = flags;	
 	job->state = REQUEST_STATE_INITIALIZED;
+	job->result->timings->timestamp = g_get_real_time ();
+	job->result->timings->queued = g_get_monotonic_time ();
 	
 	return job;
 }
@@ -317,13 +344,75 @@ update_exec_filter_cmd (gchar *cmd, gchar *data, gchar **errorOutput, size_t *si
 	return out;
 }
 
-static gchar *
+static void
+update_stylesheet_unref (updateStylesheetPtr stylesheet)
+{
+	gboolean	last;
+
+	g_mutex_lock (&stylesheetsLock);
+	last = (0 == --stylesheet->refCount);
+	g_mutex_unlock (&stylesheetsLock);
+
+	if (last) {
+		xsltFreeStylesheet (stylesheet->xslt);
+		g_free (stylesheet);
+	}
+}
+
+/* Returns the compiled stylesheet for the given path, it is compiled
+   again only when the file was modified. Release with update_stylesheet_unref() */
+static updateStylesheetPtr
+update_stylesheet_get (const gchar *filename)
+{
+	updateStylesheetPtr	stylesheet, outdated = NULL;
+	xsltStylesheetPtr	xslt;
+	gpointer		key;
+	time_t			mtime = common_get_mod_time (filename);
+
+	g_mutex_lock (&stylesheetsLock);
+	if (!stylesheets)
+		stylesheets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)update_stylesheet_unref);
+
+	stylesheet = g_hash_table_lookup (stylesheets, filename);
+	if (stylesheet && stylesheet->mtime == mtime) {
+		stylesheet->refCount++;
+		g_mutex_unlock (&stylesheetsLock);
+		return stylesheet;
+	}
+	g_mutex_unlock (&stylesheetsLock);
+
+	debug1 (DEBUG_UPDATE, "compiling filter stylesheet \"%s\"", filename);
+	xslt = xsltParseStylesheetFile (BAD_CAST filename);
+	if (!xslt)
+		return NULL;
+
+	stylesheet = g_new0 (struct updateStylesheet, 1);
+	stylesheet->xslt = xslt;
+	stylesheet->mtime = mtime;
+	stylesheet->refCount = 2;	/* cache and caller */
+
+	/* Replace an outdated entry (or one compiled concurrently), it
+	   lives on until its last running filter releases it. It is
+	   released outside of the lock as unref takes the lock too. */
+	g_mutex_lock (&stylesheetsLock);
+	if (g_hash_table_lookup_extended (stylesheets, filename, &key, (gpointer *)&outdated)) {
+		g_hash_table_steal (stylesheets, filename);
+		g_free (key);
+	}
+	g_hash_table_insert (stylesheets, g_strdup (filename), stylesheet);
+	g_mutex_unlock (&stylesheetsLock);
+
+	if (outdated)
+		update_stylesheet_unref (outdated);
+
+	return stylesheet;
+}
+
+static xmlDocPtr
 update_apply_xslt (updateJobPtr job)
 {
-	xsltStylesheetPtr	xslt = NULL;
-	xmlOutputBufferPtr	buf;
+	updateStylesheetPtr	stylesheet = NULL;
 	xmlDocPtr		srcDoc = NULL, resDoc = NULL;
-	gchar			*output = NULL;
 
 	g_assert (NULL != job->result);
 	
@@ -331,62 +420,73 @@ update_apply_xslt (updateJobPtr job)
 		srcDoc = xml_parse (job->result->data, job->result->size, NULL);
 		if (!srcDoc) {
 			g_warning("fatal: parsing request result XML source failed (%s)!", job->request->filtercmd);
+			job->result->filterErrors = g_strdup_printf (_("Could not parse the input of filter stylesheet \"%s\""), job->request->filtercmd);
 			break;
 		}
 
-		/* load localization stylesheet */
-		xslt = xsltParseStylesheetFile (job->request->filtercmd);
-		if (!xslt) {
+		stylesheet = update_stylesheet_get (job->request->filtercmd);
+		if (!stylesheet) {
 			g_warning ("fatal: could not load filter stylesheet \"%s\"!", job->request->filtercmd);
+			job->result->filterErrors = g_strdup_printf (_("Could not load filter stylesheet \"%s\""), job->request->filtercmd);
 			break;
 		}
 
-		resDoc = xsltApplyStylesheet (xslt, srcDoc, NULL);
+		/* The result document is handed to the feed parser as is,
+		   there is no need to serialize and parse it once more. */
+		resDoc = xsltApplyStylesheet (stylesheet->xslt, srcDoc, NULL);
 		if (!resDoc) {
 			g_warning ("fatal: applying stylesheet \"%s\" failed!", job->request->filtercmd);
+			job->result->filterErrors = g_strdup_printf (_("Applying filter stylesheet \"%s\" failed"), job->request->filtercmd);
 			break;
 		}
 
-		buf = xmlAllocOutputBuffer (NULL);
-		if (-1 == xsltSaveResultTo (buf, resDoc, xslt)) {
-			g_warning ("fatal: retrieving result of filter stylesheet failed (%s)!", job->request->filtercmd);
-			break;
+		/* Except for plain text output that is still to be parsed */
+		if (xmlStrEqual (stylesheet->xslt->method, BAD_CAST "text")) {
+			xmlChar	*text = NULL;
+			int	len = 0;
+
+			if (0 == xsltSaveResultToString (&text, &len, resDoc, stylesheet->xslt) && text) {
+				xmlFreeDoc (resDoc);
+				resDoc = xml_parse ((gchar *)text, len, NULL);
+				xmlFree (text);
+			}
+			if (!resDoc) {
+				job->result->filterErrors = g_strdup_printf (_("Could not parse the output of filter stylesheet \"%s\""), job->request->filtercmd);
+				break;
+			}
 		}
-		
-#ifdef LIBXML2_NEW_BUFFER
-		if (xmlOutputBufferGetSize (buf) > 0)
-			output = xmlCharStrdup (xmlOutputBufferGetContent (buf));
-#else
-		if (xmlBufferLength (buf->buffer) > 0)
-			output = xmlCharStrdup (xmlBufferContent (buf->buffer));
-#endif
- 
-		xmlOutputBufferClose (buf);
 	} while (FALSE);
 
 	if (srcDoc)
 		xmlFreeDoc (srcDoc);
-	if (resDoc)
-		xmlFreeDoc (resDoc);
-	if (xslt)
-		xsltFreeStylesheet (xslt);
+	if (stylesheet)
+		update_stylesheet_unref (stylesheet);
 	
-	return output;
+	return resDoc;
 }
 
 static void
 update_apply_filter (updateJobPtr job)
 {
-	gchar	*filterResult;
-	size_t	len = 0;
+	gchar		*filterResult = NULL;
+	const gchar	*coprocessCmd;
+	size_t		len = 0;
+	gint64		start = g_get_monotonic_time ();
 
 	g_assert (NULL == job->result->filterErrors);
 
-	/* we allow two types of filters: XSLT stylesheets and arbitrary commands */
+	debug_span_begin ("update filter");
+	debug_span_arg_str ("source", job->request->source);
+	debug_span_arg_int ("bytes", job->result->size);
+
+	/* we allow three types of filters: XSLT stylesheets, arbitrary
+	   commands and commands kept running as coprocess (see filter.h) */
+	coprocessCmd = filter_get_coprocess_cmd (job->request->filtercmd);
 	if ((strlen (job->request->filtercmd) > 4) &&
 	    (0 == strcmp (".xsl", job->request->filtercmd + strlen (job->request->filtercmd) - 4))) {
-		filterResult = update_apply_xslt (job);
-		len = strlen (filterResult);
+		job->result->doc = update_apply_xslt (job);
+	} else if (coprocessCmd) {
+		filterResult = filter_coprocess_run (coprocessCmd, job->result->data, job->result->size, &len, FILTER_COPROCESS_TIMEOUT, &(job->result->filterErrors));
 	} else {
 		filterResult = update_exec_filter_cmd (job->request->filtercmd, job->result->data, &(job->result->filterErrors), &len);
 	}
@@ -396,6 +496,16 @@ update_apply_filter (updateJobPtr job)
 		job->result->data = filterResult;
 		job->result->size = len;
 	}
+
+	/* Never pass the unfiltered document on to the feed parser */
+	if (job->result->filterErrors) {
+		g_free (job->result->data);
+		job->result->data = NULL;
+		job->result->size = 0;
+	}
+
+	job->result->timings->filter = g_get_monotonic_time () - start;
+	debug_span_end ();
 }
 
 static void
@@ -404,8 +514,6 @@ update_exec_cmd (updateJobPtr job)
 	FILE	*f;
 	int	status;
 	size_t	len;
-	
-	job->result = update_result_new ();
 		
 	/* if the first char is a | we have a pipe else a file */
 	debug1 (DEBUG_UPDATE, "executing command \"%s\"...", (job->request->source) + 1);	
@@ -439,8 +547,6 @@ update_load_file (updateJobPtr job)
 	gchar *filename = job->request->source;
 	gchar *anchor;
 	
-	job->result = update_result_new ();
-	
 	if (!strncmp (filename, "file://",7))
 		filename += 7;
 
@@ -517,6 +623,8 @@ update_dequeue_job (gpointer user_data)
 	numberOfActiveJobs++;
 
 	job->state = REQUEST_STATE_PROCESSING;
+	job->result->timings->started = g_get_monotonic_time ();
+	job->result->timings->queueWait = job->result->timings->started - job->result->timings->queued;
 
 	debug1 (DEBUG_UPDATE, "processing request (%s)", job->request->source);
 	if (job->callback == NULL) {
@@ -572,8 +680,11 @@ update_process_result_idle_cb (gpointer user_data)
 {
 	updateJobPtr job = (updateJobPtr)user_data;
 	
+	debug_span_begin ("update result processing");
+	debug_span_arg_str ("source", job->request->source);
 	if (job->callback)
 		(job->callback) (job->result, job->user_data, job->flags);
+	debug_span_end ();
 
 	update_job_free (job);
 		
@@ -604,6 +715,14 @@ update_process_finished_job (updateJobPtr job)
 	numberOfActiveJobs--;
 	g_idle_add (update_dequeue_job, NULL);
 
+	job->result->timings->download = g_get_monotonic_time () - job->result->timings->started;
+	job->result->timings->decodedBytes = job->result->size;
+	if (!job->result->timings->rawBytes)
+		job->result->timings->rawBytes = job->result->size;
+
+	metrics_count (METRIC_UPDATE_JOBS, 1);
+	metrics_count (METRIC_UPDATE_BYTES, job->result->size);
+
 	/* Handling abandoned requests (e.g. after feed deletion) */
 	if (job->callback == NULL) {	
 		debug1 (DEBUG_UPDATE, "freeing cancelled request (%s)", job->request->source);
@@ -631,6 +750,17 @@ update_init (void)
 	pendingHighPrioJobs = g_async_queue_new ();
 }
 
+void
+update_get_job_counts (guint *queued, guint *active)
+{
+	*queued = 0;
+	if (pendingJobs)
+		*queued += g_async_queue_length (pendingJobs);
+	if (pendingHighPrioJobs)
+		*queued += g_async_queue_length (pendingHighPrioJobs);
+	*active = numberOfActiveJobs;
+}
+
 void
 update_deinit (void)
 {
@@ -648,4 +778,11 @@ update_deinit (void)
 	
 	g_slist_free (jobs);
 	jobs = NULL;
+
+	if (stylesheets) {
+		g_hash_table_destroy (stylesheets);
+		stylesheets = NULL;
+	}
+
+	filter_deinit ();
 }
@@ -24,6 +24,7 @@
 
 #include <time.h>
 #include <glib.h>
+#include <libxml/tree.h>
 
 /* Update requests do represent feed updates, favicon and enclosure 
    downloads. A request can be started synchronously or asynchronously.
@@ -96,6 +97,21 @@ typedef struct updateRequest {
 	updateStatePtr	updateState;	/**< Update state of the requested object (etags, last modified...) */
 } *updateRequestPtr;
 
+/** durations (in microseconds) and sizes of the steps of an update job */
+typedef struct updateTimings {
+	gint64		timestamp;	/**< wall clock time the job was created (in microseconds) */
+	gint64		queued;		/**< monotonic time the job was queued */
+	gint64		started;	/**< monotonic time the job was dequeued */
+	guint64		queueWait;	/**< time waiting for a free download slot */
+	guint64		download;	/**< time to download or read the source */
+	guint64		filter;		/**< time to run the filter command or stylesheet */
+	guint64		parse;		/**< time to parse the document */
+	guint64		merge;		/**< time to merge the parsed items */
+	guint64		dbWrite;	/**< time until all resulting DB updates were committed */
+	guint64		rawBytes;	/**< bytes transferred (before content decoding) */
+	guint64		decodedBytes;	/**< bytes after content decoding */
+} *updateTimingsPtr;
+
 /** structure to store results of the processing of an update request */
 typedef struct updateResult {
 	gchar 		*source;	/**< Location of the downloaded document, in case of redirects different from 
@@ -105,10 +121,12 @@ typedef struct updateResult {
 	int		httpstatus;	/**< HTTP status. Set to 200 for any valid command, file access, etc.... Set to 0 for unknown */
 	gchar		*data;		/**< Downloaded data */
 	size_t		size;		/**< Size of downloaded data */
+	xmlDocPtr	doc;		/**< Result document of an XSLT filter (or NULL), data then stays unfiltered */
 	gchar		*contentType;	/**< Content type of received data */
 	gchar		*filterErrors;	/**< Error messages from filter execution */
 	
 	updateStatePtr	updateState;	/**< New update state of the requested object (etags, last modified...) */
+	updateTimingsPtr timings;	/**< Step durations up to the result processing */
 } *updateResultPtr;
 
 /** structure describing an HTTP update job */
@@ -166,6 +184,15 @@ updateOptionsPtr update_options_copy (updateOptionsPtr options);
  */
 void update_options_free (updateOptionsPtr options);
 
+/**
+ * Returns the sum of all step durations of the given timings.
+ *
+ * @param timings	the update timings
+ *
+ * @returns total duration in microseconds
+ */
+guint64 update_timings_get_total (updateTimingsPtr timings);
+
 /**
  * Initialises the download subsystem. 
  *
@@ -179,6 +206,14 @@ void update_init (void);
  */
 void update_deinit (void);
 
+/**
+ * Returns the number of queued and currently processed update jobs.
+ *
+ * @param queued	returns the number of queued jobs
+ * @param active	returns the number of active jobs
+ */
+void update_get_job_counts (guint *queued, guint *active);
+
 /** 
  * Creates a new request structure.
  *
@@ -43,9 +43,7 @@ vfolder_new (nodePtr node)
 	debug_enter ("vfolder_new");
 
 	vfolder = g_new0 (struct vfolder, 1);
-	vfolder->itemset = g_new0 (struct itemSet, 1);
-	vfolder->itemset->nodeId = node->id;
-	vfolder->itemset->ids = NULL;
+	vfolder->itemset = itemset_new (node->id);
 	vfolder->itemset->anyMatch = TRUE;
 	vfolder->node = node;
 	vfolders = g_slist_append (vfolders, vfolder);
@@ -126,36 +124,25 @@ vfolder_foreach (nodeActionFunc func)
 	}	
 }
 
-GSList *
-vfolder_get_all_with_item_id (itemPtr item)
+void
+vfolder_check_item (itemPtr item, guint changed, GSList **matching, GSList **notMatching)
 {
-	GSList	*result = NULL;
-	GSList	*iter = vfolders;
-	
-	while (iter) {
-		vfolderPtr vfolder = (vfolderPtr)iter->data;
-		if (itemset_check_item (vfolder->itemset, item))
-			result = g_slist_append (result, vfolder);
-		iter = g_slist_next (iter);
-	}
+	GSList	*iter;
 
-	return result;
-}
+	*matching = NULL;
+	*notMatching = NULL;
 
-GSList *
-vfolder_get_all_without_item_id (itemPtr item)
-{
-	GSList	*result = NULL;
-	GSList	*iter = vfolders;
-	
-	while (iter) {
+	for (iter = vfolders; iter; iter = g_slist_next (iter)) {
 		vfolderPtr vfolder = (vfolderPtr)iter->data;
-		if (!itemset_check_item (vfolder->itemset, item))
-			result = g_slist_append (result, vfolder);
-		iter = g_slist_next (iter);
-	}
 
-	return result;
+		if (!(itemset_get_rule_depends (vfolder->itemset) & changed))
+			continue;
+
+		if (itemset_check_item (vfolder->itemset, item))
+			*matching = g_slist_prepend (*matching, vfolder);
+		else
+			*notMatching = g_slist_prepend (*notMatching, vfolder);
+	}
 }
 
 static void
@@ -219,8 +206,7 @@ vfolder_reset (vfolderPtr vfolder)
 {
 	itemlist_unload (FALSE);
 
-	g_list_free (vfolder->itemset->ids);
-	vfolder->itemset->ids = NULL;
+	g_array_set_size (vfolder->itemset->ids, 0);
 	db_search_folder_reset (vfolder->node->id);
 }
 
@@ -253,12 +239,8 @@ static void vfolder_save (nodePtr node) { }
 static void
 vfolder_update_counters (nodePtr node) 
 {
-	/* There is no unread handling for search folders
-	   for performance reasons. So set everything to 0 
-	   here and don't bother with GUI updates... */
 	node->needsUpdate = TRUE;
-	node->unreadCount = 0;
-	node->itemCount = db_search_folder_get_item_count (node->id);
+	db_search_folder_get_counts (node->id, &node->itemCount, &node->unreadCount);
 }
 
 static void
@@ -290,6 +272,7 @@ vfolder_get_node_type (void)
 { 
 	static struct nodeType nti = {
 		NODE_CAPABILITY_SHOW_ITEM_FAVICONS |
+		NODE_CAPABILITY_SHOW_UNREAD_COUNT |
 		NODE_CAPABILITY_SHOW_ITEM_COUNT,
 		"vfolder",
 		NULL,
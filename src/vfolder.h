@@ -42,7 +42,6 @@ typedef struct vfolder {
 	itemSetPtr	itemset;	/**< the itemset with the rules and matching items */
 
 	gboolean	reloading;	/**< if the search folder is in async reloading */
-	gulong		loadOffset;	/**< when in reloading: current offset */
 } *vfolderPtr;
 
 /**
@@ -64,22 +63,19 @@ void vfolder_foreach (nodeActionFunc func);
 typedef void 	(*vfolderActionDataFunc)	(vfolderPtr vfolder, itemPtr item);
 
 /**
- * Returns a list of all search folders currently matching the given item.
+ * Checks the given item against all search folders whose rules
+ * depend on at least one of the given item properties. Search
+ * folders not depending on them are put in neither list, as
+ * their membership cannot have changed.
  *
  * @param item		the item
+ * @param changed	ruleDepends flags of the changed item properties
+ * @param matching	returns the search folders matching the item
+ * @param notMatching	returns the search folders not matching the item
  *
- * @returns a list of vfolderPtr (to be free'd using g_slist_free())
+ * Both lists are to be free'd using g_slist_free().
  */
-GSList * vfolder_get_all_with_item_id (itemPtr item);
-
-/**
- * Returns a list of all search folders currently not matching the given item.
- *
- * @param item		the item
- *
- * @returns a list of vfolderPtr (to be free'd using g_slist_free())
- */
-GSList * vfolder_get_all_without_item_id (itemPtr item);
+void vfolder_check_item (itemPtr item, guint changed, GSList **matching, GSList **notMatching);
 
 /**
  * Resets vfolder state. Drops all items from it.
@@ -27,49 +27,125 @@
 #include "vfolder.h"
 #include "ui/feed_list_node.h"
 
-#define VFOLDER_LOADER_BATCH_SIZE 	100
+/* Search folder loading runs on worker threads each using its own
+   read-only DB connection. The item id range is split into batches
+   which are matched in parallel. Matching items are passed back to
+   the main loop batch by batch. Note that rule checks run on the
+   worker threads and therefore must not modify any state. Rules
+   depending on the feed list get a copy of it before the workers
+   are started. */
+
+#define VFOLDER_LOADER_BATCH_SIZE 	1000	/* item ids per batch */
+
+typedef struct vfolderLoaderCtxt {
+	ItemLoader	*loader;
+	vfolderPtr	vfolder;
+	itemSetPtr	rules;		/**< copy of the search folder rules for the workers */
+	guint		pending;	/**< number of batches not yet passed back */
+} *vfolderLoaderCtxtPtr;
+
+typedef struct vfolderLoaderBatch {
+	vfolderLoaderCtxtPtr	ctxt;
+	gulong			first;		/**< first item id */
+	gulong			last;		/**< last item id */
+	GSList			*items;		/**< matching items */
+} *vfolderLoaderBatchPtr;
+
+static GThreadPool *pool = NULL;
 
 static gboolean
-vfolder_loader_fetch_cb (gpointer user_data, GSList **resultItems)
+vfolder_loader_batch_done (gpointer user_data)
 {
-	vfolderPtr	vfolder = (vfolderPtr)user_data;
-	itemSetPtr	items = g_new0 (struct itemSet, 1);
-	GList		*iter;
-	gboolean	result;
-
-	/* 1. Fetch a batch of items */
-	result = db_itemset_get (items, vfolder->loadOffset, VFOLDER_LOADER_BATCH_SIZE);
-	vfolder->loadOffset += VFOLDER_LOADER_BATCH_SIZE;
-
-	if (result) {
-		/* 2. Match all items against search folder */
-		iter = items->ids;
-		while (iter) {
-			gulong id = GPOINTER_TO_UINT (iter->data);
-
-			itemPtr	item = db_item_load (id);
-			if (itemset_check_item (vfolder->itemset, item))
-				*resultItems = g_slist_append (*resultItems, item);
-			else
-				item_unload (item);
-
-			iter = g_list_next (iter);
-		}
-	} else {
+	vfolderLoaderBatchPtr	batch = (vfolderLoaderBatchPtr)user_data;
+	vfolderLoaderCtxtPtr	ctxt = batch->ctxt;
+	vfolderPtr		vfolder = ctxt->vfolder;
+
+	/* Save items to DB and update UI (except for search results) */
+	if (batch->items && vfolder->node) {
+		db_search_folder_add_items (vfolder->node->id, batch->items);
+		node_update_counters (vfolder->node);
+		feed_list_node_update (vfolder->node->id);
+	}
+
+	if (batch->items)
+		item_loader_add_items (ctxt->loader, batch->items);
+	g_free (batch);
+
+	if (0 == --ctxt->pending) {
 		debug1 (DEBUG_CACHE, "search folder '%s' reload complete", vfolder->node->title);
 		vfolder->reloading = FALSE;
+		item_loader_finish (ctxt->loader);
+
+		g_object_unref (ctxt->loader);
+		itemset_free (ctxt->rules);
+		g_free (ctxt);
 	}
 
-	itemset_free (items);
+	return FALSE;
+}
 
-	/* 3. Save items to DB and update UI (except for search results) */
-	if (vfolder->node) {
-		db_search_folder_add_items (vfolder->node->id, *resultItems);
-		node_update_counters (vfolder->node);
-		feed_list_node_update (vfolder->node->id);
+static void
+vfolder_loader_batch_run (gpointer data, gpointer user_data)
+{
+	vfolderLoaderBatchPtr	batch = (vfolderLoaderBatchPtr)data;
+	GSList			*items, *iter;
+
+	debug_span_begin ("search folder batch");
+	debug_span_arg_int ("first", batch->first);
+	debug_span_arg_int ("last", batch->last);
+	items = db_reader_items_load (batch->first, batch->last);
+	for (iter = items; iter; iter = g_slist_next (iter)) {
+		itemPtr item = (itemPtr)iter->data;
+
+		if (itemset_check_item (batch->ctxt->rules, item))
+			batch->items = g_slist_append (batch->items, item);
+		else
+			item_unload (item);
 	}
+	g_slist_free (items);
+	debug_span_end ();
+
+	g_idle_add (vfolder_loader_batch_done, batch);
+}
+
+static void
+vfolder_loader_start (ItemLoader *il, gpointer user_data)
+{
+	vfolderPtr		vfolder = (vfolderPtr)user_data;
+	vfolderLoaderCtxtPtr	ctxt;
+	GSList			*iter;
+	gulong			first, max;
+
+	if (!pool)
+		pool = g_thread_pool_new (vfolder_loader_batch_run, NULL, g_get_num_processors (), FALSE, NULL);
+
+	ctxt = g_new0 (struct vfolderLoaderCtxt, 1);
+	ctxt->loader = g_object_ref (il);
+	ctxt->vfolder = vfolder;
+	ctxt->rules = itemset_new (NULL);
+	ctxt->rules->anyMatch = vfolder->itemset->anyMatch;
+	for (iter = vfolder->itemset->rules; iter; iter = g_slist_next (iter)) {
+		rulePtr rule = (rulePtr)iter->data;
+		itemset_add_rule (ctxt->rules, rule->ruleInfo->ruleId, rule->value, rule->additive);
+	}
+	g_slist_foreach (ctxt->rules->rules, (GFunc)rule_copy_feed_state, NULL);
+
+	/* Always queue at least one batch so that the loader finishes */
+	max = db_item_get_max_id ();
+	first = 0;
+	do {
+		vfolderLoaderBatchPtr batch = g_new0 (struct vfolderLoaderBatch, 1);
+
+		batch->ctxt = ctxt;
+		batch->first = first;
+		batch->last = first + VFOLDER_LOADER_BATCH_SIZE - 1;
+		ctxt->pending++;
+		g_thread_pool_push (pool, batch, NULL);
+
+		first += VFOLDER_LOADER_BATCH_SIZE;
+	} while (first <= max);
 
-	return result;	/* FALSE on last fetch */
+	debug2 (DEBUG_CACHE, "search folder '%s' reload started with %u batches", vfolder->node->title, ctxt->pending);
 }
 
 ItemLoader *
@@ -85,7 +161,6 @@ vfolder_loader_new (nodePtr node)
 	debug1 (DEBUG_CACHE, "search folder '%s' reload started", node->title);
 	vfolder_reset (vfolder);
 	vfolder->reloading = TRUE;
-	vfolder->loadOffset = 0;
 
-        return item_loader_new (vfolder_loader_fetch_cb, node, vfolder);
+        return item_loader_new_async (vfolder_loader_start, node, vfolder);
 }
@@ -525,7 +525,10 @@ xml_parse (gchar *data, size_t length, errorCtxtPtr errCtx)
 	if (errCtx)
 		xmlSetGenericErrorFunc (errCtx, (xmlGenericErrorFunc)xml_buffer_parse_error);
 	
-	doc = xmlSAXParseMemory (ctxt->sax, data, length, 0);
+	/* Reading with the context (unlike xmlSAXParseMemory()) interns
+	   all element names in the document dictionary, which the feed
+	   parsers rely on to dispatch elements by name pointer. */
+	doc = xmlCtxtReadMemory (ctxt, data, length, NULL, NULL, 0);
 	
 	/* This seems to reset the errorfunc to its default, so that the
 	   GtkHTML2 module is not unhappy because it also tries to call the
@@ -544,6 +547,12 @@ xml_parse_feed (feedParserCtxtPtr fpc)
 		
 	g_assert (NULL != fpc->data);
 	g_assert (NULL != fpc->feed);
+
+	/* XSLT filter results come already parsed */
+	if (fpc->doc) {
+		fpc->feed->valid = TRUE;
+		return fpc->doc;
+	}
 	
 	fpc->feed->valid = FALSE;
 	
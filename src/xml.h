@@ -190,7 +190,8 @@ xmlDocPtr xml_parse (gchar *data, size_t length, errorCtxtPtr errors);
  * The function returns a XML document pointer or NULL
  * if the document could not be read. It also sets 
  * errormsg to the last error messages on parsing
- * errors. 
+ * errors. A document already set by an XSLT filter
+ * is returned as is.
  *
  * @param fpc	feed parsing context with valid data
  *